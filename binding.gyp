@@ -5,7 +5,17 @@
             "sources": [
                 "lib/common.cpp",
                 "lib/binding.cpp", 
-                "lib/session.cpp"
+                "lib/batch.cpp",
+                "lib/checksum.cpp",
+                "lib/dedupe.cpp",
+                "lib/dns.cpp",
+                "lib/flows.cpp",
+                "lib/fragments.cpp",
+                "lib/matcher.cpp",
+                "lib/parser.cpp",
+                "lib/pool.cpp",
+                "lib/session.cpp",
+                "lib/streams.cpp"
             ],
             "conditions": [
                 ["OS=='win'", {
@@ -0,0 +1,80 @@
+#include "batch.h"
+
+#include <cstring>
+
+PacketBatch::PacketBatch() {
+    timestamps = nullptr;
+    flowHash = nullptr;
+    saddr = nullptr;
+    daddr = nullptr;
+    lengths = nullptr;
+    offsets = nullptr;
+    sport = nullptr;
+    dport = nullptr;
+    protocol = nullptr;
+    tcpFlags = nullptr;
+
+    data = nullptr;
+    dataLength = 0;
+
+    capacity = 0;
+    count = 0;
+}
+
+void PacketBatch::Configure(uint8_t* columns, uint32_t capacity, uint8_t* data, size_t dataLength) {
+    size_t n = capacity;
+
+    timestamps = reinterpret_cast<double*>(columns);
+    flowHash = reinterpret_cast<uint64_t*>(columns + n * 8);
+    saddr = reinterpret_cast<uint32_t*>(columns + n * 16);
+    daddr = reinterpret_cast<uint32_t*>(columns + n * 20);
+    lengths = reinterpret_cast<uint32_t*>(columns + n * 24);
+    offsets = reinterpret_cast<uint32_t*>(columns + n * 28);
+    sport = reinterpret_cast<uint16_t*>(columns + n * 32 + 4);
+    dport = reinterpret_cast<uint16_t*>(columns + n * 34 + 4);
+    protocol = columns + n * 36 + 4;
+    tcpFlags = columns + n * 37 + 4;
+
+    this->data = data;
+    this->dataLength = dataLength;
+    this->capacity = capacity;
+
+    Clear();
+}
+
+void PacketBatch::Add(const struct pcap_pkthdr* header, const u_char* packet, uint32_t length, const PacketMeta& meta) {
+    uint32_t offset = offsets[count];
+
+    if (length > dataLength - offset)
+        length = static_cast<uint32_t>(dataLength - offset);
+
+    timestamps[count] = header->ts.tv_sec + header->ts.tv_usec / 1000000.0;
+    flowHash[count] = meta.flowHash;
+    lengths[count] = header->len;
+
+    // Only IPv4 addresses fit in the columns, as numbers (`a.b.c.d` => `a << 24 | ... | d`).
+    if (meta.ipVersion == 4) {
+        saddr[count] = (static_cast<uint32_t>(meta.saddr[0]) << 24) | (meta.saddr[1] << 16) | (meta.saddr[2] << 8) | meta.saddr[3];
+        daddr[count] = (static_cast<uint32_t>(meta.daddr[0]) << 24) | (meta.daddr[1] << 16) | (meta.daddr[2] << 8) | meta.daddr[3];
+    } else {
+        saddr[count] = 0;
+        daddr[count] = 0;
+    }
+
+    sport[count] = meta.sport;
+    dport[count] = meta.dport;
+    protocol[count] = meta.protocol;
+    tcpFlags[count] = meta.tcpFlags;
+
+    memcpy(data + offset, packet, length);
+
+    count++;
+    offsets[count] = offset + length;
+}
+
+void PacketBatch::Clear() {
+    count = 0;
+
+    if (offsets != nullptr)
+        offsets[0] = 0;
+}
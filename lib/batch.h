@@ -0,0 +1,61 @@
+#ifndef NPCAP_BATCH_H
+#define NPCAP_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include "parser.h"
+
+// Bytes needed by the columns of a batch of `capacity` packets.
+#define BATCH_COLUMNS_SIZE(capacity) (static_cast<size_t>(capacity) * 38 + 4)
+
+/**
+ * Packets accumulated natively and delivered to JS at once, as a struct-of-arrays.
+ *
+ * The columns are laid out over a single buffer shared with JS (see `src/batch.ts`),
+ * from the widest type to the narrowest so every column stays aligned:
+ *
+ *   f64 timestamps[n], u64 flowHash[n], u32 saddr[n], u32 daddr[n], u32 lengths[n], u32 offsets[n + 1],
+ *   u16 sport[n], u16 dport[n], u8 protocol[n], u8 tcpFlags[n]
+ *
+ * The captured bytes are appended to `data`, the packet `i` spans `offsets[i]..offsets[i + 1]`.
+*/
+class PacketBatch {
+    public:
+        PacketBatch();
+
+        void Configure(uint8_t* columns, uint32_t capacity, uint8_t* data, size_t dataLength);
+        bool Enabled() const { return capacity > 0; }
+
+        bool Empty() const { return count == 0; }
+        bool Full() const { return count == capacity; }
+
+        // Whether `length` captured bytes still fit in `data`.
+        bool Fits(uint32_t length) const { return dataLength - offsets[count] >= length; }
+
+        // Appends the packet, truncated to the room left in `data`.
+        void Add(const struct pcap_pkthdr* header, const u_char* packet, uint32_t length, const PacketMeta& meta);
+
+        void Clear();
+
+        uint32_t Count() const { return count; }
+
+    private:
+        double* timestamps;
+        uint64_t* flowHash;
+        uint32_t* saddr;
+        uint32_t* daddr;
+        uint32_t* lengths;
+        uint32_t* offsets;
+        uint16_t* sport;
+        uint16_t* dport;
+        uint8_t* protocol;
+        uint8_t* tcpFlags;
+
+        uint8_t* data;
+        size_t dataLength;
+
+        uint32_t capacity;
+        uint32_t count;
+};
+
+#endif
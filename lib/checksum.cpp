@@ -0,0 +1,219 @@
+#include "checksum.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CHECKSUM_SIMD
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// The checksum is computed in blocks so the 32-bit SIMD lanes can't overflow.
+#define CHECKSUM_BLOCK 65536
+
+static inline uint16_t Read16(const u_char* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+static inline uint16_t Fold(uint64_t sum) {
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return static_cast<uint16_t>(sum);
+}
+
+static uint16_t SumScalar(const uint8_t* data, size_t length) {
+    uint64_t sum = 0;
+    size_t i = 0;
+
+    for (; i + 1 < length; i += 2)
+        sum += Read16(data + i);
+
+    // An odd trailing byte is padded with zero.
+    if (i < length)
+        sum += data[i] << 8;
+
+    return Fold(sum);
+}
+
+#if defined(CHECKSUM_SIMD)
+// The lanes accumulate little-endian words, byte swapping the folded
+// sum gives the big-endian one (RFC 1071, byte order independence).
+static inline uint16_t Swap16(uint16_t value) {
+    return static_cast<uint16_t>((value >> 8) | (value << 8));
+}
+
+static uint16_t SumSSE2(const uint8_t* data, size_t length) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+        acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(words, zero));
+        acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(words, zero));
+    }
+
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+
+    uint64_t sum = static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+
+    return Fold(static_cast<uint64_t>(Swap16(Fold(sum))) + SumScalar(data + i, length - i));
+}
+
+TARGET_AVX2 static uint16_t SumAVX2(const uint8_t* data, size_t length) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+        acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(words, zero));
+        acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(words, zero));
+    }
+
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+
+    uint64_t sum = 0;
+    for (int lane = 0; lane < 8; lane++)
+        sum += lanes[lane];
+
+    return Fold(static_cast<uint64_t>(Swap16(Fold(sum))) + SumSSE2(data + i, length - i));
+}
+
+static bool SupportsAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The OS must save the AVX registers (OSXSAVE + AVX, XCR0 SSE & AVX state).
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+typedef uint16_t (*SumFunction)(const uint8_t* data, size_t length);
+
+static const SumFunction Sum = SupportsAVX2() ? SumAVX2 : SumSSE2;
+#else
+#define Sum SumScalar
+#endif
+
+uint16_t ChecksumAdd(const uint8_t* data, size_t length, uint32_t sum) {
+    uint64_t total = sum;
+
+    // Blocks have an even length, so the words stay aligned.
+    while (length > CHECKSUM_BLOCK) {
+        total += Sum(data, CHECKSUM_BLOCK);
+        data += CHECKSUM_BLOCK;
+        length -= CHECKSUM_BLOCK;
+    }
+
+    return Fold(total + Sum(data, length));
+}
+
+// https://en.wikipedia.org/wiki/Transmission_Control_Protocol#TCP_checksum_for_IPv4
+static uint32_t PseudoHeaderSum(const PacketMeta& meta, uint32_t length) {
+    uint32_t addressLength = meta.ipVersion == 4 ? 4 : 16;
+    uint32_t sum = ChecksumAdd(meta.saddr, addressLength, 0);
+
+    sum = ChecksumAdd(meta.daddr, addressLength, sum);
+    sum += meta.protocol;
+    sum += (length >> 16) + (length & 0xFFFF);
+
+    return Fold(sum);
+}
+
+void VerifyChecksums(int linkType, const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    // Packets sent by this host are captured before the NIC fills the checksums.
+    bool loopback;
+    if (GetPacketDirection(linkType, packet, caplen, loopback) == DIRECTION_OUT) {
+        meta.flags |= META_CHECKSUM_OFFLOAD;
+        return;
+    }
+
+    if (meta.ipVersion == 4) {
+        uint32_t offset = meta.l3Offset;
+        uint32_t headerLength = meta.l4Offset - offset;
+
+        if (caplen < offset + headerLength)
+            return;
+
+        // IPv4 header checksum offload leaves the field empty.
+        if (Read16(packet + offset + 10) == 0)
+            meta.flags |= META_CHECKSUM_OFFLOAD;
+        else if (ChecksumAdd(packet + offset, headerLength, 0) != 0xFFFF)
+            meta.flags |= META_IP_CHECKSUM_BAD;
+    }
+
+    // Only whole (not fragmented, not truncated) segments can be verified.
+    if (!(meta.flags & META_PARSED) || (meta.flags & META_FRAGMENT))
+        return;
+
+    uint32_t offset = meta.l4Offset;
+    uint32_t length = meta.payloadOffset - offset + meta.payloadLength;
+
+    if (caplen < offset + length)
+        return;
+
+    uint32_t sum;
+    uint32_t checksumOffset;
+
+    switch (meta.protocol) {
+        case 6: // TCP
+            checksumOffset = 16;
+            sum = PseudoHeaderSum(meta, length);
+            break;
+        case 17: // UDP
+            checksumOffset = 6;
+
+            // The checksum is optional over IPv4.
+            if (meta.ipVersion == 4 && Read16(packet + offset + 6) == 0)
+                return;
+
+            sum = PseudoHeaderSum(meta, length);
+            break;
+        case 1: // ICMP
+            checksumOffset = 2;
+            sum = 0;
+            break;
+        case 58: // ICMPv6
+            checksumOffset = 2;
+            sum = PseudoHeaderSum(meta, length);
+            break;
+        default:
+            return;
+    }
+
+    if (length < checksumOffset + 2)
+        return;
+
+    if (ChecksumAdd(packet + offset, length, sum) == 0xFFFF)
+        return;
+
+    // With partial offload the stack only stores the pseudo-header sum, the NIC adds the rest.
+    if (meta.protocol != 1 && Read16(packet + offset + checksumOffset) == sum) {
+        meta.flags |= META_CHECKSUM_OFFLOAD;
+        return;
+    }
+
+    meta.flags |= META_L4_CHECKSUM_BAD;
+}
@@ -0,0 +1,24 @@
+#ifndef NPCAP_CHECKSUM_H
+#define NPCAP_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include "parser.h"
+
+/**
+ * @brief Adds `data` (as big-endian 16-bit words) to the one's complement `sum`.
+ *
+ * The sum is folded to 16 bits, a valid checksum adds up to `0xFFFF`.
+ * Uses AVX2 or SSE2 when the CPU supports them.
+*/
+uint16_t ChecksumAdd(const uint8_t* data, size_t length, uint32_t sum);
+
+/**
+ * @brief Verifies the IPv4 header and the TCP / UDP / ICMP checksums of a parsed packet.
+ *
+ * Sets `META_IP_CHECKSUM_BAD` / `META_L4_CHECKSUM_BAD` on mismatch. Checksums left to the
+ * NIC (offload) are not reported as bad but flagged with `META_CHECKSUM_OFFLOAD`.
+*/
+void VerifyChecksums(int linkType, const u_char* packet, uint32_t caplen, PacketMeta& meta);
+
+#endif
@@ -0,0 +1,63 @@
+#include "dedupe.h"
+#include "hash.h"
+
+#define PROBES 8
+
+DuplicateFilter::DuplicateFilter() {
+    mask = 0;
+    seed = HASH_PRIME_1;
+    window = 0;
+    suppressed = 0;
+}
+
+void DuplicateFilter::Configure(uint64_t window, uint32_t size) {
+    // Round the size up to a power of two.
+    uint64_t capacity = PROBES;
+    while (capacity < size)
+        capacity <<= 1;
+
+    entries.assign(size > 0 ? capacity : 0, { 0, 0 });
+    mask = capacity - 1;
+
+    this->window = window;
+    suppressed = 0;
+}
+
+bool DuplicateFilter::IsDuplicate(const u_char* packet, uint32_t caplen, const PacketMeta& meta, uint64_t timestamp) {
+    uint64_t hash = seed;
+    uint32_t offset = meta.l3Offset;
+
+    if (meta.etherType == ETHERTYPE_IPV4 && caplen >= offset + 20) {
+        // Skip the TTL (8) and the header checksum (10, 11).
+        hash = HashBytes(hash, packet + offset, 8);
+        hash = HashBytes(hash, packet + offset + 9, 1);
+        hash = HashBytes(hash, packet + offset + 12, caplen - offset - 12);
+    } else if (meta.etherType == ETHERTYPE_IPV6 && caplen >= offset + 40) {
+        // Skip the hop limit (7).
+        hash = HashBytes(hash, packet + offset, 7);
+        hash = HashBytes(hash, packet + offset + 8, caplen - offset - 8);
+    } else {
+        hash = HashBytes(hash, packet, caplen);
+    }
+
+    hash = HashFinalize(hash);
+
+    Entry* oldest = nullptr;
+    for (uint64_t i = 0; i < PROBES; i++) {
+        Entry& entry = entries[(hash + i) & mask];
+        uint64_t age = timestamp > entry.timestamp ? timestamp - entry.timestamp : entry.timestamp - timestamp;
+
+        if (entry.hash == hash && age <= window) {
+            suppressed++;
+            return true;
+        }
+
+        if (oldest == nullptr || entry.timestamp < oldest->timestamp)
+            oldest = &entry;
+    }
+
+    oldest->hash = hash;
+    oldest->timestamp = timestamp;
+
+    return false;
+}
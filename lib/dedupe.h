@@ -0,0 +1,46 @@
+#ifndef NPCAP_DEDUPE_H
+#define NPCAP_DEDUPE_H
+
+#include <cstdint>
+#include <vector>
+#include "parser.h"
+
+/**
+ * Drops the packets seen twice within a short window, like the copies delivered by
+ * a SPAN port mirroring both the ingress and the egress of a switch.
+ *
+ * Only the invariant parts of the packet are hashed: the link-layer header, the
+ * TTL / hop limit and the IPv4 header checksum may differ between both copies.
+*/
+class DuplicateFilter {
+    public:
+        DuplicateFilter();
+
+        void Configure(uint64_t window, uint32_t size);
+
+        // Keys the hash of the packets.
+        void Seed(uint64_t seed) { this->seed = seed; }
+        bool Enabled() const { return !entries.empty(); }
+
+        bool IsDuplicate(const u_char* packet, uint32_t caplen, const PacketMeta& meta, uint64_t timestamp);
+
+        uint64_t Suppressed() const { return suppressed; }
+
+    private:
+        struct Entry {
+            uint64_t hash;
+            uint64_t timestamp;
+        };
+
+        // Open addressing, a lookup probes at most `PROBES` slots.
+        std::vector<Entry> entries;
+        uint64_t mask;
+        uint64_t seed;
+
+        // In microseconds.
+        uint64_t window;
+
+        uint64_t suppressed;
+};
+
+#endif
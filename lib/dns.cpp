@@ -0,0 +1,181 @@
+#include "dns.h"
+
+#include <cstring>
+
+// Names interned per message at most: the question plus the name and target of each answer.
+#define NAMES_PER_MESSAGE (1 + 2 * DNS_MAX_ANSWERS)
+
+static inline uint16_t Read16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+static inline uint32_t Read32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+NameTable::NameTable() {
+    delivered = 0;
+    maxNames = 0;
+}
+
+void NameTable::Configure(size_t maxNames) {
+    this->maxNames = maxNames < NAMES_PER_MESSAGE ? NAMES_PER_MESSAGE : maxNames;
+
+    names.clear();
+    ids.clear();
+    delivered = 0;
+}
+
+void NameTable::Reserve() {
+    if (names.size() + NAMES_PER_MESSAGE <= maxNames)
+        return;
+
+    names.clear();
+    ids.clear();
+    delivered = 0;
+}
+
+uint32_t NameTable::Intern(const char* name, size_t length) {
+    // Reuse the lookup key, so known names don't allocate.
+    lookup.assign(name, length);
+
+    auto it = ids.find(lookup);
+    if (it != ids.end())
+        return it->second;
+
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(lookup);
+    ids.emplace(lookup, id);
+
+    return id;
+}
+
+// https://datatracker.ietf.org/doc/html/rfc1035#section-4.1.4
+static bool ReadName(const uint8_t* data, size_t length, size_t& offset, char* name, size_t& nameLength) {
+    size_t position = offset;
+    size_t lowest = offset;
+    bool jumped = false;
+
+    nameLength = 0;
+
+    for (;;) {
+        if (position >= length)
+            return false;
+
+        uint8_t label = data[position];
+
+        if (label == 0) {
+            if (!jumped)
+                offset = position + 1;
+
+            return true;
+        }
+
+        if ((label & 0xC0) == 0xC0) {
+            if (position + 1 >= length)
+                return false;
+
+            size_t pointer = ((label & 0x3F) << 8) | data[position + 1];
+
+            // Only backward pointers, so the name always ends.
+            if (pointer >= lowest)
+                return false;
+
+            if (!jumped)
+                offset = position + 2;
+
+            jumped = true;
+            lowest = pointer;
+            position = pointer;
+            continue;
+        }
+
+        if (label > 63 || position + 1 + label > length || nameLength + label + 1 > 255)
+            return false;
+
+        if (nameLength > 0)
+            name[nameLength++] = '.';
+
+        memcpy(name + nameLength, data + position + 1, label);
+        nameLength += label;
+        position += 1 + label;
+    }
+}
+
+bool ParseDns(const uint8_t* data, size_t length, DnsRecord& record, NameTable& names) {
+    record.questionName = DNS_NO_NAME;
+    record.questionType = 0;
+    record.questionClass = 0;
+    record.answerCount = 0;
+    record.status = DNS_MALFORMED;
+
+    if (length < 12)
+        return false;
+
+    record.id = Read16(data);
+    record.flags = Read16(data + 2);
+
+    uint16_t questions = Read16(data + 4);
+    uint16_t answers = Read16(data + 6);
+
+    names.Reserve();
+
+    char name[256];
+    size_t nameLength;
+    size_t offset = 12;
+
+    for (uint16_t i = 0; i < questions; i++) {
+        if (!ReadName(data, length, offset, name, nameLength) || offset + 4 > length)
+            return false;
+
+        if (i == 0) {
+            record.questionName = names.Intern(name, nameLength);
+            record.questionType = Read16(data + offset);
+            record.questionClass = Read16(data + offset + 2);
+        }
+
+        offset += 4;
+    }
+
+    for (uint16_t i = 0; i < answers && record.answerCount < DNS_MAX_ANSWERS; i++) {
+        if (!ReadName(data, length, offset, name, nameLength) || offset + 10 > length)
+            return false;
+
+        uint16_t type = Read16(data + offset);
+        uint16_t rdLength = Read16(data + offset + 8);
+        size_t rdOffset = offset + 10;
+
+        if (rdOffset + rdLength > length)
+            return false;
+
+        offset = rdOffset + rdLength;
+
+        // A, AAAA and CNAME
+        if (!(type == 1 && rdLength == 4) && !(type == 28 && rdLength == 16) && type != 5)
+            continue;
+
+        DnsAnswer& answer = record.answers[record.answerCount];
+        memset(&answer, 0, sizeof(answer));
+
+        answer.name = names.Intern(name, nameLength);
+        answer.type = type;
+        answer.rclass = Read16(data + rdOffset - 8);
+        answer.ttl = Read32(data + rdOffset - 6);
+        answer.target = DNS_NO_NAME;
+
+        if (type == 5) {
+            size_t targetOffset = rdOffset;
+            if (!ReadName(data, rdOffset + rdLength, targetOffset, name, nameLength))
+                return false;
+
+            answer.target = names.Intern(name, nameLength);
+        } else {
+            memcpy(answer.address, data + rdOffset, rdLength);
+        }
+
+        record.answerCount++;
+    }
+
+    record.status = DNS_PARSED;
+    return true;
+}
@@ -0,0 +1,96 @@
+#ifndef NPCAP_DNS_H
+#define NPCAP_DNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define DNS_MAX_ANSWERS 16
+
+// No name (missing question, answer without CNAME target).
+#define DNS_NO_NAME 0xFFFFFFFF
+
+// DnsRecord::status
+#define DNS_NONE        0 // Not a DNS packet.
+#define DNS_PARSED      1
+#define DNS_MALFORMED   2 // Only the fields before the error are meaningful.
+
+struct DnsAnswer {
+    uint32_t name;
+    uint16_t type;
+    uint16_t rclass;
+    uint32_t ttl;
+
+    // Name id of the CNAME target.
+    uint32_t target;
+
+    // A (first 4 bytes) or AAAA address, in network byte order.
+    uint8_t address[16];
+};
+
+/**
+ * Fixed layout record describing a DNS message, shared with JS (see `src/dns.ts`).
+ *
+ * Names are delivered as ids of a `NameTable`. Only the first question and the A,
+ * AAAA and CNAME answers are decoded. Multi-byte fields use the host byte order.
+*/
+struct DnsRecord {
+    uint16_t id;
+    uint16_t flags;
+
+    uint16_t questionType;
+    uint16_t questionClass;
+    uint32_t questionName;
+
+    uint16_t answerCount;
+    uint8_t status;
+    uint8_t reserved;
+
+    DnsAnswer answers[DNS_MAX_ANSWERS];
+};
+
+static_assert(sizeof(DnsAnswer) == 32, "DnsRecord layout is shared with JS");
+static_assert(sizeof(DnsRecord) == 16 + 32 * DNS_MAX_ANSWERS, "DnsRecord layout is shared with JS");
+
+/**
+ * Interns the names, so each unique name is sent to JS once and then referred to by id.
+ *
+ * The table is cleared when full, ids restart from 0.
+*/
+class NameTable {
+    public:
+        NameTable();
+
+        void Configure(size_t maxNames);
+
+        // Clears the table if the names of one more message might not fit.
+        void Reserve();
+
+        uint32_t Intern(const char* name, size_t length);
+
+        // Names by id, the ones from `delivered` on haven't been sent to JS yet.
+        std::vector<std::string> names;
+        size_t delivered;
+
+    private:
+        std::unordered_map<std::string, uint32_t> ids;
+        std::string lookup;
+
+        size_t maxNames;
+};
+
+// Well known DNS ports (DNS, mDNS, LLMNR).
+static inline bool IsDnsPort(uint16_t port) {
+    return port == 53 || port == 5353 || port == 5355;
+}
+
+/**
+ * @brief Decodes the DNS message in `data` (UDP payload) into `record`.
+ *
+ * Compression pointers must point backwards, so malicious loops can't hang the parser.
+*/
+bool ParseDns(const uint8_t* data, size_t length, DnsRecord& record, NameTable& names);
+
+#endif
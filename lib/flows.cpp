@@ -0,0 +1,191 @@
+#include "flows.h"
+
+#include <cstdio>
+#include <cstring>
+
+static std::string FormatAddress(const uint8_t* addr, uint8_t ipVersion) {
+    char buffer[40];
+
+    if (ipVersion == 4) {
+        snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+    } else {
+        snprintf(
+            buffer, sizeof(buffer), "%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x",
+            addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7],
+            addr[8], addr[9], addr[10], addr[11], addr[12], addr[13], addr[14], addr[15]
+        );
+    }
+
+    return buffer;
+}
+
+bool FlowKey::operator==(const FlowKey& other) const {
+    return portA == other.portA
+        && portB == other.portB
+        && protocol == other.protocol
+        && ipVersion == other.ipVersion
+        && memcmp(addrA, other.addrA, sizeof(addrA)) == 0
+        && memcmp(addrB, other.addrB, sizeof(addrB)) == 0;
+}
+
+std::string FlowKey::AddressA() const {
+    return FormatAddress(addrA, ipVersion);
+}
+
+std::string FlowKey::AddressB() const {
+    return FormatAddress(addrB, ipVersion);
+}
+
+size_t FlowKeyHash::operator()(const FlowKey& key) const {
+    uint64_t hash = HashBytes(seed, key.addrA, sizeof(key.addrA));
+    hash = HashBytes(hash, key.addrB, sizeof(key.addrB));
+    hash = HashMix(hash, (static_cast<uint64_t>(key.portA) << 24) | (static_cast<uint64_t>(key.portB) << 8) | key.protocol);
+
+    return static_cast<size_t>(HashFinalize(hash));
+}
+
+bool GetFlowKey(const PacketMeta& meta, FlowKey& key, bool& fromA) {
+    if (meta.ipVersion != 4 && meta.ipVersion != 6)
+        return false;
+
+    size_t addrLength = meta.ipVersion == 4 ? 4 : 16;
+
+    memset(&key, 0, sizeof(key));
+    key.ipVersion = meta.ipVersion;
+    key.protocol = meta.protocol;
+
+    int order = memcmp(meta.saddr, meta.daddr, addrLength);
+    fromA = order < 0 || (order == 0 && meta.sport <= meta.dport);
+
+    memcpy(key.addrA, fromA ? meta.saddr : meta.daddr, addrLength);
+    memcpy(key.addrB, fromA ? meta.daddr : meta.saddr, addrLength);
+    key.portA = fromA ? meta.sport : meta.dport;
+    key.portB = fromA ? meta.dport : meta.sport;
+
+    return true;
+}
+
+FlowTable::FlowTable() {
+    byteLimit = 0;
+    packetLimit = 0;
+    timeout = 60;
+    maxFlows = 0;
+    lastExpire = 0;
+}
+
+void FlowTable::Configure(uint64_t byteLimit, uint64_t packetLimit, double timeout, size_t maxFlows) {
+    this->byteLimit = byteLimit;
+    this->packetLimit = packetLimit;
+    this->timeout = timeout;
+    this->maxFlows = maxFlows;
+
+    flows.clear();
+    closed.clear();
+    ended.clear();
+    lastExpire = 0;
+}
+
+bool FlowTable::Account(const PacketMeta& meta, double timestamp) {
+    FlowKey key;
+    bool fromA;
+
+    if (!GetFlowKey(meta, key, fromA))
+        return true;
+
+    // Sweep the idle flows at most once per second (of capture time).
+    if (timestamp - lastExpire >= 1) {
+        Expire(timestamp);
+        lastExpire = timestamp;
+    }
+
+    auto it = flows.find(key);
+    if (it == flows.end()) {
+        auto tombstone = closed.find(key);
+
+        if (tombstone != closed.end()) {
+            // The segments without data ending the closed connection (ACK of the last FIN, retransmitted FIN).
+            if (meta.protocol == 6 && !(meta.tcpFlags & TCP_SYN) && meta.payloadLength == 0)
+                return !tombstone->second.exhausted;
+
+            closed.erase(tombstone);
+        }
+
+        // Table full, the flow isn't tracked (nor cut).
+        if (flows.size() >= maxFlows)
+            return true;
+
+        FlowCounters counters = {};
+        counters.key = key;
+        counters.firstSeen = timestamp;
+
+        it = flows.emplace(key, counters).first;
+    }
+
+    FlowCounters& counters = it->second;
+    counters.lastSeen = timestamp;
+
+    bool deliver = (byteLimit == 0 || counters.bytes < byteLimit)
+        && (packetLimit == 0 || counters.packets < packetLimit);
+
+    if (deliver) {
+        counters.packets++;
+        counters.bytes += meta.payloadLength;
+    } else {
+        counters.cutoffPackets++;
+        counters.cutoffBytes += meta.payloadLength;
+    }
+
+    if (meta.protocol == 6) {
+        if (meta.tcpFlags & TCP_FIN)
+            counters.fins |= fromA ? 1 : 2;
+
+        if ((meta.tcpFlags & TCP_RST) || counters.fins == 3) {
+            bool exhausted = (byteLimit > 0 && counters.bytes >= byteLimit)
+                || (packetLimit > 0 && counters.packets >= packetLimit);
+
+            if (closed.size() < maxFlows)
+                closed[key] = { timestamp, exhausted };
+
+            End(counters);
+            flows.erase(it);
+        }
+    }
+
+    return deliver;
+}
+
+void FlowTable::Expire(double now) {
+    for (auto it = flows.begin(); it != flows.end();) {
+        if (now - it->second.lastSeen > timeout) {
+            End(it->second);
+            it = flows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = closed.begin(); it != closed.end();) {
+        if (now - it->second.closedAt > timeout)
+            it = closed.erase(it);
+        else
+            ++it;
+    }
+}
+
+void FlowTable::Flush() {
+    for (auto& entry : flows)
+        End(entry.second);
+
+    flows.clear();
+    closed.clear();
+}
+
+void FlowTable::Seed(uint64_t seed) {
+    flows = FlowMap(0, FlowKeyHash(seed));
+    closed = ClosedMap(0, FlowKeyHash(seed));
+}
+
+void FlowTable::End(const FlowCounters& counters) {
+    if (counters.cutoffPackets > 0)
+        ended.push_back(counters);
+}
@@ -0,0 +1,110 @@
+#ifndef NPCAP_FLOWS_H
+#define NPCAP_FLOWS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "hash.h"
+#include "parser.h"
+
+// Direction independent 5-tuple, the endpoint `a` is always the lowest (address, port).
+struct FlowKey {
+    uint8_t addrA[16];
+    uint8_t addrB[16];
+    uint16_t portA;
+    uint16_t portB;
+    uint8_t protocol;
+    uint8_t ipVersion;
+
+    bool operator==(const FlowKey& other) const;
+    std::string AddressA() const;
+    std::string AddressB() const;
+};
+
+struct FlowKeyHash {
+    uint64_t seed;
+
+    FlowKeyHash(uint64_t seed = HASH_PRIME_1): seed(seed) {}
+    size_t operator()(const FlowKey& key) const;
+};
+
+struct FlowCounters {
+    FlowKey key;
+
+    uint64_t packets;
+    uint64_t bytes;
+
+    // Packets and payload bytes seen after the flow reached its budget.
+    uint64_t cutoffPackets;
+    uint64_t cutoffBytes;
+
+    double firstSeen;
+    double lastSeen;
+
+    // Bit 0: `a` sent a FIN, bit 1: `b` sent a FIN.
+    uint8_t fins;
+};
+
+/**
+ * Tracks the packets and payload bytes of each flow, so only the first part of
+ * every connection is delivered ("time machine" style cutoff).
+*/
+class FlowTable {
+    public:
+        FlowTable();
+
+        void Configure(uint64_t byteLimit, uint64_t packetLimit, double timeout, size_t maxFlows);
+        bool Enabled() const { return byteLimit > 0 || packetLimit > 0; }
+
+        /**
+         * @brief Accounts the packet in its flow.
+         *
+         * Returns `false` when the flow already reached its budget and the packet must be dropped.
+        */
+        bool Account(const PacketMeta& meta, double timestamp);
+
+        // Removes the flows idle for longer than the timeout.
+        void Expire(double now);
+
+        // Ends all the flows, at the end of the capture.
+        void Flush();
+
+        // Keys the hash of the table, the tracked flows are dropped.
+        void Seed(uint64_t seed);
+
+        // Flows that ended after being cut, pending to be reported.
+        std::vector<FlowCounters> ended;
+
+    private:
+        typedef std::unordered_map<FlowKey, FlowCounters, FlowKeyHash> FlowMap;
+
+        FlowMap flows;
+
+        struct ClosedFlow {
+            double closedAt;
+
+            // The flow was over its budget, its last segments are dropped too.
+            bool exhausted;
+        };
+
+        // Connections closed by FIN or RST, kept for the timeout (like TIME_WAIT) so the last ACK doesn't start a new flow.
+        typedef std::unordered_map<FlowKey, ClosedFlow, FlowKeyHash> ClosedMap;
+
+        ClosedMap closed;
+
+        uint64_t byteLimit;
+        uint64_t packetLimit;
+        double timeout;
+        size_t maxFlows;
+
+        double lastExpire;
+
+        void End(const FlowCounters& counters);
+};
+
+// Fills the canonical 5-tuple of the packet, returns `false` if it isn't an IP packet.
+bool GetFlowKey(const PacketMeta& meta, FlowKey& key, bool& fromA);
+
+#endif
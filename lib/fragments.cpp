@@ -0,0 +1,383 @@
+#include "fragments.h"
+#include "checksum.h"
+#include "hash.h"
+
+#include <cstring>
+
+// Payloads are at most 65535 bytes, tracked in blocks of 8 bytes (the fragment offset unit).
+#define MAX_PAYLOAD 65535
+#define BLOCK_WORDS ((MAX_PAYLOAD / 8 + 64) / 64)
+
+// Fragments of a datagram, and bytes of the ones kept as captured. A datagram going over is resent
+// again and again (or cut far too small), it's evicted rather than held until the timeout.
+#define MAX_FRAGMENTS 256
+#define MAX_FRAME_BYTES (2 * MAX_PAYLOAD)
+
+static inline uint16_t Read16(const u_char* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+static inline uint32_t Read32(const u_char* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static inline void Write16(uint8_t* data, uint16_t value) {
+    data[0] = static_cast<uint8_t>(value >> 8);
+    data[1] = static_cast<uint8_t>(value);
+}
+
+// Finds the IPv6 fragment header and the next header field pointing to it.
+static bool FindFragmentHeader(const u_char* packet, uint32_t caplen, uint32_t l3Offset, uint32_t& fragment, uint32_t& nextHeaderOffset) {
+    nextHeaderOffset = l3Offset + 6;
+    uint32_t offset = l3Offset + 40;
+
+    for (;;) {
+        if (caplen < offset + 8)
+            return false;
+
+        switch (packet[nextHeaderOffset]) {
+            case 44: // Fragment
+                fragment = offset;
+                return true;
+            case 0: // Hop-by-Hop
+            case 43: // Routing
+            case 60: // Destination Options
+                nextHeaderOffset = offset;
+                offset += (packet[offset + 1] + 1) * 8;
+                break;
+            case 51: // Authentication Header
+                nextHeaderOffset = offset;
+                offset += (packet[offset + 1] + 2) * 4;
+                break;
+            default:
+                return false;
+        }
+    }
+}
+
+bool FragmentKey::operator==(const FragmentKey& other) const {
+    return memcmp(this, &other, sizeof(FragmentKey)) == 0;
+}
+
+size_t FragmentKeyHash::operator()(const FragmentKey& key) const {
+    return static_cast<size_t>(HashFinalize(HashBytes(seed, reinterpret_cast<const uint8_t*>(&key), sizeof(key))));
+}
+
+FragmentTable::FragmentTable() {
+    reassembled = 0;
+    timeouts = 0;
+    evictions = 0;
+    overlaps = 0;
+
+    timeout = 30;
+    maxDatagrams = 0;
+    maxPerSource = 0;
+    overlap = OVERLAP_FIRST;
+
+    lastExpire = 0;
+}
+
+void FragmentTable::Configure(double timeout, size_t maxDatagrams, size_t maxPerSource, OverlapPolicy overlap) {
+    this->timeout = timeout;
+    this->maxDatagrams = maxDatagrams;
+    this->maxPerSource = maxPerSource;
+    this->overlap = overlap;
+
+    datagrams.clear();
+    sources.clear();
+    lastExpire = 0;
+
+    reassembled = 0;
+    timeouts = 0;
+    evictions = 0;
+    overlaps = 0;
+}
+
+void FragmentTable::Seed(uint64_t seed) {
+    datagrams = DatagramMap(0, FragmentKeyHash(seed));
+    sources = SourceMap(0, FragmentKeyHash(seed));
+}
+
+FragmentResult FragmentTable::Add(const u_char* packet, uint32_t caplen, const PacketMeta& meta, double timestamp, const struct pcap_pkthdr* frame) {
+    if (!(meta.flags & META_FRAGMENT) || (meta.ipVersion != 4 && meta.ipVersion != 6))
+        return FRAGMENT_PASS;
+
+    FragmentKey key;
+    memset(&key, 0, sizeof(key));
+    memcpy(key.saddr, meta.saddr, sizeof(key.saddr));
+    memcpy(key.daddr, meta.daddr, sizeof(key.daddr));
+    key.ipVersion = meta.ipVersion;
+
+    memcpy(key.outerSaddr, meta.outerSaddr, sizeof(key.outerSaddr));
+    memcpy(key.outerDaddr, meta.outerDaddr, sizeof(key.outerDaddr));
+    key.tunnelId = meta.tunnelId;
+
+    uint32_t l3Offset = meta.l3Offset;
+    uint32_t headerEnd, dataStart, ipEnd, offset, nextHeaderOffset = 0;
+    uint8_t nextHeader = 0;
+    bool more;
+
+    if (meta.ipVersion == 4) {
+        uint16_t field = Read16(packet + l3Offset + 6);
+
+        key.id = Read16(packet + l3Offset + 4);
+        key.protocol = meta.protocol;
+
+        offset = (field & 0x1FFF) * 8;
+        more = (field & 0x2000) != 0;
+
+        ipEnd = l3Offset + Read16(packet + l3Offset + 2);
+        headerEnd = dataStart = meta.l4Offset;
+    } else {
+        uint32_t fragment;
+        if (!FindFragmentHeader(packet, caplen, l3Offset, fragment, nextHeaderOffset))
+            return FRAGMENT_PASS;
+
+        uint16_t field = Read16(packet + fragment + 2);
+
+        key.id = Read32(packet + fragment + 4);
+
+        offset = field & 0xFFF8;
+        more = (field & 0x0001) != 0;
+        nextHeader = packet[fragment];
+
+        ipEnd = l3Offset + 40 + Read16(packet + l3Offset + 4);
+        headerEnd = fragment;
+        dataStart = fragment + 8;
+    }
+
+    // Only whole and well formed fragments can be reassembled.
+    if (ipEnd > caplen || ipEnd < dataStart)
+        return FRAGMENT_PASS;
+
+    uint32_t length = ipEnd - dataStart;
+    uint32_t end = offset + length;
+
+    // The outermost IP header of a tunnel holds the whole datagram too.
+    uint32_t outerOffset = meta.tunnelDepth > 0 ? meta.outerL3Offset : l3Offset;
+
+    if (end + (dataStart - outerOffset) > MAX_PAYLOAD || (more && (length == 0 || length % 8 != 0)))
+        return FRAGMENT_PASS;
+
+    // Sweep the stale datagrams at most once per second (of capture time).
+    if (timestamp - lastExpire >= 1) {
+        Expire(timestamp);
+        lastExpire = timestamp;
+    }
+
+    auto it = datagrams.find(key);
+    if (it == datagrams.end()) {
+        FragmentKey source;
+        memset(&source, 0, sizeof(source));
+        memcpy(source.saddr, key.saddr, sizeof(source.saddr));
+        source.ipVersion = key.ipVersion;
+
+        auto count = sources.find(source);
+        if (count != sources.end() && count->second >= maxPerSource)
+            EvictOldest(&source);
+
+        if (datagrams.size() >= maxDatagrams)
+            EvictOldest(nullptr);
+
+        Datagram datagram;
+        datagram.blocks.assign(BLOCK_WORDS, 0);
+        datagram.blocksReceived = 0;
+        datagram.total = 0;
+        datagram.l3Offset = 0;
+        datagram.linkType = 0;
+        datagram.tunnelDepth = 0;
+        datagram.fragments = 0;
+        datagram.frameBytes = 0;
+        datagram.firstSeen = timestamp;
+
+        it = datagrams.emplace(key, std::move(datagram)).first;
+        sources[source]++;
+    }
+
+    Datagram& datagram = it->second;
+
+    if (++datagram.fragments > MAX_FRAGMENTS || (frame != nullptr && datagram.frameBytes + caplen > MAX_FRAME_BYTES)) {
+        evictions++;
+        Erase(it);
+        return FRAGMENT_HELD;
+    }
+
+    // The last fragment sets the length, no fragment can go past it.
+    bool consistent = more
+        ? datagram.total == 0 || end <= datagram.total
+        : (datagram.total == 0 || datagram.total == end) && datagram.payload.size() <= end;
+
+    if (!consistent) {
+        overlaps++;
+        Erase(it);
+        return FRAGMENT_HELD;
+    }
+
+    if (!more)
+        datagram.total = end;
+
+    uint32_t firstBlock = offset / 8;
+    uint32_t lastBlock = (end + 7) / 8;
+
+    bool overlapped = false;
+    for (uint32_t block = firstBlock; block < lastBlock && !overlapped; block++)
+        overlapped = (datagram.blocks[block / 64] >> (block % 64)) & 1;
+
+    if (overlapped) {
+        overlaps++;
+
+        if (overlap == OVERLAP_DROP) {
+            Erase(it);
+            return FRAGMENT_HELD;
+        }
+    }
+
+    if (datagram.payload.size() < end)
+        datagram.payload.resize(end);
+
+    const u_char* data = packet + dataStart;
+
+    if (!overlapped || overlap == OVERLAP_LAST)
+        memcpy(datagram.payload.data() + offset, data, length);
+
+    for (uint32_t block = firstBlock; block < lastBlock; block++) {
+        uint64_t bit = 1ULL << (block % 64);
+
+        if (datagram.blocks[block / 64] & bit)
+            continue;
+
+        // Keep the bytes received first, only fill the gaps.
+        if (overlapped && overlap == OVERLAP_FIRST) {
+            uint32_t start = block * 8;
+            uint32_t stop = start + 8 < end ? start + 8 : end;
+
+            memcpy(datagram.payload.data() + start, data + (start - offset), stop - start);
+        }
+
+        datagram.blocks[block / 64] |= bit;
+        datagram.blocksReceived++;
+    }
+
+    if (frame != nullptr) {
+        datagram.frames.push_back({ *frame, std::vector<uint8_t>(packet, packet + caplen) });
+        datagram.frameBytes += caplen;
+    }
+
+    if (offset == 0) {
+        datagram.header.assign(packet, packet + headerEnd);
+        datagram.l3Offset = l3Offset;
+        datagram.linkType = meta.linkType;
+        datagram.tunnelDepth = meta.tunnelDepth;
+
+        // Unlink the fragment header, the next header field points to the fragmented protocol.
+        if (meta.ipVersion == 6)
+            datagram.header[nextHeaderOffset] = nextHeader;
+    }
+
+    if (datagram.total == 0 || datagram.header.empty() || datagram.blocksReceived < (datagram.total + 7) / 8)
+        return FRAGMENT_HELD;
+
+    Build(datagram, meta.ipVersion);
+    frames = std::move(datagram.frames);
+
+    reassembled++;
+    Erase(it);
+
+    return FRAGMENT_DONE;
+}
+
+void FragmentTable::Build(const Datagram& datagram, uint8_t ipVersion) {
+    output.assign(datagram.header.begin(), datagram.header.end());
+    output.insert(output.end(), datagram.payload.begin(), datagram.payload.begin() + datagram.total);
+
+    uint8_t* ip = output.data() + datagram.l3Offset;
+    uint32_t headerLength = static_cast<uint32_t>(datagram.header.size()) - datagram.l3Offset;
+    uint32_t length = headerLength + datagram.total;
+
+    // Bytes added to the IP packet of the first fragment, the tunnels around it grow as much.
+    uint16_t growth;
+
+    if (ipVersion == 4) {
+        growth = static_cast<uint16_t>(length - Read16(ip + 2));
+        Write16(ip + 2, static_cast<uint16_t>(length));
+
+        // Keep "don't fragment", clear "more fragments" and the offset.
+        Write16(ip + 6, Read16(ip + 6) & 0x4000);
+
+        Write16(ip + 10, 0);
+        Write16(ip + 10, static_cast<uint16_t>(~ChecksumAdd(ip, headerLength, 0)));
+    } else {
+        // The length of the first fragment still counts its fragment header.
+        growth = static_cast<uint16_t>(length - 40 - Read16(ip + 4));
+        Write16(ip + 4, static_cast<uint16_t>(length - 40));
+    }
+
+    // The innermost tunnel first, a GRE checksum covers the headers inside it.
+    for (int depth = datagram.tunnelDepth - 1; depth >= 0; depth--) {
+        PacketMeta outer;
+        ParsePacket(datagram.linkType, output.data(), static_cast<uint32_t>(output.size()), outer, depth, 0);
+
+        uint8_t* outerIp = output.data() + outer.l3Offset;
+        uint8_t* transport = output.data() + outer.l4Offset;
+
+        if (outer.ipVersion == 4) {
+            Write16(outerIp + 2, static_cast<uint16_t>(Read16(outerIp + 2) + growth));
+
+            Write16(outerIp + 10, 0);
+            Write16(outerIp + 10, static_cast<uint16_t>(~ChecksumAdd(outerIp, outer.l4Offset - outer.l3Offset, 0)));
+        } else {
+            Write16(outerIp + 4, static_cast<uint16_t>(Read16(outerIp + 4) + growth));
+        }
+
+        if (outer.protocol == 17) {
+            Write16(transport + 4, static_cast<uint16_t>(Read16(transport + 4) + growth));
+
+            // Cleared rather than computed again, allowed over IPv4 and for tunnels over IPv6 (RFC 6935).
+            Write16(transport + 6, 0);
+        } else if (outer.protocol == 47 && (Read16(transport) & 0x8000)) {
+            Write16(transport + 4, 0);
+            Write16(transport + 4, static_cast<uint16_t>(~ChecksumAdd(transport, output.size() - outer.l4Offset, 0)));
+        }
+    }
+}
+
+void FragmentTable::Expire(double now) {
+    for (auto it = datagrams.begin(); it != datagrams.end();) {
+        if (now - it->second.firstSeen > timeout) {
+            timeouts++;
+            it = Erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+FragmentTable::DatagramMap::iterator FragmentTable::Erase(DatagramMap::iterator it) {
+    FragmentKey source;
+    memset(&source, 0, sizeof(source));
+    memcpy(source.saddr, it->first.saddr, sizeof(source.saddr));
+    source.ipVersion = it->first.ipVersion;
+
+    auto count = sources.find(source);
+    if (count != sources.end() && --count->second == 0)
+        sources.erase(count);
+
+    return datagrams.erase(it);
+}
+
+void FragmentTable::EvictOldest(const FragmentKey* source) {
+    auto oldest = datagrams.end();
+
+    for (auto it = datagrams.begin(); it != datagrams.end(); ++it) {
+        if (source != nullptr && (it->first.ipVersion != source->ipVersion || memcmp(it->first.saddr, source->saddr, sizeof(source->saddr)) != 0))
+            continue;
+
+        if (oldest == datagrams.end() || it->second.firstSeen < oldest->second.firstSeen)
+            oldest = it;
+    }
+
+    if (oldest != datagrams.end()) {
+        evictions++;
+        Erase(oldest);
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef NPCAP_FRAGMENTS_H
+#define NPCAP_FRAGMENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "hash.h"
+#include "parser.h"
+
+// How the bytes received twice (overlapping fragments) are resolved.
+enum OverlapPolicy {
+    OVERLAP_FIRST, // Keep the bytes received first.
+    OVERLAP_LAST,  // Overwrite them with the last fragment.
+    OVERLAP_DROP   // Drop the whole datagram (RFC 5722).
+};
+
+enum FragmentResult {
+    FRAGMENT_PASS, // Not reassembled (not a fragment, truncated...), deliver it as is.
+    FRAGMENT_HELD, // Stored until the rest of the datagram arrives.
+    FRAGMENT_DONE  // The datagram is complete, see `Output()`.
+};
+
+struct FragmentKey {
+    uint8_t saddr[16];
+    uint8_t daddr[16];
+    uint32_t id;
+    uint8_t protocol;
+    uint8_t ipVersion;
+
+    // The outermost tunnel, the same inner addresses can be reused in another one (zero without tunnel).
+    uint8_t outerSaddr[16];
+    uint8_t outerDaddr[16];
+    uint32_t tunnelId;
+
+    bool operator==(const FragmentKey& other) const;
+};
+
+// A fragment as captured, kept with its datagram (see `FragmentTable::Add`).
+struct FragmentFrame {
+    struct pcap_pkthdr header;
+    std::vector<uint8_t> data;
+};
+
+struct FragmentKeyHash {
+    uint64_t seed;
+
+    FragmentKeyHash(uint64_t seed = HASH_PRIME_1): seed(seed) {}
+    size_t operator()(const FragmentKey& key) const;
+};
+
+/**
+ * Reassembles IPv4 and IPv6 fragments with bounded memory.
+ *
+ * At most `maxDatagrams` datagrams (and `maxPerSource` per source address) are
+ * pending at once, the oldest one is evicted to make room for a new one. A datagram
+ * is evicted too after 256 fragments (or once its kept fragments go past 128 KiB).
+*/
+class FragmentTable {
+    public:
+        FragmentTable();
+
+        void Configure(double timeout, size_t maxDatagrams, size_t maxPerSource, OverlapPolicy overlap);
+        bool Enabled() const { return maxDatagrams > 0; }
+
+        // With `frame`, the fragment is kept as captured until its datagram is complete, see `Frames()`.
+        FragmentResult Add(const u_char* packet, uint32_t caplen, const PacketMeta& meta, double timestamp, const struct pcap_pkthdr* frame = nullptr);
+
+        // The last reassembled datagram, with the link-layer, tunnel and IP headers of the first fragment.
+        const std::vector<uint8_t>& Output() const { return output; }
+
+        // The fragments of the last reassembled datagram that were kept, in their arrival order.
+        const std::vector<FragmentFrame>& Frames() const { return frames; }
+
+        // Removes the datagrams pending for longer than the timeout.
+        void Expire(double now);
+
+        // Keys the hash of the table, the pending datagrams are dropped.
+        void Seed(uint64_t seed);
+
+        uint64_t reassembled;
+        uint64_t timeouts;
+        uint64_t evictions;
+        uint64_t overlaps;
+
+    private:
+        struct Datagram {
+            // Link-layer and IP headers of the first fragment (without the IPv6 fragment header).
+            std::vector<uint8_t> header;
+            std::vector<uint8_t> payload;
+
+            // One bit per 8-byte block received.
+            std::vector<uint64_t> blocks;
+            uint32_t blocksReceived;
+
+            // Payload length, known once the last fragment arrives.
+            uint32_t total;
+
+            uint32_t l3Offset;
+
+            // Encapsulations around the IP header, their lengths are fixed once reassembled.
+            uint16_t linkType;
+            uint8_t tunnelDepth;
+
+            std::vector<FragmentFrame> frames;
+            uint32_t fragments;
+            size_t frameBytes;
+
+            double firstSeen;
+        };
+
+        typedef std::unordered_map<FragmentKey, Datagram, FragmentKeyHash> DatagramMap;
+
+        DatagramMap datagrams;
+        typedef std::unordered_map<FragmentKey, size_t, FragmentKeyHash> SourceMap;
+
+        SourceMap sources;
+        std::vector<uint8_t> output;
+        std::vector<FragmentFrame> frames;
+
+        double timeout;
+        size_t maxDatagrams;
+        size_t maxPerSource;
+        OverlapPolicy overlap;
+
+        double lastExpire;
+
+        DatagramMap::iterator Erase(DatagramMap::iterator it);
+        void EvictOldest(const FragmentKey* source);
+        void Build(const Datagram& datagram, uint8_t ipVersion);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef NPCAP_HASH_H
+#define NPCAP_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define HASH_PRIME_1 0x9E3779B97F4A7C15ULL
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+
+static inline uint64_t HashMix(uint64_t hash, uint64_t value) {
+    hash ^= value * HASH_PRIME_2;
+    hash = (hash << 31) | (hash >> 33);
+    return hash * HASH_PRIME_1;
+}
+
+static inline uint64_t HashFinalize(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Hashes 8 bytes at a time, `hash` is the seed (or the result of a previous call to chain ranges).
+static inline uint64_t HashBytes(uint64_t hash, const uint8_t* data, size_t length) {
+    hash = HashMix(hash, length);
+
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t value;
+        memcpy(&value, data, 8);
+        hash = HashMix(hash, value);
+    }
+
+    if (length > 0) {
+        uint64_t value = 0;
+        memcpy(&value, data, length);
+        hash = HashMix(hash, value);
+    }
+
+    return hash;
+}
+
+#endif
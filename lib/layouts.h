@@ -0,0 +1,162 @@
+// Generated by scripts/codegen.ts from schema/layouts.json, do not edit.
+#ifndef NPCAP_LAYOUTS_H
+#define NPCAP_LAYOUTS_H
+
+#include <cstdint>
+
+// The fields are in network byte order.
+static inline uint16_t LayoutRead16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+static inline uint32_t LayoutRead32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+// https://en.wikipedia.org/wiki/Ethernet_frame
+struct EthernetLayout {
+    static constexpr uint32_t Size = 14;
+
+    static constexpr uint32_t DhostOffset = 0;
+    static constexpr uint32_t ShostOffset = 6;
+    static constexpr uint32_t TypeOffset = 12;
+
+    // EtherType of the payload.
+    static inline uint16_t Type(const uint8_t* data) { return LayoutRead16(data + 12); }
+};
+
+// http://en.wikipedia.org/wiki/IPv4
+struct IPv4Layout {
+    static constexpr uint32_t Size = 20;
+
+    static constexpr uint32_t VersionOffset = 0;
+    static constexpr uint32_t HeaderLengthOffset = 0;
+    static constexpr uint32_t DiffservOffset = 1;
+    static constexpr uint32_t LengthOffset = 2;
+    static constexpr uint32_t IdentificationOffset = 4;
+    static constexpr uint32_t FlagsOffset = 6;
+    static constexpr uint32_t DoNotFragmentOffset = 6;
+    static constexpr uint32_t MoreFragmentsOffset = 6;
+    static constexpr uint32_t FragmentOffsetOffset = 6;
+    static constexpr uint32_t TtlOffset = 8;
+    static constexpr uint32_t ProtocolOffset = 9;
+    static constexpr uint32_t HeaderChecksumOffset = 10;
+    static constexpr uint32_t SaddrOffset = 12;
+    static constexpr uint32_t DaddrOffset = 16;
+
+    static inline uint8_t Version(const uint8_t* data) { return static_cast<uint8_t>((data[0] & 0xF0) >> 4); }
+    static inline uint32_t HeaderLength(const uint8_t* data) { return (data[0] & 0x0F) << 2; }
+    static inline uint8_t Diffserv(const uint8_t* data) { return data[1]; }
+    static inline uint16_t Length(const uint8_t* data) { return LayoutRead16(data + 2); }
+    static inline uint16_t Identification(const uint8_t* data) { return LayoutRead16(data + 4); }
+    // Reserved, Don't Fragment and More Fragments bits.
+    static inline uint8_t Flags(const uint8_t* data) { return static_cast<uint8_t>((data[6] & 0xE0) >> 5); }
+    static inline bool DoNotFragment(const uint8_t* data) { return (data[6] & 0x40) != 0; }
+    static inline bool MoreFragments(const uint8_t* data) { return (data[6] & 0x20) != 0; }
+    static inline uint32_t FragmentOffset(const uint8_t* data) { return (LayoutRead16(data + 6) & 0x1FFF) << 3; }
+    static inline uint8_t Ttl(const uint8_t* data) { return data[8]; }
+    static inline uint8_t Protocol(const uint8_t* data) { return data[9]; }
+    static inline uint16_t HeaderChecksum(const uint8_t* data) { return LayoutRead16(data + 10); }
+    static inline uint32_t Saddr(const uint8_t* data) { return LayoutRead32(data + 12); }
+    static inline uint32_t Daddr(const uint8_t* data) { return LayoutRead32(data + 16); }
+};
+
+// https://en.wikipedia.org/wiki/IPv6_packet
+struct IPv6Layout {
+    static constexpr uint32_t Size = 40;
+
+    static constexpr uint32_t VersionOffset = 0;
+    static constexpr uint32_t TrafficClassOffset = 0;
+    static constexpr uint32_t FlowLabelOffset = 0;
+    static constexpr uint32_t PayloadLengthOffset = 4;
+    static constexpr uint32_t NextHeaderOffset = 6;
+    static constexpr uint32_t HopLimitOffset = 7;
+    static constexpr uint32_t SaddrOffset = 8;
+    static constexpr uint32_t DaddrOffset = 24;
+
+    static inline uint8_t Version(const uint8_t* data) { return static_cast<uint8_t>((data[0] & 0xF0) >> 4); }
+    static inline uint16_t TrafficClass(const uint8_t* data) { return static_cast<uint16_t>((LayoutRead16(data) & 0x0FF0) >> 4); }
+    static inline uint32_t FlowLabel(const uint8_t* data) { return LayoutRead32(data) & 0x000FFFFF; }
+    static inline uint16_t PayloadLength(const uint8_t* data) { return LayoutRead16(data + 4); }
+    static inline uint8_t NextHeader(const uint8_t* data) { return data[6]; }
+    static inline uint8_t HopLimit(const uint8_t* data) { return data[7]; }
+};
+
+// http://en.wikipedia.org/wiki/Transmission_Control_Protocol
+struct TcpLayout {
+    static constexpr uint32_t Size = 20;
+
+    static constexpr uint32_t SportOffset = 0;
+    static constexpr uint32_t DportOffset = 2;
+    static constexpr uint32_t SeqnoOffset = 4;
+    static constexpr uint32_t AcknoOffset = 8;
+    static constexpr uint32_t HeaderLengthOffset = 12;
+    static constexpr uint32_t FlagsOffset = 12;
+    static constexpr uint32_t FinOffset = 13;
+    static constexpr uint32_t SynOffset = 13;
+    static constexpr uint32_t RstOffset = 13;
+    static constexpr uint32_t PshOffset = 13;
+    static constexpr uint32_t AckOffset = 13;
+    static constexpr uint32_t UrgOffset = 13;
+    static constexpr uint32_t WindowSizeOffset = 14;
+    static constexpr uint32_t ChecksumOffset = 16;
+    static constexpr uint32_t UrgentPointerOffset = 18;
+
+    static inline uint16_t Sport(const uint8_t* data) { return LayoutRead16(data); }
+    static inline uint16_t Dport(const uint8_t* data) { return LayoutRead16(data + 2); }
+    static inline uint32_t Seqno(const uint8_t* data) { return LayoutRead32(data + 4); }
+    static inline uint32_t Ackno(const uint8_t* data) { return LayoutRead32(data + 8); }
+    static inline uint32_t HeaderLength(const uint8_t* data) { return (data[12] & 0xF0) >> 2; }
+    // NS, CWR, ECE, URG, ACK, PSH, RST, SYN and FIN bits.
+    static inline uint16_t Flags(const uint8_t* data) { return static_cast<uint16_t>(LayoutRead16(data + 12) & 0x01FF); }
+    static inline bool Fin(const uint8_t* data) { return (data[13] & 0x01) != 0; }
+    static inline bool Syn(const uint8_t* data) { return (data[13] & 0x02) != 0; }
+    static inline bool Rst(const uint8_t* data) { return (data[13] & 0x04) != 0; }
+    static inline bool Psh(const uint8_t* data) { return (data[13] & 0x08) != 0; }
+    static inline bool Ack(const uint8_t* data) { return (data[13] & 0x10) != 0; }
+    static inline bool Urg(const uint8_t* data) { return (data[13] & 0x20) != 0; }
+    static inline uint16_t WindowSize(const uint8_t* data) { return LayoutRead16(data + 14); }
+    static inline uint16_t Checksum(const uint8_t* data) { return LayoutRead16(data + 16); }
+    static inline uint16_t UrgentPointer(const uint8_t* data) { return LayoutRead16(data + 18); }
+};
+
+// https://www.rfc-editor.org/rfc/rfc2018
+struct TcpSackBlockLayout {
+    static constexpr uint32_t Size = 8;
+
+    static constexpr uint32_t LeftOffset = 0;
+    static constexpr uint32_t RightOffset = 4;
+
+    static inline uint32_t Left(const uint8_t* data) { return LayoutRead32(data); }
+    static inline uint32_t Right(const uint8_t* data) { return LayoutRead32(data + 4); }
+};
+
+// https://en.wikipedia.org/wiki/User_Datagram_Protocol
+struct UdpLayout {
+    static constexpr uint32_t Size = 8;
+
+    static constexpr uint32_t SportOffset = 0;
+    static constexpr uint32_t DportOffset = 2;
+    static constexpr uint32_t LengthOffset = 4;
+    static constexpr uint32_t ChecksumOffset = 6;
+
+    static inline uint16_t Sport(const uint8_t* data) { return LayoutRead16(data); }
+    static inline uint16_t Dport(const uint8_t* data) { return LayoutRead16(data + 2); }
+    static inline uint16_t Length(const uint8_t* data) { return LayoutRead16(data + 4); }
+    static inline uint16_t Checksum(const uint8_t* data) { return LayoutRead16(data + 6); }
+};
+
+// https://en.wikipedia.org/wiki/Internet_Control_Message_Protocol
+struct IcmpLayout {
+    static constexpr uint32_t Size = 8;
+
+    static constexpr uint32_t TypeOffset = 0;
+    static constexpr uint32_t CodeOffset = 1;
+    static constexpr uint32_t ChecksumOffset = 2;
+
+    static inline uint8_t Type(const uint8_t* data) { return data[0]; }
+    static inline uint8_t Code(const uint8_t* data) { return data[1]; }
+    static inline uint16_t Checksum(const uint8_t* data) { return LayoutRead16(data + 2); }
+};
+
+#endif
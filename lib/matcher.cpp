@@ -0,0 +1,144 @@
+#include "matcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+#define NO_NODE UINT32_MAX
+
+PatternMatcher::PatternMatcher() {
+    Clear();
+}
+
+void PatternMatcher::Clear() {
+    patterns.clear();
+    nodes.clear();
+    transitions.clear();
+    outputs.clear();
+    seen.clear();
+
+    memset(byteClass, 0, sizeof(byteClass));
+    classCount = 1;
+    generation = 0;
+}
+
+void PatternMatcher::Add(const uint8_t* pattern, size_t length, uint32_t id) {
+    if (length == 0)
+        return;
+
+    patterns.emplace_back(std::vector<uint8_t>(pattern, pattern + length), id);
+}
+
+void PatternMatcher::Compile() {
+    nodes.clear();
+    transitions.clear();
+    outputs.clear();
+
+    // Class `0` groups every byte that no pattern uses.
+    memset(byteClass, 0, sizeof(byteClass));
+    classCount = 1;
+
+    uint32_t maxId = 0;
+    for (auto& pattern : patterns) {
+        for (auto byte : pattern.first) {
+            if (byteClass[byte] == 0)
+                byteClass[byte] = static_cast<uint16_t>(classCount++);
+        }
+
+        if (pattern.second > maxId)
+            maxId = pattern.second;
+    }
+
+    // Build the trie.
+    std::vector<std::vector<uint32_t>> nodeOutputs(1);
+    nodes.push_back({ 0, 0, 0 });
+    transitions.assign(classCount, NO_NODE);
+
+    for (auto& pattern : patterns) {
+        uint32_t node = 0;
+
+        for (auto byte : pattern.first) {
+            uint32_t& next = transitions[node * classCount + byteClass[byte]];
+
+            if (next == NO_NODE) {
+                next = static_cast<uint32_t>(nodes.size());
+
+                nodes.push_back({ 0, 0, 0 });
+                nodeOutputs.emplace_back();
+                transitions.resize(transitions.size() + classCount, NO_NODE);
+            }
+
+            node = transitions[node * classCount + byteClass[byte]];
+        }
+
+        nodeOutputs[node].push_back(pattern.second);
+    }
+
+    // Breadth first: resolve the failure links and turn the trie into a DFA.
+    std::deque<uint32_t> queue = { 0 };
+
+    while (!queue.empty()) {
+        uint32_t node = queue.front();
+        queue.pop_front();
+
+        for (uint32_t byteClassIndex = 0; byteClassIndex < classCount; byteClassIndex++) {
+            uint32_t& next = transitions[node * classCount + byteClassIndex];
+            uint32_t fallback = node == 0 ? 0 : transitions[nodes[node].fail * classCount + byteClassIndex];
+
+            if (next == NO_NODE) {
+                next = fallback;
+                continue;
+            }
+
+            nodes[next].fail = fallback;
+
+            auto& inherited = nodeOutputs[fallback];
+            nodeOutputs[next].insert(nodeOutputs[next].end(), inherited.begin(), inherited.end());
+
+            queue.push_back(next);
+        }
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].outputStart = static_cast<uint32_t>(outputs.size());
+        nodes[i].outputCount = static_cast<uint32_t>(nodeOutputs[i].size());
+
+        outputs.insert(outputs.end(), nodeOutputs[i].begin(), nodeOutputs[i].end());
+    }
+
+    seen.assign(patterns.empty() ? 0 : maxId + 1, 0);
+    generation = 0;
+}
+
+size_t PatternMatcher::Match(const uint8_t* data, size_t length, uint32_t* ids, size_t maxIds) {
+    if (nodes.empty())
+        return 0;
+
+    if (++generation == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        generation = 1;
+    }
+
+    size_t count = 0;
+    uint32_t state = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        state = transitions[state * classCount + byteClass[data[i]]];
+
+        const Node& node = nodes[state];
+        for (uint32_t j = 0; j < node.outputCount; j++) {
+            uint32_t id = outputs[node.outputStart + j];
+            if (seen[id] == generation)
+                continue;
+
+            seen[id] = generation;
+
+            if (count < maxIds)
+                ids[count] = id;
+
+            count++;
+        }
+    }
+
+    return count;
+}
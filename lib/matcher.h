@@ -0,0 +1,52 @@
+#ifndef NPCAP_MATCHER_H
+#define NPCAP_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Aho-Corasick automaton matching many byte patterns in a single pass.
+ *
+ * The trie is compiled into a DFA over byte classes (bytes that don't appear in
+ * any pattern share one class), so matching is a table lookup per input byte.
+*/
+class PatternMatcher {
+    public:
+        PatternMatcher();
+
+        void Clear();
+        void Add(const uint8_t* pattern, size_t length, uint32_t id);
+        void Compile();
+
+        bool Empty() const { return patterns.empty(); }
+
+        /**
+         * @brief Scans `data` and writes the distinct ids of the matched patterns into `ids`.
+         *
+         * Returns the number of distinct matches, which may be larger than `maxIds`.
+        */
+        size_t Match(const uint8_t* data, size_t length, uint32_t* ids, size_t maxIds);
+
+    private:
+        struct Node {
+            uint32_t fail;
+            uint32_t outputStart;
+            uint32_t outputCount;
+        };
+
+        std::vector<std::pair<std::vector<uint8_t>, uint32_t>> patterns;
+
+        std::vector<Node> nodes;
+        std::vector<uint32_t> transitions;
+        std::vector<uint32_t> outputs;
+
+        uint16_t byteClass[256];
+        uint32_t classCount;
+
+        // Stamp per pattern id used to report each id once per scan.
+        std::vector<uint32_t> seen;
+        uint32_t generation;
+};
+
+#endif
@@ -0,0 +1,766 @@
+#include "parser.h"
+#include "hash.h"
+#include "layouts.h"
+
+#include <cstring>
+
+#define LINUX_SLL_OUTGOING 4
+#define ARPHRD_LOOPBACK 772
+
+#define VXLAN_PORT 4789
+#define GENEVE_PORT 6081
+
+static inline uint16_t Read16(const u_char* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+static inline uint32_t Read32(const u_char* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+// Radiotap and the 802.11 header are little-endian.
+static inline uint16_t Read16LE(const u_char* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static inline uint32_t Read32LE(const u_char* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static inline bool Truncated(PacketMeta& meta) {
+    meta.flags |= META_TRUNCATED;
+    return false;
+}
+
+// https://www.iana.org/assignments/protocol-numbers/protocol-numbers.xhtml
+static bool ParseTransport(const u_char* packet, uint32_t caplen, uint32_t ipEnd, PacketMeta& meta) {
+    uint32_t offset = meta.l4Offset;
+
+    switch (meta.protocol) {
+        case 6: { // TCP
+            if (caplen < offset + TcpLayout::Size)
+                return Truncated(meta);
+
+            uint32_t headerLength = TcpLayout::HeaderLength(packet + offset);
+            if (headerLength < TcpLayout::Size)
+                return false;
+
+            meta.sport = TcpLayout::Sport(packet + offset);
+            meta.dport = TcpLayout::Dport(packet + offset);
+            // The byte of the FIN to CWR bits.
+            meta.tcpFlags = packet[offset + TcpLayout::FinOffset];
+            meta.payloadOffset = offset + headerLength;
+            break;
+        }
+        case 17: // UDP
+        case 132: // SCTP (common header)
+            if (caplen < offset + UdpLayout::Size)
+                return Truncated(meta);
+
+            // The SCTP ports are at the same offsets.
+            meta.sport = UdpLayout::Sport(packet + offset);
+            meta.dport = UdpLayout::Dport(packet + offset);
+            meta.payloadOffset = offset + (meta.protocol == 17 ? UdpLayout::Size : 12);
+            break;
+        case 1: // ICMP
+        case 2: // IGMP
+        case 58: // ICMPv6
+            meta.payloadOffset = offset + 8;
+            break;
+        default:
+            meta.payloadOffset = offset;
+            meta.payloadLength = ipEnd > offset ? ipEnd - offset : 0;
+            return false;
+    }
+
+    meta.payloadLength = ipEnd > meta.payloadOffset ? ipEnd - meta.payloadOffset : 0;
+
+    if (meta.payloadOffset > caplen)
+        return Truncated(meta);
+
+    meta.flags |= META_PARSED;
+    return true;
+}
+
+// http://en.wikipedia.org/wiki/IPv4
+static bool ParseIPv4(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    uint32_t offset = meta.l3Offset;
+    if (caplen < offset + IPv4Layout::Size)
+        return Truncated(meta);
+
+    const u_char* header = packet + offset;
+    if (IPv4Layout::Version(header) != 4)
+        return false;
+
+    uint32_t headerLength = IPv4Layout::HeaderLength(header);
+    if (headerLength < IPv4Layout::Size)
+        return false;
+
+    meta.ipVersion = 4;
+    meta.ttl = IPv4Layout::Ttl(header);
+    meta.protocol = IPv4Layout::Protocol(header);
+    memcpy(meta.saddr, header + IPv4Layout::SaddrOffset, 4);
+    memcpy(meta.daddr, header + IPv4Layout::DaddrOffset, 4);
+
+    meta.l4Offset = offset + headerLength;
+
+    uint32_t ipEnd = offset + IPv4Layout::Length(header);
+
+    uint32_t fragmentOffset = IPv4Layout::FragmentOffset(header);
+    if (fragmentOffset != 0 || IPv4Layout::MoreFragments(header))
+        meta.flags |= META_FRAGMENT;
+
+    // Non-first fragments don't carry a transport header.
+    if (fragmentOffset != 0) {
+        meta.payloadOffset = meta.l4Offset;
+        meta.payloadLength = ipEnd > meta.l4Offset ? ipEnd - meta.l4Offset : 0;
+
+        if (meta.payloadOffset > caplen)
+            return Truncated(meta);
+
+        meta.flags |= META_PARSED;
+        return true;
+    }
+
+    return ParseTransport(packet, caplen, ipEnd, meta);
+}
+
+// https://en.wikipedia.org/wiki/IPv6_packet
+static bool ParseIPv6(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    uint32_t offset = meta.l3Offset;
+    if (caplen < offset + IPv6Layout::Size)
+        return Truncated(meta);
+
+    const u_char* header = packet + offset;
+    if (IPv6Layout::Version(header) != 6)
+        return false;
+
+    meta.ipVersion = 6;
+    meta.ttl = IPv6Layout::HopLimit(header);
+    memcpy(meta.saddr, header + IPv6Layout::SaddrOffset, 16);
+    memcpy(meta.daddr, header + IPv6Layout::DaddrOffset, 16);
+
+    uint32_t ipEnd = offset + IPv6Layout::Size + IPv6Layout::PayloadLength(header);
+    uint8_t nextHeader = IPv6Layout::NextHeader(header);
+    offset += IPv6Layout::Size;
+
+    // Skip the extension headers.
+    for (;;) {
+        switch (nextHeader) {
+            case 0: // Hop-by-Hop
+            case 43: // Routing
+            case 60: // Destination Options
+                if (caplen < offset + 8)
+                    return Truncated(meta);
+
+                nextHeader = packet[offset];
+                offset += (packet[offset + 1] + 1) * 8;
+                continue;
+            case 44: // Fragment
+                if (caplen < offset + 8)
+                    return Truncated(meta);
+
+                meta.flags |= META_FRAGMENT;
+                nextHeader = packet[offset];
+
+                // Non-first fragments don't carry a transport header.
+                if ((Read16(packet + offset + 2) & 0xFFF8) != 0) {
+                    meta.protocol = nextHeader;
+                    meta.l4Offset = offset + 8;
+                    meta.payloadOffset = meta.l4Offset;
+                    meta.payloadLength = ipEnd > meta.l4Offset ? ipEnd - meta.l4Offset : 0;
+
+                    if (meta.payloadOffset > caplen)
+                        return Truncated(meta);
+
+                    meta.flags |= META_PARSED;
+                    return true;
+                }
+
+                offset += 8;
+                continue;
+            case 51: // Authentication Header
+                if (caplen < offset + 8)
+                    return Truncated(meta);
+
+                nextHeader = packet[offset];
+                offset += (packet[offset + 1] + 2) * 4;
+                continue;
+        }
+
+        break;
+    }
+
+    meta.protocol = nextHeader;
+    meta.l4Offset = offset;
+
+    return ParseTransport(packet, caplen, ipEnd, meta);
+}
+
+// Symmetric hash of the 5-tuple, the lowest (address, port) endpoint is hashed first.
+static void HashFlow(PacketMeta& meta, uint64_t seed) {
+    size_t addressLength = meta.ipVersion == 4 ? 4 : 16;
+
+    // Non-first fragments don't carry the ports, so no fragment includes them.
+    uint16_t sport = (meta.flags & META_FRAGMENT) ? 0 : meta.sport;
+    uint16_t dport = (meta.flags & META_FRAGMENT) ? 0 : meta.dport;
+
+    int order = memcmp(meta.saddr, meta.daddr, addressLength);
+    bool swap = order > 0 || (order == 0 && sport > dport);
+
+    uint64_t hash = HashBytes(seed, swap ? meta.daddr : meta.saddr, addressLength);
+    hash = HashBytes(hash, swap ? meta.saddr : meta.daddr, addressLength);
+
+    uint64_t ports = swap ? (static_cast<uint64_t>(dport) << 16) | sport : (static_cast<uint64_t>(sport) << 16) | dport;
+    hash = HashMix(hash, (ports << 8) | meta.protocol);
+
+    meta.flowHash = HashFinalize(hash);
+}
+
+// https://en.wikipedia.org/wiki/Ethernet_frame
+static bool ParseEthernet(const u_char* packet, uint32_t caplen, uint32_t offset, PacketMeta& meta) {
+    offset += 12;
+    if (caplen < offset + 2)
+        return Truncated(meta);
+
+    meta.etherType = Read16(packet + offset);
+    offset += 2;
+
+    // VLAN-tagged (802.1Q / 802.1ad)
+    while (meta.etherType == ETHERTYPE_VLAN || meta.etherType == ETHERTYPE_QINQ) {
+        if (caplen < offset + 4)
+            return Truncated(meta);
+
+        if (!(meta.flags & META_VLAN)) {
+            meta.vlan = Read16(packet + offset) & 0x0FFF;
+            meta.flags |= META_VLAN;
+        }
+
+        meta.etherType = Read16(packet + offset + 2);
+        offset += 4;
+    }
+
+    meta.l3Offset = offset;
+    return true;
+}
+
+// https://en.wikipedia.org/wiki/Multiprotocol_Label_Switching
+static bool ParseMpls(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    uint32_t offset = meta.l3Offset;
+
+    for (;;) {
+        if (caplen < offset + 4)
+            return Truncated(meta);
+
+        uint32_t entry = Read32(packet + offset);
+        offset += 4;
+
+        if (!(meta.flags & META_MPLS)) {
+            meta.mplsLabel = entry >> 12;
+            meta.flags |= META_MPLS;
+        }
+
+        // Bottom of the stack.
+        if (entry & 0x100)
+            break;
+    }
+
+    if (caplen < offset + 1)
+        return Truncated(meta);
+
+    // The payload type isn't recorded, guess it from the IP version.
+    uint8_t version = packet[offset] >> 4;
+    if (version == 4)
+        meta.etherType = ETHERTYPE_IPV4;
+    else if (version == 6)
+        meta.etherType = ETHERTYPE_IPV6;
+    else
+        return false;
+
+    meta.l3Offset = offset;
+    return true;
+}
+
+/**
+ * Finds the encapsulated frame of a parsed IP packet.
+ *
+ * `innerType` is the EtherType of the inner header (`ETHERTYPE_TEB` for Ethernet).
+*/
+static bool FindTunnel(const u_char* packet, uint32_t caplen, const PacketMeta& meta, uint8_t& type, uint32_t& id, uint32_t& inner, uint16_t& innerType) {
+    uint32_t offset = meta.l4Offset;
+    id = 0;
+
+    switch (meta.protocol) {
+        case 4: // IPv4 in IP
+        case 41: // IPv6 in IP
+            type = TUNNEL_IPIP;
+            inner = offset;
+            innerType = meta.protocol == 4 ? ETHERTYPE_IPV4 : ETHERTYPE_IPV6;
+            return true;
+        // https://datatracker.ietf.org/doc/html/rfc2890
+        case 47: { // GRE
+            if (caplen < offset + 4)
+                return false;
+
+            uint16_t flags = Read16(packet + offset);
+            if ((flags & 0x0007) != 0) // version 0 only (PPTP uses version 1)
+                return false;
+
+            inner = offset + 4;
+            if (flags & 0x8000) // checksum
+                inner += 4;
+
+            if (flags & 0x2000) { // key
+                if (caplen < inner + 4)
+                    return false;
+
+                id = Read32(packet + inner);
+                inner += 4;
+            }
+
+            if (flags & 0x1000) // sequence number
+                inner += 4;
+
+            type = TUNNEL_GRE;
+            innerType = Read16(packet + offset + 2);
+            return true;
+        }
+        case 17: // UDP
+            if (!(meta.flags & META_PARSED))
+                return false;
+
+            offset = meta.payloadOffset;
+
+            // https://datatracker.ietf.org/doc/html/rfc7348
+            if (meta.dport == VXLAN_PORT) {
+                if (caplen < offset + 8 || !(packet[offset] & 0x08))
+                    return false;
+
+                type = TUNNEL_VXLAN;
+                id = Read32(packet + offset + 4) >> 8;
+                inner = offset + 8;
+                innerType = ETHERTYPE_TEB;
+                return true;
+            }
+
+            // https://datatracker.ietf.org/doc/html/rfc8926
+            if (meta.dport == GENEVE_PORT) {
+                if (caplen < offset + 8 || (packet[offset] >> 6) != 0)
+                    return false;
+
+                type = TUNNEL_GENEVE;
+                id = Read32(packet + offset + 4) >> 8;
+                inner = offset + 8 + (packet[offset] & 0x3F) * 4;
+                innerType = Read16(packet + offset + 2);
+                return true;
+            }
+
+            return false;
+    }
+
+    return false;
+}
+
+// Moves the IP fields of the outermost tunnel to `outer*` and clears them for the inner packet.
+static void EnterTunnel(PacketMeta& meta, uint8_t type, uint32_t id) {
+    if (meta.tunnelDepth == 0) {
+        meta.tunnelType = type;
+        meta.tunnelId = id;
+        meta.outerIpVersion = meta.ipVersion;
+        meta.outerProtocol = meta.protocol;
+        meta.outerSport = meta.sport;
+        meta.outerDport = meta.dport;
+        meta.outerL3Offset = meta.l3Offset;
+        memcpy(meta.outerSaddr, meta.saddr, sizeof(meta.saddr));
+        memcpy(meta.outerDaddr, meta.daddr, sizeof(meta.daddr));
+        meta.flags |= META_TUNNEL;
+    }
+
+    meta.tunnelDepth++;
+    meta.flags &= ~META_PARSED;
+
+    meta.ipVersion = 0;
+    meta.protocol = 0;
+    meta.ttl = 0;
+    meta.tcpFlags = 0;
+    meta.sport = 0;
+    meta.dport = 0;
+    meta.l4Offset = 0;
+    meta.payloadOffset = 0;
+    meta.payloadLength = 0;
+    memset(meta.saddr, 0, sizeof(meta.saddr));
+    memset(meta.daddr, 0, sizeof(meta.daddr));
+}
+
+static bool ParseNetwork(const u_char* packet, uint32_t caplen, PacketMeta& meta, int maxTunnels) {
+    for (;;) {
+        if (meta.etherType == ETHERTYPE_MPLS || meta.etherType == ETHERTYPE_MPLS_MULTICAST) {
+            if (!ParseMpls(packet, caplen, meta))
+                return false;
+        }
+
+        bool parsed;
+
+        switch (meta.etherType) {
+            case ETHERTYPE_IPV4:
+                parsed = ParseIPv4(packet, caplen, meta);
+                break;
+            case ETHERTYPE_IPV6:
+                parsed = ParseIPv6(packet, caplen, meta);
+                break;
+            default:
+                return false;
+        }
+
+        // Fragments are peeled once reassembled, only the first one has the tunnel header.
+        if (meta.tunnelDepth >= maxTunnels || meta.ipVersion == 0 || (meta.flags & (META_FRAGMENT | META_TRUNCATED)))
+            return parsed;
+
+        uint8_t type;
+        uint32_t id, inner;
+        uint16_t innerType;
+
+        if (!FindTunnel(packet, caplen, meta, type, id, inner, innerType))
+            return parsed;
+
+        EnterTunnel(meta, type, id);
+        meta.innerOffset = inner;
+
+        if (innerType == ETHERTYPE_TEB) {
+            if (!ParseEthernet(packet, caplen, inner, meta))
+                return false;
+        } else {
+            meta.etherType = innerType;
+            meta.l3Offset = inner;
+        }
+    }
+}
+
+// Alignment and size of the radiotap fields, by present bit.
+// https://www.radiotap.org/fields/defined
+static const uint8_t radiotapFields[][2] = {
+    { 8, 8 },  // TSFT
+    { 1, 1 },  // Flags
+    { 1, 1 },  // Rate
+    { 2, 4 },  // Channel
+    { 2, 2 },  // FHSS
+    { 1, 1 },  // Antenna signal (dBm)
+    { 1, 1 },  // Antenna noise (dBm)
+    { 2, 2 },  // Lock quality
+    { 2, 2 },  // TX attenuation
+    { 2, 2 },  // dB TX attenuation
+    { 1, 1 },  // dBm TX power
+    { 1, 1 },  // Antenna
+    { 1, 1 },  // dB antenna signal
+    { 1, 1 },  // dB antenna noise
+    { 2, 2 },  // RX flags
+    { 2, 2 },  // TX flags
+    { 1, 1 },  // RTS retries
+    { 1, 1 },  // Data retries
+    { 4, 8 },  // XChannel
+    { 1, 3 },  // MCS
+    { 4, 8 },  // A-MPDU status
+    { 2, 12 }, // VHT
+    { 8, 12 }, // Timestamp
+    { 2, 12 }, // HE
+    { 2, 12 }, // HE-MU
+    { 2, 6 },  // HE-MU-other-user
+    { 1, 1 },  // 0-length-PSDU
+    { 2, 4 },  // L-SIG
+};
+
+#define RADIOTAP_FIELDS (sizeof(radiotapFields) / sizeof(radiotapFields[0]))
+
+#define RADIOTAP_FLAG_DATA_PAD 0x20
+
+// https://www.radiotap.org
+static bool ParseRadiotap(const u_char* packet, uint32_t caplen, PacketMeta& meta, uint32_t& headerLength) {
+    if (caplen < 8)
+        return Truncated(meta);
+
+    if (packet[0] != 0)
+        return false;
+
+    headerLength = Read16LE(packet + 2);
+    if (headerLength < 8)
+        return false;
+
+    if (caplen < headerLength)
+        return Truncated(meta);
+
+    // Skip the extended bitmaps, their fields come after the ones of the first bitmap.
+    uint32_t present = Read32LE(packet + 4);
+    uint32_t offset = 8;
+
+    for (uint32_t word = present; word & 0x80000000; offset += 4) {
+        if (headerLength < offset + 4)
+            return false;
+
+        word = Read32LE(packet + offset);
+    }
+
+    // Fields are aligned on their natural size from the start of the header. The walk stops
+    // at the first field we don't know the size of, every field after it is unreachable.
+    for (uint32_t bit = 0; bit < RADIOTAP_FIELDS; bit++) {
+        if (!(present & (1u << bit)))
+            continue;
+
+        uint32_t align = radiotapFields[bit][0];
+        uint32_t size = radiotapFields[bit][1];
+
+        offset = (offset + align - 1) & ~(align - 1);
+        if (headerLength < offset + size)
+            break;
+
+        const u_char* field = packet + offset;
+
+        switch (bit) {
+            case 1:
+                meta.radiotapFlags = field[0];
+                break;
+            case 2:
+                meta.rate = field[0];
+                break;
+            case 3:
+                meta.frequency = Read16LE(field);
+                meta.channelFlags = Read16LE(field + 2);
+                break;
+            case 5:
+                meta.signal = static_cast<int8_t>(field[0]);
+                break;
+            case 6:
+                meta.noise = static_cast<int8_t>(field[0]);
+                break;
+            case 11:
+                meta.antenna = field[0];
+                break;
+        }
+
+        offset += size;
+    }
+
+    meta.flags |= META_RADIOTAP;
+    return true;
+}
+
+// https://en.wikipedia.org/wiki/802.11_frame_types
+static bool ParseIeee80211(const u_char* packet, uint32_t caplen, uint32_t offset, PacketMeta& meta) {
+    if (caplen < offset + 10)
+        return Truncated(meta);
+
+    uint16_t frameControl = Read16LE(packet + offset);
+    uint8_t type = (frameControl >> 2) & 0x03;
+    uint8_t subtype = (frameControl >> 4) & 0x0F;
+
+    meta.frameControl = frameControl;
+    memcpy(meta.addr1, packet + offset + 4, 6);
+
+    switch (type) {
+        case 1: // Control
+            meta.flags |= META_WLAN;
+
+            // CTS and ACK only carry the receiver address.
+            if (subtype != 12 && subtype != 13) {
+                if (caplen < offset + 16)
+                    return Truncated(meta);
+
+                memcpy(meta.addr2, packet + offset + 10, 6);
+            }
+
+            return false;
+        case 0: // Management
+        case 2: // Data
+            if (caplen < offset + 24)
+                return Truncated(meta);
+
+            memcpy(meta.addr2, packet + offset + 10, 6);
+            memcpy(meta.addr3, packet + offset + 16, 6);
+            meta.sequence = Read16LE(packet + offset + 22) >> 4;
+            meta.flags |= META_WLAN;
+            break;
+        default:
+            return false;
+    }
+
+    // Null (no data) frames have no body, protected ones can't be read.
+    if (type != 2 || (subtype & 0x04) || (frameControl & 0x4000))
+        return false;
+
+    uint32_t headerLength = 24;
+
+    // To DS and From DS: fourth address.
+    if ((frameControl & 0x0300) == 0x0300)
+        headerLength += 6;
+
+    // QoS control, followed by the HT control when the order bit is set.
+    if (subtype & 0x08) {
+        headerLength += 2;
+
+        if (frameControl & 0x8000)
+            headerLength += 4;
+    }
+
+    if (meta.radiotapFlags & RADIOTAP_FLAG_DATA_PAD)
+        headerLength = (headerLength + 3) & ~3u;
+
+    offset += headerLength;
+    if (caplen < offset + 8)
+        return Truncated(meta);
+
+    // LLC / SNAP
+    if (packet[offset] != 0xAA || packet[offset + 1] != 0xAA || packet[offset + 2] != 0x03)
+        return false;
+
+    meta.etherType = Read16(packet + offset + 6);
+    meta.l3Offset = offset + 8;
+    return true;
+}
+
+/**
+ * Link-layer header of each supported link type, specialized so the pipeline of the
+ * capture's link type is picked once (see `GetPacketParser`) instead of per packet.
+*/
+template <int LinkType>
+static bool ParseLink(const u_char* packet, uint32_t caplen, PacketMeta& meta);
+
+// https://www.tcpdump.org/linktypes/LINKTYPE_NULL.html
+template <>
+bool ParseLink<DLT_NULL>(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    if (caplen < 4)
+        return Truncated(meta);
+
+    uint32_t family = (packet[0] == 0 && packet[1] == 0) ? packet[3] : packet[0];
+    if (family == 2)
+        meta.etherType = ETHERTYPE_IPV4;
+    else if (family == 24 || family == 28 || family == 30)
+        meta.etherType = ETHERTYPE_IPV6;
+
+    meta.l3Offset = 4;
+    return true;
+}
+
+template <>
+bool ParseLink<DLT_EN10MB>(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    return ParseEthernet(packet, caplen, 0, meta);
+}
+
+template <>
+bool ParseLink<DLT_RAW>(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    if (caplen < 1)
+        return Truncated(meta);
+
+    uint8_t version = packet[0] >> 4;
+    if (version == 4)
+        meta.etherType = ETHERTYPE_IPV4;
+    else if (version == 6)
+        meta.etherType = ETHERTYPE_IPV6;
+
+    return true;
+}
+
+// https://www.tcpdump.org/linktypes/LINKTYPE_LINUX_SLL.html
+template <>
+bool ParseLink<DLT_LINUX_SLL>(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    if (caplen < 16)
+        return Truncated(meta);
+
+    meta.etherType = Read16(packet + 14);
+    meta.l3Offset = 16;
+    return true;
+}
+
+// https://www.tcpdump.org/linktypes/LINKTYPE_LINUX_SLL2.html
+template <>
+bool ParseLink<DLT_LINUX_SLL2>(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    if (caplen < 20)
+        return Truncated(meta);
+
+    meta.etherType = Read16(packet);
+    meta.l3Offset = 20;
+    return true;
+}
+
+// https://www.tcpdump.org/linktypes/LINKTYPE_IEEE802_11_RADIOTAP.html
+template <>
+bool ParseLink<DLT_IEEE802_11_RADIO>(const u_char* packet, uint32_t caplen, PacketMeta& meta) {
+    uint32_t headerLength;
+
+    return ParseRadiotap(packet, caplen, meta, headerLength) && ParseIeee80211(packet, caplen, headerLength, meta);
+}
+
+template <int LinkType>
+static bool ParsePacketAs(int, const u_char* packet, uint32_t caplen, PacketMeta& meta, int maxTunnels, uint64_t seed) {
+    memset(&meta, 0, sizeof(meta));
+    meta.linkType = static_cast<uint16_t>(LinkType);
+
+    bool parsed = ParseLink<LinkType>(packet, caplen, meta) && ParseNetwork(packet, caplen, meta, maxTunnels);
+
+    if (meta.ipVersion != 0)
+        HashFlow(meta, seed);
+
+    return parsed;
+}
+
+static bool ParseUnsupported(int linkType, const u_char*, uint32_t, PacketMeta& meta, int, uint64_t) {
+    memset(&meta, 0, sizeof(meta));
+    meta.linkType = static_cast<uint16_t>(linkType);
+
+    return false;
+}
+
+PacketParser GetPacketParser(int linkType) {
+    switch (linkType) {
+        case DLT_NULL:
+            return ParsePacketAs<DLT_NULL>;
+        case DLT_EN10MB:
+            return ParsePacketAs<DLT_EN10MB>;
+        case DLT_RAW:
+            return ParsePacketAs<DLT_RAW>;
+        case DLT_LINUX_SLL:
+            return ParsePacketAs<DLT_LINUX_SLL>;
+        case DLT_LINUX_SLL2:
+            return ParsePacketAs<DLT_LINUX_SLL2>;
+        case DLT_IEEE802_11_RADIO:
+            return ParsePacketAs<DLT_IEEE802_11_RADIO>;
+        default:
+            return ParseUnsupported;
+    }
+}
+
+bool ParsePacket(int linkType, const u_char* packet, uint32_t caplen, PacketMeta& meta, int maxTunnels, uint64_t seed) {
+    return GetPacketParser(linkType)(linkType, packet, caplen, meta, maxTunnels, seed);
+}
+
+PacketDirection GetPacketDirection(int linkType, const u_char* packet, uint32_t caplen, bool& loopback) {
+    uint16_t packetType, addressType;
+    loopback = false;
+
+    switch (linkType) {
+        // https://www.tcpdump.org/linktypes/LINKTYPE_LINUX_SLL.html
+        case DLT_LINUX_SLL:
+            if (caplen < 16)
+                return DIRECTION_UNKNOWN;
+
+            packetType = Read16(packet);
+            addressType = Read16(packet + 2);
+            break;
+        // https://www.tcpdump.org/linktypes/LINKTYPE_LINUX_SLL2.html
+        case DLT_LINUX_SLL2:
+            if (caplen < 20)
+                return DIRECTION_UNKNOWN;
+
+            addressType = Read16(packet + 8);
+            packetType = packet[10];
+            break;
+        default:
+            return DIRECTION_UNKNOWN;
+    }
+
+    loopback = addressType == ARPHRD_LOOPBACK;
+
+    return packetType == LINUX_SLL_OUTGOING ? DIRECTION_OUT : DIRECTION_IN;
+}
+
+bool HasPacketDirection(int linkType) {
+    return linkType == DLT_LINUX_SLL || linkType == DLT_LINUX_SLL2;
+}
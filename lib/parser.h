@@ -0,0 +1,168 @@
+#ifndef NPCAP_PARSER_H
+#define NPCAP_PARSER_H
+
+#include <pcap/pcap.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef DLT_LINUX_SLL2
+#define DLT_LINUX_SLL2 276
+#endif
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_ARP 0x0806
+#define ETHERTYPE_VLAN 0x8100
+#define ETHERTYPE_QINQ 0x88A8
+#define ETHERTYPE_IPV6 0x86DD
+#define ETHERTYPE_MPLS 0x8847
+#define ETHERTYPE_MPLS_MULTICAST 0x8848
+#define ETHERTYPE_TEB 0x6558 // Transparent Ethernet Bridging (Ethernet inside GRE / GENEVE)
+
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_RST 0x04
+
+// PacketMeta::flags
+#define META_PARSED             0x0001 // The headers were parsed up to the transport layer.
+#define META_TRUNCATED          0x0002 // The capture ends before the end of the headers.
+#define META_VLAN               0x0004 // `vlan` holds the id of the (outer) 802.1Q tag.
+#define META_FRAGMENT           0x0008 // IP fragment, only the first one has ports.
+#define META_IP_CHECKSUM_BAD    0x0010 // The IPv4 header checksum is wrong.
+#define META_L4_CHECKSUM_BAD    0x0020 // The TCP / UDP / ICMP checksum is wrong.
+#define META_CHECKSUM_OFFLOAD   0x0040 // The checksums are left to the NIC, they weren't verified.
+#define META_TUNNEL             0x0080 // Tunnels were peeled, the `outer*` fields hold the outermost one.
+#define META_MPLS               0x0100 // `mplsLabel` holds the top label of the MPLS stack.
+#define META_RADIOTAP           0x0200 // The radiotap fields (`frequency`, `signal`...) were read.
+#define META_WLAN               0x0400 // The 802.11 header was parsed, `frameControl` and the addresses are set.
+
+// PacketMeta::tunnelType
+#define TUNNEL_NONE     0
+#define TUNNEL_GRE      1
+#define TUNNEL_VXLAN    2
+#define TUNNEL_GENEVE   3
+#define TUNNEL_IPIP     4 // IPv4 / IPv6 directly inside IPv4 / IPv6.
+
+/**
+ * Fixed layout record describing the headers of a packet.
+ *
+ * It is shared with JS as is (see `src/meta.ts`), so the layout must not change
+ * without updating the offsets there. Multi-byte fields use the host byte order,
+ * the addresses are kept in network byte order.
+*/
+struct PacketMeta {
+    uint16_t linkType;
+    uint16_t flags;
+
+    // Offsets from the start of the frame.
+    uint32_t l3Offset;
+    uint32_t l4Offset;
+    uint32_t payloadOffset;
+
+    uint16_t etherType;
+    uint16_t vlan;
+
+    uint8_t ipVersion;
+    uint8_t protocol;
+    uint8_t ttl;
+    uint8_t tcpFlags;
+
+    uint16_t sport;
+    uint16_t dport;
+
+    // Transport payload length, from the IP header (the capture might be truncated).
+    uint32_t payloadLength;
+
+    // IPv4 addresses use the first 4 bytes.
+    uint8_t saddr[16];
+    uint8_t daddr[16];
+
+    // Direction independent hash of the 5-tuple (3-tuple for fragments), `0` for non IP packets.
+    uint64_t flowHash;
+
+    // The fields above describe the innermost packet, these ones the outermost tunnel (META_TUNNEL).
+    uint8_t tunnelType;
+    uint8_t tunnelDepth;
+    uint8_t outerIpVersion;
+    uint8_t outerProtocol;
+
+    uint16_t outerSport;
+    uint16_t outerDport;
+
+    // VNI (VXLAN / GENEVE) or GRE key.
+    uint32_t tunnelId;
+
+    // Top label of the MPLS stack (META_MPLS).
+    uint32_t mplsLabel;
+
+    uint32_t outerL3Offset;
+
+    // Offset of the innermost encapsulated frame (Ethernet or IP).
+    uint32_t innerOffset;
+
+    uint8_t outerSaddr[16];
+    uint8_t outerDaddr[16];
+
+    // 802.11 monitor mode (radiotap), `0` when the field isn't reported.
+    uint16_t frequency; // MHz
+    uint16_t channelFlags;
+    uint16_t rate; // 500 kbps units
+    int8_t signal; // dBm
+    int8_t noise; // dBm
+    uint16_t frameControl;
+    uint8_t radiotapFlags;
+    uint8_t antenna;
+
+    // Receiver, transmitter and third address (BSSID, source or destination), the ones present in the frame.
+    uint8_t addr1[6];
+    uint8_t addr2[6];
+    uint8_t addr3[6];
+    uint16_t sequence;
+};
+
+static_assert(sizeof(PacketMeta) == 160, "PacketMeta layout is shared with JS");
+static_assert(offsetof(PacketMeta, payloadLength) == 28, "PacketMeta layout is shared with JS");
+static_assert(offsetof(PacketMeta, saddr) == 32, "PacketMeta layout is shared with JS");
+static_assert(offsetof(PacketMeta, flowHash) == 64, "PacketMeta layout is shared with JS");
+static_assert(offsetof(PacketMeta, outerSaddr) == 96, "PacketMeta layout is shared with JS");
+static_assert(offsetof(PacketMeta, addr1) == 140, "PacketMeta layout is shared with JS");
+
+// Direction of the packet as recorded by the link-layer header.
+enum PacketDirection {
+    DIRECTION_UNKNOWN,
+    DIRECTION_IN,
+    DIRECTION_OUT
+};
+
+/**
+ * @brief Parses the link, network and transport headers of a captured packet.
+ *
+ * Returns `false` when the packet is truncated or carries a protocol we don't know
+ * how to parse, in that case only the fields resolved so far are meaningful.
+ *
+ * Up to `maxTunnels` encapsulations (GRE, VXLAN, GENEVE, IP in IP) are peeled, the
+ * main fields then describe the inner packet. VLAN tags and MPLS labels are always skipped.
+ *
+ * `seed` keys the `flowHash`, so the hashes can't be predicted (and collided) from outside.
+*/
+bool ParsePacket(int linkType, const u_char* packet, uint32_t caplen, PacketMeta& meta, int maxTunnels, uint64_t seed);
+
+typedef bool (*PacketParser)(int linkType, const u_char* packet, uint32_t caplen, PacketMeta& meta, int maxTunnels, uint64_t seed);
+
+/**
+ * @brief Returns `ParsePacket` specialized for the link type.
+ *
+ * Pick it once when the capture is opened, the per-packet path then has no dispatch on the link layer.
+*/
+PacketParser GetPacketParser(int linkType);
+
+/**
+ * @brief Reads the packet direction from the Linux "cooked" (SLL / SLL2) headers.
+ *
+ * `loopback` is set when the packet was captured on a loopback interface.
+*/
+PacketDirection GetPacketDirection(int linkType, const u_char* packet, uint32_t caplen, bool& loopback);
+
+// Whether the headers of `linkType` record the direction read by `GetPacketDirection`.
+bool HasPacketDirection(int linkType);
+
+#endif
@@ -0,0 +1,90 @@
+#include "pool.h"
+
+#define HANDLE_SLAB(handle)     (static_cast<uint32_t>(handle) >> (POOL_CLASS_BITS + POOL_SLOT_BITS))
+#define HANDLE_CLASS(handle)    (((handle) >> POOL_SLOT_BITS) & ((1 << POOL_CLASS_BITS) - 1))
+#define HANDLE_SLOT(handle)     ((handle) & ((1 << POOL_SLOT_BITS) - 1))
+#define HANDLE_GENERATION(handle) (static_cast<uint32_t>((handle) >> 32))
+
+PacketPool::PacketPool() {
+    maxBytes = 256 << 20;
+    retainedBytes = 0;
+}
+
+void PacketPool::Configure(size_t maxBytes) {
+    this->maxBytes = maxBytes;
+}
+
+int PacketPool::SizeClass(size_t length) {
+    for (int sizeClass = 0; sizeClass < POOL_CLASSES; sizeClass++) {
+        if (length <= SlotSize(sizeClass))
+            return sizeClass;
+    }
+
+    return -1;
+}
+
+bool PacketPool::Acquire(int sizeClass, uint64_t& handle) {
+    auto& free = freeSlots[sizeClass];
+
+    if (free.empty())
+        return false;
+
+    uint32_t slot = free.back();
+    free.pop_back();
+
+    auto& slab = slabs[HANDLE_SLAB(slot)];
+    uint32_t generation = (slab.generations[HANDLE_SLOT(slot)] + 1) & ((1 << POOL_GENERATION_BITS) - 1);
+
+    slab.generations[HANDLE_SLOT(slot)] = generation;
+    slab.used[HANDLE_SLOT(slot)] = 1;
+    retainedBytes += SlotSize(sizeClass);
+
+    handle = (static_cast<uint64_t>(generation) << 32) | slot;
+    return true;
+}
+
+bool PacketPool::CanGrow() const {
+    return slabs.size() < POOL_MAX_SLABS && (slabs.size() + 1) * POOL_SLAB_SIZE <= maxBytes;
+}
+
+uint32_t PacketPool::AddSlab(int sizeClass, uint8_t* data) {
+    uint32_t index = static_cast<uint32_t>(slabs.size());
+    uint32_t count = POOL_SLAB_SIZE / SlotSize(sizeClass);
+
+    slabs.push_back({ data, sizeClass, std::vector<uint8_t>(count, 0), std::vector<uint32_t>(count, 0) });
+
+    // Pushed in reverse, the lowest slots are handed out first.
+    auto& free = freeSlots[sizeClass];
+    for (uint32_t slot = count; slot-- > 0;)
+        free.push_back((index << (POOL_CLASS_BITS + POOL_SLOT_BITS)) | (uint32_t(sizeClass) << POOL_SLOT_BITS) | slot);
+
+    return index;
+}
+
+bool PacketPool::Release(uint64_t handle) {
+    uint32_t index = HANDLE_SLAB(handle);
+
+    if (index >= slabs.size())
+        return false;
+
+    auto& slab = slabs[index];
+    uint32_t slot = HANDLE_SLOT(handle);
+
+    if (int(HANDLE_CLASS(handle)) != slab.sizeClass || slot >= slab.used.size() || !slab.used[slot])
+        return false;
+
+    // A handle of a packet the slot held before.
+    if (HANDLE_GENERATION(handle) != slab.generations[slot])
+        return false;
+
+    slab.used[slot] = 0;
+    freeSlots[slab.sizeClass].push_back(static_cast<uint32_t>(handle));
+    retainedBytes -= SlotSize(slab.sizeClass);
+    return true;
+}
+
+uint8_t* PacketPool::Data(uint64_t handle) const {
+    const auto& slab = slabs[HANDLE_SLAB(handle)];
+
+    return slab.data + HANDLE_SLOT(handle) * SlotSize(slab.sizeClass);
+}
@@ -0,0 +1,79 @@
+#ifndef NPCAP_POOL_H
+#define NPCAP_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define POOL_SLAB_SIZE      (1 << 20)
+#define POOL_MIN_SLOT_SHIFT 7   // 128 bytes
+#define POOL_CLASSES        11  // 128 bytes to 128 KiB
+#define POOL_SLOT_BITS      13  // POOL_SLAB_SIZE >> POOL_MIN_SLOT_SHIFT slots at most
+#define POOL_CLASS_BITS     4
+#define POOL_MAX_SLABS      (1 << (32 - POOL_SLOT_BITS - POOL_CLASS_BITS))
+#define POOL_GENERATION_BITS 21 // Above the 32 bits of the slot, the handles stay exact JS numbers
+
+/**
+ * Size-classed slabs holding the packets retained by JS, so keeping a packet is a copy
+ * into a free slot instead of a new `Buffer`.
+ *
+ * The slabs are allocated by the session (JS `ArrayBuffer`s the retained packets are
+ * read from in place), the pool only hands out their slots. A slot is identified by
+ * a handle: `generation << 32 | slab << (POOL_CLASS_BITS + POOL_SLOT_BITS) | sizeClass << POOL_SLOT_BITS | slot`.
+ *
+ * The generation of a slot changes every time it's taken, the stale handles of the
+ * packets it held before can't release it.
+*/
+class PacketPool {
+    public:
+        PacketPool();
+
+        void Configure(size_t maxBytes);
+
+        // Size class of the slots holding `length` bytes, `-1` if it doesn't fit in a slot.
+        static int SizeClass(size_t length);
+        static size_t SlotSize(int sizeClass) { return size_t(1) << (POOL_MIN_SLOT_SHIFT + sizeClass); }
+
+        /**
+         * @brief Takes a free slot of the size class.
+         *
+         * Returns `false` when every slot is used, a slab must then be added with `AddSlab`.
+        */
+        bool Acquire(int sizeClass, uint64_t& handle);
+
+        // A slab of `POOL_SLAB_SIZE` bytes can be added without going over the limit.
+        bool CanGrow() const;
+
+        // Adds a slab to the size class, its slots become free. Returns the index of the slab.
+        uint32_t AddSlab(int sizeClass, uint8_t* data);
+
+        // Returns `false` if the handle doesn't designate a retained slot.
+        bool Release(uint64_t handle);
+
+        uint8_t* Data(uint64_t handle) const;
+
+        size_t Slabs() const { return slabs.size(); }
+        size_t RetainedBytes() const { return retainedBytes; }
+
+    private:
+        struct Slab {
+            uint8_t* data;
+            int sizeClass;
+
+            // One flag per slot, to reject the handles released twice.
+            std::vector<uint8_t> used;
+
+            // Generation of each slot, from the last time it was taken.
+            std::vector<uint32_t> generations;
+        };
+
+        std::vector<Slab> slabs;
+
+        // Free handles of each size class.
+        std::vector<uint32_t> freeSlots[POOL_CLASSES];
+
+        size_t maxBytes;
+        size_t retainedBytes;
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "common.h"
 #include "session.h"
+#include "parser.h"
+
+#include <random>
 
 napi_value Session::Init(napi_env env, napi_value exports) {
     napi_property_descriptor properties[] = {
@@ -7,6 +10,24 @@ napi_value Session::Init(napi_env env, napi_value exports) {
         DECLARE_METHOD("openOffline", OpenOffline),
         DECLARE_METHOD("stats", Stats),
         DECLARE_METHOD("inject", Inject),
+        DECLARE_METHOD("setSliceLength", SetSliceLength),
+        DECLARE_METHOD("setPatterns", SetPatterns),
+        DECLARE_METHOD("setFlowCutoff", SetFlowCutoff),
+        DECLARE_METHOD("setDirection", SetDirection),
+        DECLARE_METHOD("setDedupe", SetDedupe),
+        DECLARE_METHOD("setMetadata", SetMetadata),
+        DECLARE_METHOD("setBatch", SetBatch),
+        DECLARE_METHOD("setChecksums", SetChecksums),
+        DECLARE_METHOD("setReassembly", SetReassembly),
+        DECLARE_METHOD("setStreams", SetStreams),
+        DECLARE_METHOD("setDns", SetDns),
+        DECLARE_METHOD("setTunnels", SetTunnels),
+        DECLARE_METHOD("setHeaderArgs", SetHeaderArgs),
+        DECLARE_METHOD("setRetainLimit", SetRetainLimit),
+        DECLARE_METHOD("retain", Retain),
+        DECLARE_METHOD("release", Release),
+        DECLARE_METHOD("getSlab", GetSlab),
+        DECLARE_METHOD("setEnd", SetEnd),
         DECLARE_METHOD("close", Close)
     };
     
@@ -39,12 +60,47 @@ napi_value Session::Init(napi_env env, napi_value exports) {
 Session::Session(): env_(nullptr), wrapper_(nullptr) {
     pcapHandle = nullptr;
     pcapDumpHandle = nullptr;
+    linkType = -1;
+    parser = nullptr;
+    hashSeed = 0;
+
+    live = false;
+    onEndRef = nullptr;
 
     onPacketRef = nullptr;
+    headerArgs = false;
 
     headerData = nullptr;
+    headerLength = 0;
     bufferData = nullptr;
     bufferLength = 0;
+    metaData = nullptr;
+    maxTunnels = 0;
+
+    dnsData = nullptr;
+    onNamesRef = nullptr;
+
+    sliceLength = 0;
+    sliceHeaders = false;
+
+    direction = PCAP_D_INOUT;
+    dedupeLoopback = false;
+
+    verifyChecksums = false;
+    badChecksums = 0;
+
+    matchesData = nullptr;
+    matchesCapacity = 0;
+    onlyMatched = false;
+
+    onFlowEndRef = nullptr;
+    onBatchRef = nullptr;
+    onStreamRef = nullptr;
+
+    countDrops = false;
+    lastDrops = 0;
+    pendingDrops = 0;
+    packetSequence = 0;
 
     closing = false;
     handlingPackets = false;
@@ -64,6 +120,37 @@ Session::~Session() {
         ASSERT_CALL_VOID(env_, napi_delete_reference(env_, onPacketRef));
         onPacketRef = nullptr;
     }
+
+    if (onFlowEndRef) {
+        ASSERT_CALL_VOID(env_, napi_delete_reference(env_, onFlowEndRef));
+        onFlowEndRef = nullptr;
+    }
+
+    if (onBatchRef) {
+        ASSERT_CALL_VOID(env_, napi_delete_reference(env_, onBatchRef));
+        onBatchRef = nullptr;
+    }
+
+    if (onStreamRef) {
+        ASSERT_CALL_VOID(env_, napi_delete_reference(env_, onStreamRef));
+        onStreamRef = nullptr;
+    }
+
+    if (onNamesRef) {
+        ASSERT_CALL_VOID(env_, napi_delete_reference(env_, onNamesRef));
+        onNamesRef = nullptr;
+    }
+
+    if (onEndRef) {
+        ASSERT_CALL_VOID(env_, napi_delete_reference(env_, onEndRef));
+        onEndRef = nullptr;
+    }
+
+    // The slabs are freed by JS once the last retained packet reading them is collected.
+    for (auto slabRef : slabRefs)
+        ASSERT_CALL_VOID(env_, napi_delete_reference(env_, slabRef));
+
+    slabRefs.clear();
 }
 
 napi_value Session::New(napi_env env, napi_callback_info info) {
@@ -173,8 +260,8 @@ napi_value Session::Open(napi_env env, napi_callback_info info, bool live) {
         session->Close(env, info);
 
     // Get the header & buffer.
-    size_t headerLength = 0;
-    ASSERT_CALL(env, napi_get_buffer_info(env, argv[4], reinterpret_cast<void**>(&session->headerData), &headerLength));
+    ASSERT_CALL(env, napi_get_buffer_info(env, argv[4], reinterpret_cast<void**>(&session->headerData), &session->headerLength));
+    ASSERT_MESSAGE(env, session->headerLength >= 16, "The parameter `header` must be at least 16 bytes long.");
     ASSERT_CALL(env, napi_get_buffer_info(env, argv[5], reinterpret_cast<void**>(&session->bufferData), &session->bufferLength));
 
     auto device = GetStringFromArg(env, argv[0]);
@@ -223,12 +310,6 @@ napi_value Session::Open(napi_env env, napi_callback_info info, bool live) {
         }
 
         ASSERT_MESSAGE(env, pcap_activate(session->pcapHandle) == 0, pcap_geterr(session->pcapHandle));
-
-        if (!outFile.empty()) {
-            session->pcapDumpHandle = pcap_dump_open(session->pcapHandle, outFile.c_str());
-            ASSERT_MESSAGE(env, session->pcapDumpHandle != nullptr, "Can't open output dump file.");
-        }
-
         ASSERT_MESSAGE(env, pcap_setnonblock(session->pcapHandle, 1, errorBuffer) != -1, errorBuffer);
     } else {
         // Device is the path to the savefile
@@ -236,6 +317,17 @@ napi_value Session::Open(napi_env env, napi_callback_info info, bool live) {
         ASSERT_MESSAGE(env, session->pcapHandle != nullptr, errorBuffer);
     }
 
+    // A replayed file is saved too, e.g. to keep the packets of its filter.
+    if (!outFile.empty()) {
+        session->pcapDumpHandle = pcap_dump_open(session->pcapHandle, outFile.c_str());
+        ASSERT_MESSAGE(env, session->pcapDumpHandle != nullptr, "Can't open output dump file.");
+    }
+
+    session->live = live;
+    session->countDrops = live;
+    session->lastDrops = 0;
+    session->pendingDrops = 0;
+
 #if defined(_WIN32)
     // Set min bytes
     ASSERT_MESSAGE(env, pcap_setmintocopy(session->pcapHandle, minBytes) == 0, "Can't set the minBytes.");
@@ -251,6 +343,16 @@ napi_value Session::Open(napi_env env, napi_callback_info info, bool live) {
     }
 
     int linkType = pcap_datalink(session->pcapHandle);
+    session->linkType = linkType;
+    session->parser = GetPacketParser(linkType);
+
+    std::random_device random;
+    session->hashSeed = (static_cast<uint64_t>(random()) << 32) | random();
+    session->flows.Seed(session->hashSeed);
+    session->streams.Seed(session->hashSeed);
+    session->fragments.Seed(session->hashSeed);
+    session->duplicates.Seed(session->hashSeed);
+
     napi_value returnValue;
 
     switch (linkType) {
@@ -269,6 +371,9 @@ napi_value Session::Open(napi_env env, napi_callback_info info, bool live) {
         case DLT_LINUX_SLL:
             ASSERT_CALL(env, napi_create_string_utf8(env, "LINKTYPE_LINUX_SLL", NAPI_AUTO_LENGTH, &returnValue));
             break;
+        case DLT_LINUX_SLL2:
+            ASSERT_CALL(env, napi_create_string_utf8(env, "LINKTYPE_LINUX_SLL2", NAPI_AUTO_LENGTH, &returnValue));
+            break;
         default:
             char errorBuffer[PCAP_ERRBUF_SIZE];
             snprintf(errorBuffer, PCAP_ERRBUF_SIZE, "Unknown linktype %d", linkType);
@@ -347,6 +452,27 @@ napi_value Session::Stats(napi_env env, napi_callback_info info) {
     ASSERT_CALL(env, napi_create_int32(env, ps.ps_ifdrop, &value));
     ASSERT_CALL(env, napi_set_named_property(env, stats, "ps_ifdrop", value));
 
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->duplicates.Suppressed()), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "duplicates", value));
+
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->badChecksums), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "badChecksums", value));
+
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->fragments.reassembled), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "reassembled", value));
+
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->fragments.timeouts), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "fragmentTimeouts", value));
+
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->fragments.evictions), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "fragmentEvictions", value));
+
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->fragments.overlaps), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "fragmentOverlaps", value));
+
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(session->pool.RetainedBytes()), &value));
+    ASSERT_CALL(env, napi_set_named_property(env, stats, "retainedBytes", value));
+
     return stats;
 }
 
@@ -374,152 +500,1202 @@ napi_value Session::Inject(napi_env env, napi_callback_info info) {
     return ReturnBoolean(env, true);
 }
 
-napi_value Session::Close(napi_env env, napi_callback_info info) {
-    napi_value thisArg;
-    ASSERT_CALL(env, napi_get_cb_info(env, info, nullptr, nullptr, &thisArg, nullptr));
+napi_value Session::SetSliceLength(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 2, "Expecting 2 arguments.");
+
+    napi_valuetype type;
+
+    // argv[0]: { length: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `length` must be a Number.");
+
+    // argv[1]: { headers: boolean }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_boolean, "The argument `headers` must be a Boolean.");
 
-    // Unwrap the `this` object to get the Session pointer.
     Session* session;
     ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
 
-    if (session->pcapHandle && !session->closing) {
-        if (session->pcapDumpHandle != nullptr) {
-            pcap_dump_close(session->pcapDumpHandle);
-            session->pcapDumpHandle = nullptr;
-        }
+    auto length = GetNumberFromArg(env, argv[0]);
+    ASSERT_MESSAGE(env, length >= 0, "The argument `length` can't be negative.");
 
-#if defined(_WIN32)
-        if (session->pollWait) {
-            UnregisterWait(session->pollWait);
-            session->pollWait = nullptr;
-        }
+    session->sliceLength = static_cast<uint32_t>(length);
+    session->sliceHeaders = GetBooleanFromArg(env, argv[1]);
 
-        uv_close(reinterpret_cast<uv_handle_t*>(&session->pollAsync), CallbackClose);
-#else
-        uv_poll_stop(&session->pollHandle);
-#endif
+    return ReturnBoolean(env, true);
+}
 
-        session->closing = true;
-        session->Cleanup();
+napi_value Session::SetPatterns(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3], thisArg;
 
-        return ReturnBoolean(env, true);
-    }
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 3, "Expecting 3 arguments.");
 
-    return ReturnBoolean(env, false);
-}
+    // argv[0]: { patterns: Buffer[] }
+    bool isArray;
+    ASSERT_CALL(env, napi_is_array(env, argv[0], &isArray));
+    ASSERT_MESSAGE(env, isArray == true, "The argument `patterns` must be an Array of Buffers.");
 
-void Session::Cleanup() {
-    if (pcapHandle && !handlingPackets) {
-        pcap_close(pcapHandle);
-        
-        pcapHandle = nullptr;
+    // argv[1]: { matches: Buffer }
+    bool isBuffer;
+    ASSERT_CALL(env, napi_is_buffer(env, argv[1], &isBuffer));
+    ASSERT_MESSAGE(env, isBuffer == true, "The parameter `matches` must be a Buffer.");
 
-        headerData = nullptr;
-        bufferData = nullptr;
-        bufferLength = 0;
+    // argv[2]: { onlyMatched: boolean }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[2], &type));
+    ASSERT_MESSAGE(env, type == napi_boolean, "The argument `onlyMatched` must be a Boolean.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    uint32_t patternCount;
+    ASSERT_CALL(env, napi_get_array_length(env, argv[0], &patternCount));
+
+    char* matchesData = nullptr;
+    size_t matchesLength = 0;
+    ASSERT_CALL(env, napi_get_buffer_info(env, argv[1], reinterpret_cast<void**>(&matchesData), &matchesLength));
+    ASSERT_MESSAGE(env, matchesLength >= 4 * (patternCount + 1), "The buffer `matches` is too small.");
+
+    session->matcher.Clear();
+
+    for (uint32_t i = 0; i < patternCount; i++) {
+        napi_value pattern;
+        ASSERT_CALL(env, napi_get_element(env, argv[0], i, &pattern));
+
+        ASSERT_CALL(env, napi_is_buffer(env, pattern, &isBuffer));
+        ASSERT_MESSAGE(env, isBuffer == true, "The argument `patterns` must be an Array of Buffers.");
+
+        char* patternData = nullptr;
+        size_t patternLength = 0;
+        ASSERT_CALL(env, napi_get_buffer_info(env, pattern, reinterpret_cast<void**>(&patternData), &patternLength));
+
+        session->matcher.Add(reinterpret_cast<uint8_t*>(patternData), patternLength, i);
     }
+
+    session->matcher.Compile();
+
+    session->matchesData = reinterpret_cast<uint32_t*>(matchesData);
+    session->matchesCapacity = matchesLength / 4 - 1;
+    session->onlyMatched = GetBooleanFromArg(env, argv[2]);
+
+    return ReturnBoolean(env, true);
 }
 
-#if defined(_WIN32)
-void Session::CallbackPacket(uv_async_t* handle) {
-    auto session = reinterpret_cast<Session*>(handle->data);
+napi_value Session::SetFlowCutoff(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value argv[5], thisArg;
 
-    if (session->closing)
-        return session->Cleanup();
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 5, "Expecting 5 arguments.");
 
-    session->handlingPackets = true;
+    napi_valuetype type;
 
-    int packetCount;
-    do {
-        packetCount = pcap_dispatch(
-            session->pcapHandle,
-            1,
-            Session::EmitPacket,
-            reinterpret_cast<u_char*>(session)
-        );
-    } while (packetCount > 0 && !session->closing);
+    // argv[0]: { bytes: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `bytes` must be a Number.");
 
-    session->handlingPackets = false;
+    // argv[1]: { packets: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `packets` must be a Number.");
 
-    if (session->closing)
-        session->Cleanup();
-}
+    // argv[2]: { timeout: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[2], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `timeout` must be a Number.");
 
+    // argv[3]: { maxFlows: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[3], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxFlows` must be a Number.");
 
-void Session::OnPacket(void* data, boolean didTimeout) {
-    auto session = reinterpret_cast<Session*>(data);
+    // argv[4]: { onFlowEnd: (flow: FlowCutoffStats) => void }
+    ASSERT_CALL(env, napi_typeof(env, argv[4], &type));
+    ASSERT_MESSAGE(env, type == napi_function, "The argument `onFlowEnd` must be a Function `(flow: FlowCutoffStats) => void`.");
 
-    ASSERT_VOID(session->env_, !didTimeout);
-    int response = uv_async_send(reinterpret_cast<uv_async_t*>(data));
-    ASSERT_VOID(session->env_, response == 0);
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    auto bytes = GetNumberFromArg(env, argv[0]);
+    auto packets = GetNumberFromArg(env, argv[1]);
+    auto timeout = GetNumberFromArg(env, argv[2]);
+    auto maxFlows = GetNumberFromArg(env, argv[3]);
+    ASSERT_MESSAGE(env, bytes >= 0 && packets >= 0 && timeout > 0 && maxFlows > 0, "The flow cutoff limits must be positive.");
+
+    session->flows.Configure(bytes, packets, timeout, maxFlows);
+
+    if (session->onFlowEndRef)
+        ASSERT_CALL(env, napi_delete_reference(env, session->onFlowEndRef));
+
+    ASSERT_CALL(env, napi_create_reference(env, argv[4], 1, &session->onFlowEndRef));
+
+    return ReturnBoolean(env, true);
 }
 
-void Session::CallbackClose(uv_handle_t* handle) {
-    
+napi_value Session::SetDirection(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 2, "Expecting 2 arguments.");
+
+    napi_valuetype type;
+
+    // argv[0]: { direction: 'in' | 'out' | 'both' }
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_string, "The argument `direction` must be a String.");
+
+    // argv[1]: { dedupeLoopback: boolean }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_boolean, "The argument `dedupeLoopback` must be a Boolean.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+    ASSERT_MESSAGE(env, session->pcapHandle != nullptr, "The Session is closed.");
+
+    auto value = GetStringFromArg(env, argv[0]);
+    pcap_direction_t direction;
+
+    if (value == "in")
+        direction = PCAP_D_IN;
+    else if (value == "out")
+        direction = PCAP_D_OUT;
+    else if (value == "both")
+        direction = PCAP_D_INOUT;
+    else {
+        ASSERT_CALL(env, napi_throw_error(env, nullptr, "The argument `direction` must be 'in', 'out' or 'both'."));
+        return nullptr;
+    }
+
+    bool dedupeLoopback = GetBooleanFromArg(env, argv[1]);
+    bool recorded = HasPacketDirection(session->linkType);
+
+    // The loopback copies are only told apart by the Linux "cooked" headers.
+    ASSERT_MESSAGE(env, !dedupeLoopback || recorded, "The option `dedupeLoopback` needs a Linux cooked capture (the 'any' device).");
+
+    // Let the kernel drop the packets when the platform supports it, otherwise filter them natively.
+    bool kernel = direction == PCAP_D_INOUT || pcap_setdirection(session->pcapHandle, direction) == 0;
+    ASSERT_MESSAGE(env, kernel || recorded, "The capture direction can't be filtered on this device.");
+
+    session->dedupeLoopback = dedupeLoopback;
+    session->direction = kernel ? PCAP_D_INOUT : direction;
+
+    return ReturnBoolean(env, kernel);
 }
-#else
-void Session::CallbackPacket(uv_poll_t* handle, int status, int events) {
-    auto session = reinterpret_cast<Session*>(handle->data);
-    ASSERT_VOID(session->env_, status == 0);
 
-    if (session->closing)
-        return session->Cleanup();
+napi_value Session::SetDedupe(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2], thisArg;
 
-    if (!(events & UV_READABLE))
-        return;
-    
-    session->handlingPackets = true;
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 2, "Expecting 2 arguments.");
 
-    int packetCount;
-    do {
-        packetCount = pcap_dispatch(
-            session->pcapHandle,
-            1,
-            Session::EmitPacket,
-            reinterpret_cast<u_char*>(session)
-        );
-    } while (packetCount > 0 && !session->closing);
+    napi_valuetype type;
 
-    session->handlingPackets = false;
+    // argv[0]: { window: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `window` must be a Number.");
 
-    if (session->closing)
-        session->Cleanup();
+    // argv[1]: { size: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `size` must be a Number.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    auto window = GetNumberFromArg(env, argv[0]);
+    auto size = GetNumberFromArg(env, argv[1]);
+    ASSERT_MESSAGE(env, window >= 0 && size >= 0, "The dedupe `window` and `size` can't be negative.");
+
+    // The window is given in milliseconds.
+    session->duplicates.Configure(static_cast<uint64_t>(window) * 1000, size);
+
+    return ReturnBoolean(env, true);
 }
-#endif
 
-void Session::EmitPacket(u_char *s, const struct pcap_pkthdr* pkt_hdr, const u_char* packet) {
-    auto session = reinterpret_cast<Session*>(s);
+napi_value Session::SetMetadata(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
 
-    if (session->pcapDumpHandle != nullptr) {
-        pcap_dump(reinterpret_cast<u_char*>(session->pcapDumpHandle), pkt_hdr, packet);
-    }
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
 
-    // bool truncated = false;
-    size_t copyLen = pkt_hdr->caplen;
-    if (copyLen > session->bufferLength) {
-        copyLen = session->bufferLength;
-        // truncated = true;
+    // argv[0]: { meta: Buffer | null }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    if (type == napi_null) {
+        session->metaData = nullptr;
+        return ReturnBoolean(env, true);
     }
 
-    // Copy header data
-    memcpy(session->headerData, &(pkt_hdr->ts.tv_sec), 4);
-    memcpy(session->headerData + 4, &(pkt_hdr->ts.tv_usec), 4);
-    memcpy(session->headerData + 8, &(pkt_hdr->caplen), 4);
-    memcpy(session->headerData + 12, &(pkt_hdr->len), 4);
+    bool isBuffer;
+    ASSERT_CALL(env, napi_is_buffer(env, argv[0], &isBuffer));
+    ASSERT_MESSAGE(env, isBuffer == true, "The parameter `meta` must be a Buffer.");
+
+    char* metaData = nullptr;
+    size_t metaLength = 0;
+    ASSERT_CALL(env, napi_get_buffer_info(env, argv[0], reinterpret_cast<void**>(&metaData), &metaLength));
+    ASSERT_MESSAGE(env, metaLength >= sizeof(PacketMeta), "The buffer `meta` is too small.");
+    ASSERT_MESSAGE(env, reinterpret_cast<uintptr_t>(metaData) % alignof(PacketMeta) == 0, "The buffer `meta` is not aligned.");
 
-    // Copy buffer data
-    memcpy(session->bufferData, packet, copyLen);
+    session->metaData = reinterpret_cast<PacketMeta*>(metaData);
 
-    napi_handle_scope scope;
-    ASSERT_CALL_VOID(session->env_, napi_open_handle_scope(session->env_, &scope));
+    return ReturnBoolean(env, true);
+}
 
-    napi_value global, fn;
-    // napi_create_double(session->env_, copyLen, &args[0]);
-    // napi_create_int32(session->env_, truncated, &args[1]);
+napi_value Session::SetBatch(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value argv[4], thisArg;
 
-    ASSERT_CALL_VOID(session->env_, napi_get_global(session->env_, &global));
-    ASSERT_CALL_VOID(session->env_, napi_get_reference_value(session->env_, session->onPacketRef, &fn));
-    ASSERT_CALL_VOID(session->env_, napi_call_function(session->env_, global, fn, 0, nullptr, nullptr));
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 4, "Expecting 4 arguments.");
+
+    napi_valuetype type;
+    bool isBuffer;
+
+    // argv[0]: { columns: Buffer }
+    ASSERT_CALL(env, napi_is_buffer(env, argv[0], &isBuffer));
+    ASSERT_MESSAGE(env, isBuffer == true, "The parameter `columns` must be a Buffer.");
+
+    // argv[1]: { size: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `size` must be a Number.");
+
+    // argv[2]: { data: Buffer }
+    ASSERT_CALL(env, napi_is_buffer(env, argv[2], &isBuffer));
+    ASSERT_MESSAGE(env, isBuffer == true, "The parameter `data` must be a Buffer.");
+
+    // argv[3]: { onBatch: (count: number) => void }
+    ASSERT_CALL(env, napi_typeof(env, argv[3], &type));
+    ASSERT_MESSAGE(env, type == napi_function, "The argument `onBatch` must be a Function `(count: number) => void`.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    auto size = GetNumberFromArg(env, argv[1]);
+    ASSERT_MESSAGE(env, size > 0, "The argument `size` must be positive.");
+
+    uint8_t* columnsData = nullptr;
+    size_t columnsLength = 0;
+    ASSERT_CALL(env, napi_get_buffer_info(env, argv[0], reinterpret_cast<void**>(&columnsData), &columnsLength));
+    ASSERT_MESSAGE(env, columnsLength >= BATCH_COLUMNS_SIZE(size), "The buffer `columns` is too small.");
+    ASSERT_MESSAGE(env, reinterpret_cast<uintptr_t>(columnsData) % alignof(double) == 0, "The buffer `columns` is not aligned.");
+
+    uint8_t* data = nullptr;
+    size_t dataLength = 0;
+    ASSERT_CALL(env, napi_get_buffer_info(env, argv[2], reinterpret_cast<void**>(&data), &dataLength));
+
+    session->batch.Configure(columnsData, static_cast<uint32_t>(size), data, dataLength);
+
+    if (session->onBatchRef)
+        ASSERT_CALL(env, napi_delete_reference(env, session->onBatchRef));
+
+    ASSERT_CALL(env, napi_create_reference(env, argv[3], 1, &session->onBatchRef));
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetChecksums(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { verify: boolean }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_boolean, "The argument `verify` must be a Boolean.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    session->verifyChecksums = GetBooleanFromArg(env, argv[0]);
+    session->badChecksums = 0;
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetTunnels(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { depth: number }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `depth` must be a Number.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    int32_t depth = GetNumberFromArg(env, argv[0]);
+    session->maxTunnels = depth < 0 ? 0 : (depth > 255 ? 255 : depth);
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetHeaderArgs(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { enabled: boolean }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_boolean, "The argument `enabled` must be a Boolean.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    session->headerArgs = GetBooleanFromArg(env, argv[0]);
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetRetainLimit(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { maxBytes: number }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxBytes` must be a Number.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    double maxBytes;
+    ASSERT_CALL(env, napi_get_value_double(env, argv[0], &maxBytes));
+    ASSERT_MESSAGE(env, maxBytes >= 0, "The argument `maxBytes` must be positive.");
+
+    session->pool.Configure(static_cast<size_t>(maxBytes));
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::Retain(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { sequence: number }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `sequence` must be a Number.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+    ASSERT_MESSAGE(env, session->headerData != nullptr, "The Session is closed.");
+
+    uint32_t sequence;
+    ASSERT_CALL(env, napi_get_value_uint32(env, argv[0], &sequence));
+
+    // The header (`PacketHeader`) is copied in front of the captured bytes.
+    uint32_t caplen = *reinterpret_cast<uint32_t*>(session->headerData + 8);
+    if (caplen > session->bufferLength)
+        caplen = static_cast<uint32_t>(session->bufferLength);
+
+    int sizeClass = PacketPool::SizeClass(sizeof(PacketHeader) + caplen);
+    napi_value value;
+
+    // The buffers hold another packet now, or this one doesn't fit in a slot: JS gets `-1`.
+    if (sequence != session->packetSequence || sizeClass < 0) {
+        ASSERT_CALL(env, napi_create_int32(env, -1, &value));
+        return value;
+    }
+
+    uint64_t handle;
+
+    if (!session->pool.Acquire(sizeClass, handle)) {
+        if (!session->pool.CanGrow()) {
+            // The limit is reached, JS gets `-1`.
+            ASSERT_CALL(env, napi_create_int32(env, -1, &value));
+            return value;
+        }
+
+        void* data;
+        napi_value slab;
+        napi_ref slabRef;
+        ASSERT_CALL(env, napi_create_arraybuffer(env, POOL_SLAB_SIZE, &data, &slab));
+        ASSERT_CALL(env, napi_create_reference(env, slab, 1, &slabRef));
+
+        session->slabRefs.push_back(slabRef);
+        session->pool.AddSlab(sizeClass, static_cast<uint8_t*>(data));
+        session->pool.Acquire(sizeClass, handle);
+    }
+
+    uint8_t* slot = session->pool.Data(handle);
+    size_t headerLength = session->headerLength < sizeof(PacketHeader) ? session->headerLength : sizeof(PacketHeader);
+    memset(slot, 0, sizeof(PacketHeader));
+    memcpy(slot, session->headerData, headerLength);
+    memcpy(slot + sizeof(PacketHeader), session->bufferData, caplen);
+
+    // Report the bytes actually kept as the captured length.
+    memcpy(slot + 8, &caplen, sizeof(caplen));
+
+    // Up to 53 bits, exact as a JS number.
+    ASSERT_CALL(env, napi_create_double(env, static_cast<double>(handle), &value));
+    return value;
+}
+
+napi_value Session::Release(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { handle: number }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `handle` must be a Number.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    int64_t handle;
+    ASSERT_CALL(env, napi_get_value_int64(env, argv[0], &handle));
+    ASSERT_MESSAGE(env, handle >= 0 && session->pool.Release(static_cast<uint64_t>(handle)), "The packet was already released.");
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::GetSlab(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { index: number }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `index` must be a Number.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    int32_t index = GetNumberFromArg(env, argv[0]);
+    ASSERT_MESSAGE(env, index >= 0 && static_cast<size_t>(index) < session->slabRefs.size(), "The argument `index` is out of range.");
+
+    napi_value slab;
+    ASSERT_CALL(env, napi_get_reference_value(env, session->slabRefs[index], &slab));
+    return slab;
+}
+
+napi_value Session::SetReassembly(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value argv[4], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 4, "Expecting 4 arguments.");
+
+    napi_valuetype type;
+
+    // argv[0]: { timeout: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `timeout` must be a Number.");
+
+    // argv[1]: { maxDatagrams: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxDatagrams` must be a Number.");
+
+    // argv[2]: { maxPerSource: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[2], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxPerSource` must be a Number.");
+
+    // argv[3]: { overlap: 'first' | 'last' | 'drop' }
+    ASSERT_CALL(env, napi_typeof(env, argv[3], &type));
+    ASSERT_MESSAGE(env, type == napi_string, "The argument `overlap` must be a String.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    auto timeout = GetNumberFromArg(env, argv[0]);
+    auto maxDatagrams = GetNumberFromArg(env, argv[1]);
+    auto maxPerSource = GetNumberFromArg(env, argv[2]);
+    ASSERT_MESSAGE(env, timeout > 0 && maxDatagrams >= 0 && maxPerSource > 0, "The reassembly limits must be positive.");
+
+    auto overlap = GetStringFromArg(env, argv[3]);
+    OverlapPolicy policy;
+    if (overlap == "first")
+        policy = OVERLAP_FIRST;
+    else if (overlap == "last")
+        policy = OVERLAP_LAST;
+    else if (overlap == "drop")
+        policy = OVERLAP_DROP;
+    else {
+        ASSERT_CALL(env, napi_throw_error(env, nullptr, "The argument `overlap` must be 'first', 'last' or 'drop'."));
+        return nullptr;
+    }
+
+    session->fragments.Configure(timeout, maxDatagrams, maxPerSource, policy);
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetStreams(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value argv[4], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 4, "Expecting 4 arguments.");
+
+    napi_valuetype type;
+
+    // argv[0]: { maxBuffered: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxBuffered` must be a Number.");
+
+    // argv[1]: { maxStreams: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxStreams` must be a Number.");
+
+    // argv[2]: { timeout: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[2], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `timeout` must be a Number.");
+
+    // argv[3]: { onStream: (chunk: StreamChunk) => void }
+    ASSERT_CALL(env, napi_typeof(env, argv[3], &type));
+    ASSERT_MESSAGE(env, type == napi_function, "The argument `onStream` must be a Function `(chunk: StreamChunk) => void`.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    auto maxBuffered = GetNumberFromArg(env, argv[0]);
+    auto maxStreams = GetNumberFromArg(env, argv[1]);
+    auto timeout = GetNumberFromArg(env, argv[2]);
+    ASSERT_MESSAGE(env, maxBuffered >= 0 && maxStreams >= 0 && timeout > 0, "The stream limits must be positive.");
+
+    session->streams.Configure(maxBuffered, maxStreams, timeout);
+
+    if (session->onStreamRef)
+        ASSERT_CALL(env, napi_delete_reference(env, session->onStreamRef));
+
+    ASSERT_CALL(env, napi_create_reference(env, argv[3], 1, &session->onStreamRef));
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetDns(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 3, "Expecting 3 arguments.");
+
+    napi_valuetype type;
+    bool isBuffer;
+
+    // argv[0]: { record: Buffer }
+    ASSERT_CALL(env, napi_is_buffer(env, argv[0], &isBuffer));
+    ASSERT_MESSAGE(env, isBuffer == true, "The parameter `record` must be a Buffer.");
+
+    // argv[1]: { maxNames: number }
+    ASSERT_CALL(env, napi_typeof(env, argv[1], &type));
+    ASSERT_MESSAGE(env, type == napi_number, "The argument `maxNames` must be a Number.");
+
+    // argv[2]: { onNames: (firstId: number, names: string[]) => void }
+    ASSERT_CALL(env, napi_typeof(env, argv[2], &type));
+    ASSERT_MESSAGE(env, type == napi_function, "The argument `onNames` must be a Function `(firstId: number, names: string[]) => void`.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    char* recordData = nullptr;
+    size_t recordLength = 0;
+    ASSERT_CALL(env, napi_get_buffer_info(env, argv[0], reinterpret_cast<void**>(&recordData), &recordLength));
+    ASSERT_MESSAGE(env, recordLength >= sizeof(DnsRecord), "The buffer `record` is too small.");
+    ASSERT_MESSAGE(env, reinterpret_cast<uintptr_t>(recordData) % alignof(DnsRecord) == 0, "The buffer `record` is not aligned.");
+
+    auto maxNames = GetNumberFromArg(env, argv[1]);
+    ASSERT_MESSAGE(env, maxNames > 0, "The argument `maxNames` must be positive.");
+
+    session->dnsData = reinterpret_cast<DnsRecord*>(recordData);
+    session->dnsData->status = DNS_NONE;
+    session->dnsNames.Configure(maxNames);
+
+    if (session->onNamesRef)
+        ASSERT_CALL(env, napi_delete_reference(env, session->onNamesRef));
+
+    ASSERT_CALL(env, napi_create_reference(env, argv[2], 1, &session->onNamesRef));
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::SetEnd(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1], thisArg;
+
+    ASSERT_CALL(env, napi_get_cb_info(env, info, &argc, argv, &thisArg, nullptr));
+    ASSERT_MESSAGE(env, argc == 1, "Expecting 1 argument.");
+
+    // argv[0]: { onEnd: () => void }
+    napi_valuetype type;
+    ASSERT_CALL(env, napi_typeof(env, argv[0], &type));
+    ASSERT_MESSAGE(env, type == napi_function, "The argument `onEnd` must be a Function `() => void`.");
+
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    if (session->onEndRef)
+        ASSERT_CALL(env, napi_delete_reference(env, session->onEndRef));
+
+    ASSERT_CALL(env, napi_create_reference(env, argv[0], 1, &session->onEndRef));
+
+    return ReturnBoolean(env, true);
+}
+
+napi_value Session::Close(napi_env env, napi_callback_info info) {
+    napi_value thisArg;
+    ASSERT_CALL(env, napi_get_cb_info(env, info, nullptr, nullptr, &thisArg, nullptr));
+
+    // Unwrap the `this` object to get the Session pointer.
+    Session* session;
+    ASSERT_CALL(env, napi_unwrap(env, thisArg, reinterpret_cast<void**>(&session)));
+
+    if (session->pcapHandle && !session->closing) {
+        if (session->pcapDumpHandle != nullptr) {
+            pcap_dump_close(session->pcapDumpHandle);
+            session->pcapDumpHandle = nullptr;
+        }
+
+#if defined(_WIN32)
+        if (session->pollWait) {
+            UnregisterWait(session->pollWait);
+            session->pollWait = nullptr;
+        }
+
+        uv_close(reinterpret_cast<uv_handle_t*>(&session->pollAsync), CallbackClose);
+#else
+        uv_poll_stop(&session->pollHandle);
+#endif
+
+        session->closing = true;
+
+        // The flows and streams still open are reported while JS is still listening (even from a packet callback).
+        session->Finish();
+        session->Cleanup();
+
+        return ReturnBoolean(env, true);
+    }
+
+    return ReturnBoolean(env, false);
+}
+
+void Session::Cleanup() {
+    if (pcapHandle && !handlingPackets) {
+        pcap_close(pcapHandle);
+        
+        pcapHandle = nullptr;
+
+        headerData = nullptr;
+        bufferData = nullptr;
+        bufferLength = 0;
+        metaData = nullptr;
+        dnsData = nullptr;
+    }
+}
+
+#if defined(_WIN32)
+void Session::CallbackPacket(uv_async_t* handle) {
+    auto session = reinterpret_cast<Session*>(handle->data);
+
+    if (session->closing)
+        return session->Cleanup();
+
+    session->handlingPackets = true;
+    session->UpdateDrops();
+
+    int packetCount;
+    do {
+        packetCount = pcap_dispatch(
+            session->pcapHandle,
+            1,
+            Session::EmitPacket,
+            reinterpret_cast<u_char*>(session)
+        );
+    } while (packetCount > 0 && !session->closing);
+
+    session->handlingPackets = false;
+    session->EmitBatch();
+    session->streams.Flush();
+    session->EmitStreams();
+    session->EmitFlowEnds();
+
+    if (session->closing)
+        session->Cleanup();
+    else if (!session->live && packetCount <= 0)
+        session->EndOfFile();
+}
+
+
+void Session::OnPacket(void* data, boolean didTimeout) {
+    auto session = reinterpret_cast<Session*>(data);
+
+    ASSERT_VOID(session->env_, !didTimeout);
+    int response = uv_async_send(reinterpret_cast<uv_async_t*>(data));
+    ASSERT_VOID(session->env_, response == 0);
+}
+
+void Session::CallbackClose(uv_handle_t* handle) {
+    
+}
+#else
+void Session::CallbackPacket(uv_poll_t* handle, int status, int events) {
+    auto session = reinterpret_cast<Session*>(handle->data);
+    ASSERT_VOID(session->env_, status == 0);
+
+    if (session->closing)
+        return session->Cleanup();
+
+    if (!(events & UV_READABLE))
+        return;
+    
+    session->handlingPackets = true;
+    session->UpdateDrops();
+
+    int packetCount;
+    do {
+        packetCount = pcap_dispatch(
+            session->pcapHandle,
+            1,
+            Session::EmitPacket,
+            reinterpret_cast<u_char*>(session)
+        );
+    } while (packetCount > 0 && !session->closing);
+
+    session->handlingPackets = false;
+    session->EmitBatch();
+    session->streams.Flush();
+    session->EmitStreams();
+    session->EmitFlowEnds();
+
+    if (session->closing)
+        session->Cleanup();
+    else if (!session->live && packetCount <= 0)
+        session->EndOfFile();
+}
+#endif
+
+void Session::Finish() {
+    EmitBatch();
+    streams.Flush();
+    streams.Finish();
+    EmitStreams();
+
+    flows.Flush();
+    EmitFlowEnds();
+}
+
+void Session::EndOfFile() {
+#if defined(_WIN32)
+    if (pollWait) {
+        UnregisterWait(pollWait);
+        pollWait = nullptr;
+    }
+#else
+    uv_poll_stop(&pollHandle);
+#endif
+
+    Finish();
+
+    // Closed by one of the callbacks.
+    if (closing || !onEndRef)
+        return;
+
+    napi_handle_scope scope;
+    ASSERT_CALL_VOID(env_, napi_open_handle_scope(env_, &scope));
+
+    napi_value global, fn;
+    ASSERT_CALL_VOID(env_, napi_get_global(env_, &global));
+    ASSERT_CALL_VOID(env_, napi_get_reference_value(env_, onEndRef, &fn));
+    ASSERT_CALL_VOID(env_, napi_call_function(env_, global, fn, 0, nullptr, nullptr));
+
+    ASSERT_CALL_VOID(env_, napi_close_handle_scope(env_, scope));
+}
+
+void Session::UpdateDrops() {
+    struct pcap_stat ps;
+
+    if (!countDrops || pcap_stats(pcapHandle, &ps) != 0)
+        return;
+
+    uint64_t drops = static_cast<uint64_t>(ps.ps_drop) + ps.ps_ifdrop;
+
+    // The counters can be reset (or wrap) by the driver.
+    if (drops > lastDrops)
+        pendingDrops += static_cast<uint32_t>(drops - lastDrops);
+
+    lastDrops = drops;
+}
+
+void Session::EmitFlowEnds() {
+    if (flows.ended.empty() || !onFlowEndRef)
+        return;
+
+    napi_handle_scope scope;
+    ASSERT_CALL_VOID(env_, napi_open_handle_scope(env_, &scope));
+
+    napi_value global, fn;
+    ASSERT_CALL_VOID(env_, napi_get_global(env_, &global));
+    ASSERT_CALL_VOID(env_, napi_get_reference_value(env_, onFlowEndRef, &fn));
+
+    // Swap them out first, a callback closing the session flushes the table again.
+    std::vector<FlowCounters> ended;
+    ended.swap(flows.ended);
+
+    for (auto& counters : ended) {
+        napi_value flow, value;
+        ASSERT_CALL_VOID(env_, napi_create_object(env_, &flow));
+
+        ASSERT_CALL_VOID(env_, napi_create_string_utf8(env_, counters.key.AddressA().c_str(), NAPI_AUTO_LENGTH, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "addressA", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_uint32(env_, counters.key.portA, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "portA", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_string_utf8(env_, counters.key.AddressB().c_str(), NAPI_AUTO_LENGTH, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "addressB", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_uint32(env_, counters.key.portB, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "portB", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_uint32(env_, counters.key.protocol, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "protocol", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(counters.packets), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "packets", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(counters.bytes), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "bytes", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(counters.cutoffPackets), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "cutoffPackets", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(counters.cutoffBytes), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "cutoffBytes", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, counters.firstSeen, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "firstSeen", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, counters.lastSeen, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, flow, "lastSeen", value));
+
+        ASSERT_CALL_VOID(env_, napi_call_function(env_, global, fn, 1, &flow, nullptr));
+    }
+
+    ASSERT_CALL_VOID(env_, napi_close_handle_scope(env_, scope));
+}
+
+void Session::EmitStreams() {
+    if (streams.chunks.empty() || !onStreamRef)
+        return;
+
+    napi_handle_scope scope;
+    ASSERT_CALL_VOID(env_, napi_open_handle_scope(env_, &scope));
+
+    napi_value global, fn;
+    ASSERT_CALL_VOID(env_, napi_get_global(env_, &global));
+    ASSERT_CALL_VOID(env_, napi_get_reference_value(env_, onStreamRef, &fn));
+
+    // Swap them out first, the callbacks must not see the chunks of the next read.
+    std::vector<StreamChunk> chunks;
+    chunks.swap(streams.chunks);
+    streams.chunkBytes = 0;
+
+    for (auto& chunk : chunks) {
+        napi_value object, value;
+        ASSERT_CALL_VOID(env_, napi_create_object(env_, &object));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(chunk.id), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "id", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_string_utf8(env_, (chunk.fromA ? chunk.key.AddressA() : chunk.key.AddressB()).c_str(), NAPI_AUTO_LENGTH, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "saddr", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_uint32(env_, chunk.fromA ? chunk.key.portA : chunk.key.portB, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "sport", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_string_utf8(env_, (chunk.fromA ? chunk.key.AddressB() : chunk.key.AddressA()).c_str(), NAPI_AUTO_LENGTH, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "daddr", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_uint32(env_, chunk.fromA ? chunk.key.portB : chunk.key.portA, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "dport", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(chunk.offset), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "offset", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_double(env_, static_cast<double>(chunk.gap), &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "gap", value));
+
+        ASSERT_CALL_VOID(env_, napi_get_boolean(env_, chunk.end, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "end", value));
+
+        ASSERT_CALL_VOID(env_, napi_create_buffer_copy(env_, chunk.data.size(), chunk.data.data(), nullptr, &value));
+        ASSERT_CALL_VOID(env_, napi_set_named_property(env_, object, "data", value));
+
+        ASSERT_CALL_VOID(env_, napi_call_function(env_, global, fn, 1, &object, nullptr));
+    }
+
+    ASSERT_CALL_VOID(env_, napi_close_handle_scope(env_, scope));
+}
+
+void Session::EmitNames() {
+    if (dnsNames.delivered >= dnsNames.names.size() || !onNamesRef)
+        return;
+
+    napi_handle_scope scope;
+    ASSERT_CALL_VOID(env_, napi_open_handle_scope(env_, &scope));
+
+    napi_value global, fn, argv[2];
+    ASSERT_CALL_VOID(env_, napi_get_global(env_, &global));
+    ASSERT_CALL_VOID(env_, napi_get_reference_value(env_, onNamesRef, &fn));
+
+    size_t count = dnsNames.names.size() - dnsNames.delivered;
+
+    ASSERT_CALL_VOID(env_, napi_create_uint32(env_, static_cast<uint32_t>(dnsNames.delivered), &argv[0]));
+    ASSERT_CALL_VOID(env_, napi_create_array_with_length(env_, count, &argv[1]));
+
+    for (size_t i = 0; i < count; i++) {
+        auto& name = dnsNames.names[dnsNames.delivered + i];
+
+        // Labels may hold any byte, like the JS decoder they're read as latin1.
+        napi_value value;
+        ASSERT_CALL_VOID(env_, napi_create_string_latin1(env_, name.data(), name.size(), &value));
+        ASSERT_CALL_VOID(env_, napi_set_element(env_, argv[1], static_cast<uint32_t>(i), value));
+    }
+
+    dnsNames.delivered = dnsNames.names.size();
+
+    ASSERT_CALL_VOID(env_, napi_call_function(env_, global, fn, 2, argv, nullptr));
+    ASSERT_CALL_VOID(env_, napi_close_handle_scope(env_, scope));
+}
+
+void Session::EmitBatch() {
+    if (batch.Empty() || !onBatchRef)
+        return;
+
+    napi_handle_scope scope;
+    ASSERT_CALL_VOID(env_, napi_open_handle_scope(env_, &scope));
+
+    napi_value global, fn, count;
+    ASSERT_CALL_VOID(env_, napi_get_global(env_, &global));
+    ASSERT_CALL_VOID(env_, napi_get_reference_value(env_, onBatchRef, &fn));
+    ASSERT_CALL_VOID(env_, napi_create_uint32(env_, batch.Count(), &count));
+
+    // Clear before calling JS, the columns are overwritten by the next batch anyway.
+    batch.Clear();
+
+    ASSERT_CALL_VOID(env_, napi_call_function(env_, global, fn, 1, &count, nullptr));
+    ASSERT_CALL_VOID(env_, napi_close_handle_scope(env_, scope));
+}
+
+void Session::EmitPacket(u_char *s, const struct pcap_pkthdr* pkt_hdr, const u_char* packet) {
+    auto session = reinterpret_cast<Session*>(s);
+
+    if (session->direction != PCAP_D_INOUT || session->dedupeLoopback) {
+        bool loopback;
+        auto direction = GetPacketDirection(session->linkType, packet, pkt_hdr->caplen, loopback);
+
+        // Loopback traffic is captured twice (outgoing & incoming), keep the incoming copy.
+        if (session->dedupeLoopback && loopback && direction == DIRECTION_OUT)
+            return;
+
+        if ((session->direction == PCAP_D_IN && direction == DIRECTION_OUT) || (session->direction == PCAP_D_OUT && direction == DIRECTION_IN))
+            return;
+    }
+
+    // Parse straight into the record shared with JS when it's enabled.
+    PacketMeta localMeta;
+    PacketMeta& meta = session->metaData != nullptr ? *session->metaData : localMeta;
+
+    bool parsed = (session->metaData != nullptr || session->batch.Enabled() || session->verifyChecksums || session->fragments.Enabled() || session->streams.Enabled() || session->dnsData != nullptr || session->sliceHeaders || !session->matcher.Empty() || session->flows.Enabled() || session->duplicates.Enabled())
+        && session->parser(session->linkType, packet, pkt_hdr->caplen, meta, session->maxTunnels, session->hashSeed);
+
+    if (session->duplicates.Enabled()) {
+        uint64_t timestamp = static_cast<uint64_t>(pkt_hdr->ts.tv_sec) * 1000000 + pkt_hdr->ts.tv_usec;
+
+        if (session->duplicates.IsDuplicate(packet, pkt_hdr->caplen, meta, timestamp))
+            return;
+    }
+
+    // Fragments are dumped as they arrive, their datagram goes on once it's complete. The flow of a
+    // fragment is only known from its datagram: under a flow cutoff, the fragments are kept and
+    // dumped with the datagram (the ones of a datagram never completed are not).
+    struct pcap_pkthdr datagramHeader;
+    bool reassembled = false;
+    bool keepFragments = session->pcapDumpHandle != nullptr && session->flows.Enabled();
+
+    if (session->fragments.Enabled() && (meta.flags & META_FRAGMENT)) {
+        double timestamp = pkt_hdr->ts.tv_sec + pkt_hdr->ts.tv_usec / 1000000.0;
+        auto result = session->fragments.Add(packet, pkt_hdr->caplen, meta, timestamp, keepFragments ? pkt_hdr : nullptr);
+
+        if (result != FRAGMENT_PASS) {
+            if (session->pcapDumpHandle != nullptr && !keepFragments)
+                pcap_dump(reinterpret_cast<u_char*>(session->pcapDumpHandle), pkt_hdr, packet);
+
+            if (result == FRAGMENT_HELD)
+                return;
+
+            auto& datagram = session->fragments.Output();
+
+            datagramHeader.ts = pkt_hdr->ts;
+            datagramHeader.caplen = static_cast<bpf_u_int32>(datagram.size());
+            datagramHeader.len = datagramHeader.caplen;
+
+            pkt_hdr = &datagramHeader;
+            packet = datagram.data();
+
+            parsed = session->parser(session->linkType, packet, pkt_hdr->caplen, meta, session->maxTunnels, session->hashSeed);
+            reassembled = true;
+        }
+    }
+
+    // Flows over their budget are only counted, neither dumped nor delivered.
+    if (session->flows.Enabled()) {
+        double timestamp = pkt_hdr->ts.tv_sec + pkt_hdr->ts.tv_usec / 1000000.0;
+
+        if (!session->flows.Account(meta, timestamp))
+            return;
+    }
+
+    if (session->streams.Enabled()) {
+        double timestamp = pkt_hdr->ts.tv_sec + pkt_hdr->ts.tv_usec / 1000000.0;
+
+        session->streams.Add(packet, pkt_hdr->caplen, meta, timestamp);
+
+        if (session->streams.chunkBytes >= STREAM_FLUSH_BYTES)
+            session->EmitStreams();
+    }
+
+    if (session->verifyChecksums && meta.ipVersion != 0) {
+        VerifyChecksums(session->linkType, packet, pkt_hdr->caplen, meta);
+
+        if (meta.flags & (META_IP_CHECKSUM_BAD | META_L4_CHECKSUM_BAD))
+            session->badChecksums++;
+    }
+
+    if (session->pcapDumpHandle != nullptr && !reassembled) {
+        pcap_dump(reinterpret_cast<u_char*>(session->pcapDumpHandle), pkt_hdr, packet);
+    } else if (reassembled && keepFragments) {
+        for (auto& fragment : session->fragments.Frames())
+            pcap_dump(reinterpret_cast<u_char*>(session->pcapDumpHandle), &fragment.header, fragment.data.data());
+    }
+
+    if (!session->matcher.Empty()) {
+        size_t matchCount = 0;
+
+        if (parsed) {
+            matchCount = session->matcher.Match(
+                packet + meta.payloadOffset,
+                pkt_hdr->caplen - meta.payloadOffset,
+                session->matchesData + 1,
+                session->matchesCapacity
+            );
+        }
+
+        if (matchCount == 0 && session->onlyMatched)
+            return;
+
+        session->matchesData[0] = static_cast<uint32_t>(matchCount < session->matchesCapacity ? matchCount : session->matchesCapacity);
+    }
+
+    uint32_t copyLen = pkt_hdr->caplen;
+
+    // Only deliver up to the end of the transport header.
+    if (session->sliceHeaders && parsed)
+        copyLen = meta.payloadOffset;
+
+    if (session->sliceLength > 0 && copyLen > session->sliceLength)
+        copyLen = session->sliceLength;
+
+    if (session->batch.Enabled()) {
+        if (!session->batch.Fits(copyLen))
+            session->EmitBatch();
+
+        session->batch.Add(pkt_hdr, packet, copyLen, meta);
+
+        if (session->batch.Full())
+            session->EmitBatch();
+
+        return;
+    }
+
+    if (copyLen > session->bufferLength)
+        copyLen = static_cast<uint32_t>(session->bufferLength);
+
+    if (session->dnsData != nullptr) {
+        session->dnsData->status = DNS_NONE;
+
+        if (parsed && meta.protocol == 17 && (IsDnsPort(meta.sport) || IsDnsPort(meta.dport))) {
+            uint32_t captured = pkt_hdr->caplen - meta.payloadOffset;
+
+            ParseDns(packet + meta.payloadOffset, captured < meta.payloadLength ? captured : meta.payloadLength, *session->dnsData, session->dnsNames);
+            session->EmitNames();
+        }
+    }
+
+    // The buffers are about to hold a new packet, the handlers of the previous one can't retain it anymore.
+    session->packetSequence++;
+
+    // Copy header data, `caplen` is the number of bytes copied into the buffer.
+    PacketHeader header;
+    header.tvSec32 = static_cast<uint32_t>(pkt_hdr->ts.tv_sec);
+    header.tvUsec = static_cast<uint32_t>(pkt_hdr->ts.tv_usec);
+    header.caplen = copyLen;
+    header.len = pkt_hdr->len;
+
+    if (session->headerLength >= sizeof(PacketHeader)) {
+        header.tvSec = static_cast<uint64_t>(pkt_hdr->ts.tv_sec);
+        header.tvNsec = header.tvUsec * 1000;
+        header.ifindex = session->linkType == DLT_LINUX_SLL2 && pkt_hdr->caplen >= 8
+            ? (uint32_t(packet[4]) << 24) | (uint32_t(packet[5]) << 16) | (uint32_t(packet[6]) << 8) | packet[7]
+            : 0;
+        header.drops = session->pendingDrops;
+        header.sequence = session->packetSequence;
+
+        session->pendingDrops = 0;
+        memcpy(session->headerData, &header, sizeof(PacketHeader));
+    } else {
+        memcpy(session->headerData, &header, 16);
+    }
+
+    // Copy buffer data
+    memcpy(session->bufferData, packet, copyLen);
+
+    napi_handle_scope scope;
+    ASSERT_CALL_VOID(session->env_, napi_open_handle_scope(session->env_, &scope));
+
+    napi_value global, fn;
+    ASSERT_CALL_VOID(session->env_, napi_get_global(session->env_, &global));
+    ASSERT_CALL_VOID(session->env_, napi_get_reference_value(session->env_, session->onPacketRef, &fn));
+
+    if (session->headerArgs) {
+        napi_value args[4];
+        ASSERT_CALL_VOID(session->env_, napi_create_double(session->env_, static_cast<double>(pkt_hdr->ts.tv_sec), &args[0]));
+        ASSERT_CALL_VOID(session->env_, napi_create_uint32(session->env_, static_cast<uint32_t>(pkt_hdr->ts.tv_usec), &args[1]));
+        ASSERT_CALL_VOID(session->env_, napi_create_uint32(session->env_, copyLen, &args[2]));
+        ASSERT_CALL_VOID(session->env_, napi_create_uint32(session->env_, pkt_hdr->len, &args[3]));
+        ASSERT_CALL_VOID(session->env_, napi_call_function(session->env_, global, fn, 4, args, nullptr));
+    } else {
+        ASSERT_CALL_VOID(session->env_, napi_call_function(session->env_, global, fn, 0, nullptr, nullptr));
+    }
     
     ASSERT_CALL_VOID(session->env_, napi_close_handle_scope(session->env_, scope));
 }
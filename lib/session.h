@@ -2,6 +2,44 @@
 #define NPCAP_SESSION_H
 
 #include <uv.h>
+#include "batch.h"
+#include "checksum.h"
+#include "dedupe.h"
+#include "dns.h"
+#include "flows.h"
+#include "fragments.h"
+#include "matcher.h"
+#include "parser.h"
+#include "pool.h"
+#include "streams.h"
+
+/**
+ * Header of the current packet, shared with JS (see `src/header.ts`), in host byte order.
+ *
+ * The first 16 bytes keep the 32-bit layout of the original header (`tv_sec`, `tv_usec`,
+ * `caplen`, `len`), the rest is only written when the header Buffer is large enough.
+*/
+struct PacketHeader {
+    uint32_t tvSec32;
+    uint32_t tvUsec;
+    uint32_t caplen;
+    uint32_t len;
+
+    // Seconds on 64 bits, they don't wrap in 2038.
+    uint64_t tvSec;
+    uint32_t tvNsec;
+
+    // Index of the capturing interface (LINUX_SLL2 captures), `0` when unknown.
+    uint32_t ifindex;
+
+    // Packets dropped (`ps_drop` + `ps_ifdrop`) since the previous packet, live captures only.
+    uint32_t drops;
+
+    // Number of the packet in the session (from `1`), `retain` only copies the current one.
+    uint32_t sequence;
+};
+
+static_assert(sizeof(PacketHeader) == 40, "PacketHeader layout is shared with JS");
 
 class Session {
     public:
@@ -22,6 +60,24 @@ class Session {
         static napi_value OpenOffline(napi_env env, napi_callback_info info);
         static napi_value Stats(napi_env env, napi_callback_info info);
         static napi_value Inject(napi_env env, napi_callback_info info);
+        static napi_value SetSliceLength(napi_env env, napi_callback_info info);
+        static napi_value SetPatterns(napi_env env, napi_callback_info info);
+        static napi_value SetFlowCutoff(napi_env env, napi_callback_info info);
+        static napi_value SetDirection(napi_env env, napi_callback_info info);
+        static napi_value SetDedupe(napi_env env, napi_callback_info info);
+        static napi_value SetMetadata(napi_env env, napi_callback_info info);
+        static napi_value SetBatch(napi_env env, napi_callback_info info);
+        static napi_value SetChecksums(napi_env env, napi_callback_info info);
+        static napi_value SetReassembly(napi_env env, napi_callback_info info);
+        static napi_value SetStreams(napi_env env, napi_callback_info info);
+        static napi_value SetDns(napi_env env, napi_callback_info info);
+        static napi_value SetTunnels(napi_env env, napi_callback_info info);
+        static napi_value SetHeaderArgs(napi_env env, napi_callback_info info);
+        static napi_value SetRetainLimit(napi_env env, napi_callback_info info);
+        static napi_value Retain(napi_env env, napi_callback_info info);
+        static napi_value Release(napi_env env, napi_callback_info info);
+        static napi_value GetSlab(napi_env env, napi_callback_info info);
+        static napi_value SetEnd(napi_env env, napi_callback_info info);
         static napi_value Close(napi_env env, napi_callback_info info);
 
     #if defined(_WIN32)
@@ -32,19 +88,99 @@ class Session {
         static void CallbackPacket(uv_poll_t* handle, int status, int events);
     #endif
 
+        void Finish();
+        void EndOfFile();
+        void EmitFlowEnds();
+        void EmitBatch();
+        void EmitStreams();
+        void EmitNames();
+        void UpdateDrops();
+
     private:
         napi_env env_;
         napi_ref wrapper_;
 
         napi_ref onPacketRef;
 
+        // `onPacketRef` is called with the header fields (`tv_sec`, `tv_usec`, `caplen`, `len`) as numbers.
+        bool headerArgs;
+
         pcap_t* pcapHandle;
         pcap_dumper_t* pcapDumpHandle;
+        int linkType;
+
+        // Capturing from a device, `false` when reading a file (`onEndRef` is called at its end).
+        bool live;
+        napi_ref onEndRef;
+
+        // Parser specialized for `linkType`, picked when the capture is opened.
+        PacketParser parser;
+
+        // Random key of the flow hashes and the hash tables, drawn when the capture is opened.
+        uint64_t hashSeed;
 
         char* headerData;
+        size_t headerLength;
+
+        // Drops counted by `pcap_stats` at the last read, the new ones go in the header of the next packet.
+        bool countDrops;
+        uint64_t lastDrops;
+        uint32_t pendingDrops;
         char* bufferData;
         size_t bufferLength;
 
+        // Parsed headers of the current packet, shared with JS.
+        PacketMeta* metaData;
+
+        // Encapsulations peeled by the parser, the flows, streams and filters then see the inner packet.
+        int maxTunnels;
+
+        // DNS message of the current packet, shared with JS, the new names are sent to `onNamesRef`.
+        DnsRecord* dnsData;
+        NameTable dnsNames;
+        napi_ref onNamesRef;
+
+        // Bytes delivered to JS (`0` means up to `bufferLength`), the dump file always gets the full packet.
+        uint32_t sliceLength;
+        bool sliceHeaders;
+
+        // Direction filtered natively when `pcap_setdirection` isn't supported.
+        pcap_direction_t direction;
+        bool dedupeLoopback;
+
+        // Checksums verified natively, reported with the `META_*_CHECKSUM_BAD` flags.
+        bool verifyChecksums;
+        uint64_t badChecksums;
+
+        // Copies of the same packet (SPAN / TAP feeds) dropped within a time window.
+        DuplicateFilter duplicates;
+
+        // IP fragments held until their datagram is complete, then delivered as a single packet.
+        FragmentTable fragments;
+
+        // Payload signatures, the matched ids are written to `matchesData` as `[count, ...ids]`.
+        PatternMatcher matcher;
+        uint32_t* matchesData;
+        size_t matchesCapacity;
+        bool onlyMatched;
+
+        // Per-flow cutoff, the flows that ended after being cut are reported to `onFlowEndRef`.
+        FlowTable flows;
+        napi_ref onFlowEndRef;
+
+        // TCP streams reassembled in order, delivered as chunks to `onStreamRef`.
+        StreamTable streams;
+        napi_ref onStreamRef;
+
+        // Copies of the packets retained by JS, in slabs shared with JS as `ArrayBuffer`s (`slabRefs`).
+        PacketPool pool;
+        uint32_t packetSequence;
+        std::vector<napi_ref> slabRefs;
+
+        // Packets delivered in batches (columns + bytes) to `onBatchRef` instead of one by one.
+        PacketBatch batch;
+        napi_ref onBatchRef;
+
         bool closing;
         bool handlingPackets;
 
@@ -0,0 +1,252 @@
+#include "streams.h"
+
+#include <cstring>
+
+// In-order data is moved to a chunk once it reaches this size.
+#define STREAM_CHUNK_SIZE 65536
+
+static inline uint32_t Read32(const u_char* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+StreamTable::StreamTable() {
+    chunkBytes = 0;
+
+    maxBuffered = 0;
+    maxStreams = 0;
+    timeout = 60;
+
+    nextId = 1;
+    lastExpire = 0;
+}
+
+void StreamTable::Configure(size_t maxBuffered, size_t maxStreams, double timeout) {
+    this->maxBuffered = maxBuffered;
+    this->maxStreams = maxStreams;
+    this->timeout = timeout;
+
+    streams.clear();
+    dirty.clear();
+    chunks.clear();
+    chunkBytes = 0;
+    lastExpire = 0;
+}
+
+void StreamTable::Seed(uint64_t seed) {
+    streams = StreamMap(0, FlowKeyHash(seed));
+    dirty.clear();
+}
+
+void StreamTable::Add(const u_char* packet, uint32_t caplen, const PacketMeta& meta, double timestamp) {
+    if (meta.protocol != 6 || !(meta.flags & META_PARSED) || (meta.flags & META_FRAGMENT))
+        return;
+
+    FlowKey key;
+    bool fromA;
+
+    if (!GetFlowKey(meta, key, fromA))
+        return;
+
+    // Sweep the idle streams at most once per second (of capture time).
+    if (timestamp - lastExpire >= 1) {
+        Expire(timestamp);
+        lastExpire = timestamp;
+    }
+
+    auto it = streams.find(key);
+    if (it == streams.end()) {
+        // Table full, the stream isn't reassembled.
+        if ((meta.tcpFlags & TCP_RST) || streams.size() >= maxStreams)
+            return;
+
+        Stream stream = {};
+        stream.key = key;
+        stream.id = nextId++;
+
+        it = streams.emplace(key, std::move(stream)).first;
+    }
+
+    Stream& stream = it->second;
+    Direction& direction = fromA ? stream.a : stream.b;
+
+    stream.lastSeen = timestamp;
+
+    uint32_t seq = Read32(packet + meta.l4Offset + 4);
+
+    // The SYN takes a sequence number, the data (if any) follows it.
+    if (meta.tcpFlags & TCP_SYN)
+        seq++;
+
+    // Without the handshake, the stream starts at the first segment seen.
+    if (!direction.started) {
+        direction.started = true;
+        direction.nextSeq = seq;
+    }
+
+    // A truncated capture leaves a gap, the next segment starts past the captured bytes.
+    uint32_t captured = meta.payloadOffset < caplen ? caplen - meta.payloadOffset : 0;
+    uint32_t length = meta.payloadLength < captured ? meta.payloadLength : captured;
+
+    if (length > 0 && !direction.finished) {
+        Insert(stream, direction, fromA, seq, packet + meta.payloadOffset, length);
+
+        if (!stream.dirty) {
+            stream.dirty = true;
+            dirty.push_back(key);
+        }
+    }
+
+    if (meta.tcpFlags & TCP_FIN) {
+        direction.finSeen = true;
+        direction.finSeq = seq + meta.payloadLength;
+    }
+
+    if (direction.finSeen && !direction.finished && direction.nextSeq == direction.finSeq) {
+        direction.finished = true;
+        Emit(stream, direction, fromA, true);
+    }
+
+    if ((meta.tcpFlags & TCP_RST) || (stream.a.finished && stream.b.finished))
+        End(it);
+}
+
+void StreamTable::Insert(Stream& stream, Direction& direction, bool fromA, uint32_t seq, const uint8_t* data, uint32_t length) {
+    int32_t relative = static_cast<int32_t>(seq - direction.nextSeq);
+
+    // Retransmitted bytes are dropped, the first copy wins.
+    if (relative < 0) {
+        uint32_t old = static_cast<uint32_t>(-static_cast<int64_t>(relative));
+        if (old >= length)
+            return;
+
+        data += old;
+        length -= old;
+        relative = 0;
+    }
+
+    if (relative == 0) {
+        Append(direction, data, length);
+        Drain(direction);
+
+        if (direction.ready.size() >= STREAM_CHUNK_SIZE)
+            Emit(stream, direction, fromA, false);
+
+        return;
+    }
+
+    // Out of order, keep the longest copy received at that offset.
+    auto& segment = direction.segments[direction.offset + relative];
+    if (segment.size() < length) {
+        direction.buffered += length - segment.size();
+        segment.assign(data, data + length);
+    }
+
+    while (direction.buffered > maxBuffered)
+        SkipGap(stream, direction, fromA);
+}
+
+void StreamTable::Append(Direction& direction, const uint8_t* data, size_t length) {
+    if (direction.ready.empty())
+        direction.readyOffset = direction.offset;
+
+    direction.ready.insert(direction.ready.end(), data, data + length);
+    direction.offset += length;
+    direction.nextSeq += static_cast<uint32_t>(length);
+}
+
+void StreamTable::Drain(Direction& direction) {
+    while (!direction.segments.empty()) {
+        auto it = direction.segments.begin();
+        if (it->first > direction.offset)
+            break;
+
+        uint64_t old = direction.offset - it->first;
+        if (old < it->second.size())
+            Append(direction, it->second.data() + old, it->second.size() - old);
+
+        direction.buffered -= it->second.size();
+        direction.segments.erase(it);
+    }
+}
+
+void StreamTable::SkipGap(Stream& stream, Direction& direction, bool fromA) {
+    auto it = direction.segments.begin();
+    uint64_t gap = it->first - direction.offset;
+
+    // The data before the gap goes in its own chunk.
+    Emit(stream, direction, fromA, false);
+
+    direction.readyGap += gap;
+    direction.offset += gap;
+    direction.nextSeq += static_cast<uint32_t>(gap);
+
+    Drain(direction);
+}
+
+void StreamTable::Emit(Stream& stream, Direction& direction, bool fromA, bool end) {
+    if (direction.ready.empty() && !end)
+        return;
+
+    StreamChunk chunk;
+    chunk.key = stream.key;
+    chunk.id = stream.id;
+    chunk.fromA = fromA;
+    chunk.offset = direction.ready.empty() ? direction.offset : direction.readyOffset;
+    chunk.gap = direction.readyGap;
+    chunk.end = end;
+    chunk.data.swap(direction.ready);
+
+    chunkBytes += chunk.data.size();
+    chunks.push_back(std::move(chunk));
+
+    direction.readyGap = 0;
+}
+
+void StreamTable::Flush() {
+    for (auto& key : dirty) {
+        auto it = streams.find(key);
+        if (it == streams.end())
+            continue;
+
+        Emit(it->second, it->second.a, true, false);
+        Emit(it->second, it->second.b, false, false);
+        it->second.dirty = false;
+    }
+
+    dirty.clear();
+}
+
+void StreamTable::Expire(double now) {
+    for (auto it = streams.begin(); it != streams.end();) {
+        if (now - it->second.lastSeen > timeout)
+            it = End(it);
+        else
+            ++it;
+    }
+}
+
+void StreamTable::Finish() {
+    for (auto it = streams.begin(); it != streams.end();)
+        it = End(it);
+
+    dirty.clear();
+}
+
+StreamTable::StreamMap::iterator StreamTable::End(StreamMap::iterator it) {
+    Stream& stream = it->second;
+
+    // Deliver what's left, skipping the holes that will never be filled.
+    Direction* directions[2] = { &stream.a, &stream.b };
+    for (int i = 0; i < 2; i++) {
+        Direction& direction = *directions[i];
+        if (!direction.started || direction.finished)
+            continue;
+
+        while (!direction.segments.empty())
+            SkipGap(stream, direction, i == 0);
+
+        Emit(stream, direction, i == 0, true);
+    }
+
+    return streams.erase(it);
+}
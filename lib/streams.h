@@ -0,0 +1,117 @@
+#ifndef NPCAP_STREAMS_H
+#define NPCAP_STREAMS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "flows.h"
+#include "parser.h"
+
+// Chunk bytes after which they are delivered without waiting for the end of the read.
+#define STREAM_FLUSH_BYTES (1 << 20)
+
+// Contiguous bytes of one direction of a TCP stream.
+struct StreamChunk {
+    FlowKey key;
+    uint64_t id;
+
+    // Sent by the endpoint `a` of the key.
+    bool fromA;
+
+    // Stream offset of `data[0]`, and bytes missing right before it.
+    uint64_t offset;
+    uint64_t gap;
+
+    // No more data will follow in this direction (FIN, RST, timeout or end of the capture).
+    bool end;
+
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Reorders the TCP segments of each connection into in-order byte streams.
+ *
+ * Out-of-order segments are buffered up to `maxBuffered` bytes per direction,
+ * past it the hole is given up and reported as a gap. The reassembled data is
+ * accumulated in `chunks` until the session delivers it.
+*/
+class StreamTable {
+    public:
+        StreamTable();
+
+        void Configure(size_t maxBuffered, size_t maxStreams, double timeout);
+        bool Enabled() const { return maxStreams > 0; }
+
+        void Add(const u_char* packet, uint32_t caplen, const PacketMeta& meta, double timestamp);
+
+        // Moves the data reassembled so far to `chunks`.
+        void Flush();
+
+        // Ends the streams idle for longer than the timeout.
+        void Expire(double now);
+
+        // Ends all the streams, at the end of the capture.
+        void Finish();
+
+        // Keys the hash of the table, the tracked streams are dropped.
+        void Seed(uint64_t seed);
+
+        std::vector<StreamChunk> chunks;
+        size_t chunkBytes;
+
+    private:
+        struct Direction {
+            bool started;
+            bool finished;
+
+            // Next expected sequence number and its stream offset.
+            uint32_t nextSeq;
+            uint64_t offset;
+
+            // Out-of-order segments by stream offset.
+            std::map<uint64_t, std::vector<uint8_t>> segments;
+            size_t buffered;
+
+            // In-order data not moved to `chunks` yet.
+            std::vector<uint8_t> ready;
+            uint64_t readyOffset;
+            uint64_t readyGap;
+
+            bool finSeen;
+            uint32_t finSeq;
+        };
+
+        struct Stream {
+            FlowKey key;
+            uint64_t id;
+            Direction a;
+            Direction b;
+            double lastSeen;
+            bool dirty;
+        };
+
+        typedef std::unordered_map<FlowKey, Stream, FlowKeyHash> StreamMap;
+
+        StreamMap streams;
+
+        // Streams with data in `ready`.
+        std::vector<FlowKey> dirty;
+
+        size_t maxBuffered;
+        size_t maxStreams;
+        double timeout;
+
+        uint64_t nextId;
+        double lastExpire;
+
+        void Insert(Stream& stream, Direction& direction, bool fromA, uint32_t seq, const uint8_t* data, uint32_t length);
+        void Append(Direction& direction, const uint8_t* data, size_t length);
+        void Drain(Direction& direction);
+        void SkipGap(Stream& stream, Direction& direction, bool fromA);
+        void Emit(Stream& stream, Direction& direction, bool fromA, bool end);
+        StreamMap::iterator End(StreamMap::iterator it);
+};
+
+#endif
@@ -0,0 +1,12 @@
+import { readFileSync, writeFileSync } from 'node:fs'
+import { resolve } from 'node:path'
+import { generateCpp, generateTs } from './layouts'
+import type { Schema } from './layouts'
+
+const root = resolve(import.meta.dirname, '..')
+const schema: Schema = JSON.parse(readFileSync(resolve(root, 'schema/layouts.json'), 'utf8'))
+
+writeFileSync(resolve(root, 'src/layouts.ts'), generateTs(schema))
+writeFileSync(resolve(root, 'lib/layouts.h'), generateCpp(schema))
+
+console.log(`Generated ${schema.layouts.length} layouts in src/layouts.ts and lib/layouts.h`)
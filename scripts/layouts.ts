@@ -0,0 +1,322 @@
+/**
+ * Generators of the protocol layouts described in `schema/layouts.json`.
+ *
+ * - `src/layouts.ts`: flyweight readers (`LayerView` subclasses) for the headers, and `read*s()`
+ *   functions for the repeated blocks.
+ * - `lib/layouts.h`: structs of offsets and inline readers used by the native parser.
+ *
+ * Both sides read the same offsets, masks and shifts, regenerate them with `bun codegen`
+ * after editing the schema (a test fails while they are out of date).
+ */
+
+export type FieldType = 'u8' | 'u16' | 'u32' | 'flag' | 'mac' | 'ipv4' | 'ipv6'
+
+export interface FieldSchema {
+    name: string
+    offset: number
+    type: FieldType
+
+    /** Bits of the field in the `u8` / `u16` / `u32` read at `offset` (the bit of a `flag`). */
+    mask?: string
+
+    /** Position of the lowest bit of `mask`. */
+    shift?: number
+
+    /** Unit of the field (a power of two), `4` for a header length in 32-bit words. */
+    scale?: number
+    doc?: string
+}
+
+export interface LayoutSchema {
+    name: string
+
+    /** Name used in the class and struct names, `name` capitalized by default. */
+    title?: string
+    ref: string
+
+    /** Length of the fixed part of the header, or the stride of a repeated block. */
+    size: number
+
+    /** A block repeated back to back (read as arrays of the field values). */
+    repeated?: boolean
+    fields: FieldSchema[]
+}
+
+export interface Schema {
+    layouts: LayoutSchema[]
+}
+
+export const GENERATED_NOTICE = '// Generated by scripts/codegen.ts from schema/layouts.json, do not edit.'
+
+const WIDTHS: Record<FieldType, number> = { u8: 1, u16: 2, u32: 4, flag: 1, mac: 6, ipv4: 4, ipv6: 16 }
+
+function title(layout: LayoutSchema) {
+    return layout.title ?? layout.name[0].toUpperCase() + layout.name.slice(1)
+}
+
+function pascal(name: string) {
+    return name[0].toUpperCase() + name.slice(1)
+}
+
+function constant(name: string) {
+    return name.replace(/([a-z0-9])([A-Z])/g, '$1_$2').toUpperCase()
+}
+
+function log2(value: number) {
+    return Math.log2(value)
+}
+
+function validate(layout: LayoutSchema, field: FieldSchema) {
+    const where = `${layout.name}.${field.name}`
+
+    if (field.offset + WIDTHS[field.type] > layout.size)
+        throw new Error(`${where} ends after the ${layout.size} bytes of the layout.`)
+
+    if (field.type === 'flag' && field.mask === undefined)
+        throw new Error(`${where} is a flag without a mask.`)
+
+    if (field.mask !== undefined && !['u8', 'u16', 'u32', 'flag'].includes(field.type))
+        throw new Error(`${where} has a mask but isn't an integer.`)
+
+    if (layout.repeated && !['u8', 'u16', 'u32'].includes(field.type))
+        throw new Error(`${where} must be an integer in a repeated layout.`)
+
+    const mask = field.mask === undefined ? 0 : Number(field.mask)
+    const shift = field.shift ?? 0
+    const scale = field.scale ?? 1
+
+    // The bits below `shift` must be cleared by the mask, the shifts are then merged.
+    if (((mask >>> shift) << shift) >>> 0 !== mask)
+        throw new Error(`${where} has bits of its mask below the shift.`)
+
+    if (!Number.isInteger(log2(scale)))
+        throw new Error(`${where} must have a power of two scale.`)
+}
+
+/**
+ * `raw & mask`, shifted down to the field and scaled, as a single shift.
+ */
+function bits(raw: string, field: FieldSchema) {
+    if (field.mask === undefined)
+        return raw
+
+    const shift = (field.shift ?? 0) - log2(field.scale ?? 1)
+    const masked = `(${raw} & ${field.mask})`
+
+    // JS bitwise operators are signed, the top bit of a `u32` needs the unsigned shift.
+    if (field.type === 'u32' && shift >= 0 && Number(field.mask) >= 0x80000000)
+        return `${masked} >>> ${shift}`
+
+    if (shift > 0)
+        return `${masked} >> ${shift}`
+
+    if (shift < 0)
+        return `${masked} << ${-shift}`
+
+    return masked.slice(1, -1)
+}
+
+function tsField(field: FieldSchema): string[] {
+    const at = field.offset === 0 ? 'this.offset' : `this.offset + ${field.offset}`
+    const doc = field.doc ? [`/** ${field.doc} */`] : []
+
+    switch (field.type) {
+        case 'u8':
+            return [...doc, `get ${field.name}() { return ${bits(`this.buffer[${at}]`, field)} }`]
+        case 'u16':
+            return [...doc, `get ${field.name}() { return ${bits(`this.view.getUint16(${at})`, field)} }`]
+        case 'u32':
+            return [...doc, `get ${field.name}() { return ${bits(`this.view.getUint32(${at})`, field)} }`]
+        case 'flag':
+            return [...doc, `get ${field.name}() { return (this.buffer[${at}] & ${field.mask}) !== 0 }`]
+        case 'mac':
+            return [...doc, `get ${field.name}() { return this.formatMac(${field.offset}) }`]
+        case 'ipv4':
+            return [
+                `/** \`${field.name}\` as an unsigned 32-bit number. */`,
+                `get ${field.name}4() { return this.view.getUint32(${at}) }`,
+                '',
+                ...doc,
+                `get ${field.name}() { return this.formatIPv4(${field.offset}) }`,
+            ]
+        case 'ipv6':
+            return [...doc, `get ${field.name}() { return this.formatIPv6(${field.offset}) }`]
+    }
+}
+
+function tsRepeatedRead(field: FieldSchema) {
+    const at = field.offset === 0 ? 'offset' : `offset + ${field.offset}`
+
+    switch (field.type) {
+        case 'u8':
+            return bits(`buffer[${at}]`, field)
+        case 'u16':
+            return bits(`buffer.readUInt16BE(${at})`, field)
+        default:
+            return bits(`buffer.readUInt32BE(${at})`, field)
+    }
+}
+
+function tsLayout(layout: LayoutSchema): string[] {
+    const name = title(layout)
+    const lines = [
+        layout.repeated
+            ? `/** Size in bytes of each block read by \`read${name}s\`. */`
+            : `/** Size in bytes of the fixed part of \`${name}Layout\`. */`,
+        `export const ${constant(layout.title ?? layout.name)}_SIZE = ${layout.size}`,
+        '',
+        `// ${layout.ref}`,
+    ]
+
+    if (layout.repeated) {
+        const reads = layout.fields.map(tsRepeatedRead).join(', ')
+
+        return [
+            ...lines,
+            `export function read${name}s(buffer: Buffer, offset: number, count: number): number[][] {`,
+            '    const blocks: number[][] = []',
+            '',
+            `    for (let i = 0; i < count; i++, offset += ${layout.size})`,
+            `        blocks.push([${reads}])`,
+            '',
+            '    return blocks',
+            '}',
+        ]
+    }
+
+    const body: string[] = []
+
+    for (const field of layout.fields) {
+        const getter = tsField(field)
+        const spaced = getter.length > 1
+
+        // Documented getters are kept apart, like the hand-written views.
+        if (spaced && body.length > 0 && body[body.length - 1] !== '')
+            body.push('')
+
+        body.push(...getter)
+
+        if (spaced)
+            body.push('')
+    }
+
+    if (body[body.length - 1] === '')
+        body.pop()
+
+    return [
+        ...lines,
+        `export class ${name}Layout extends LayerView {`,
+        ...body.map(line => line ? `    ${line}` : ''),
+        '}',
+    ]
+}
+
+export function generateTs(schema: Schema): string {
+    const blocks: string[][] = []
+
+    for (const layout of schema.layouts) {
+        layout.fields.forEach(field => validate(layout, field))
+        blocks.push(tsLayout(layout))
+    }
+
+    const imports = schema.layouts.some(layout => layout.repeated)
+        ? ['import type { Buffer } from \'node:buffer\'', 'import { LayerView } from \'./layout\'']
+        : ['import { LayerView } from \'./layout\'']
+
+    return [
+        GENERATED_NOTICE,
+        ...imports,
+        '',
+        blocks.map(block => block.join('\n')).join('\n\n'),
+        '',
+    ].join('\n')
+}
+
+function cppType(field: FieldSchema) {
+    if (field.type === 'flag')
+        return 'bool'
+
+    if ((field.scale ?? 1) > 1 || field.type === 'u32' || field.type === 'ipv4')
+        return 'uint32_t'
+
+    return field.type === 'u8' ? 'uint8_t' : 'uint16_t'
+}
+
+function cppField(field: FieldSchema): string[] {
+    const at = field.offset === 0 ? 'data' : `data + ${field.offset}`
+    const type = cppType(field)
+    const doc = field.doc ? [`// ${field.doc}`] : []
+    let value: string
+
+    switch (field.type) {
+        case 'u8':
+            value = bits(`data[${field.offset}]`, field)
+            break
+        case 'u16':
+            value = bits(`LayoutRead16(${at})`, field)
+            break
+        case 'u32':
+        case 'ipv4':
+            value = bits(`LayoutRead32(${at})`, field)
+            break
+        case 'flag':
+            value = `(data[${field.offset}] & ${field.mask}) != 0`
+            break
+        default:
+            // Copied as bytes, only the offset is needed.
+            return []
+    }
+
+    // The operators promote to `int`.
+    if (field.mask !== undefined && field.type !== 'flag' && type !== 'uint32_t')
+        value = `static_cast<${type}>(${value})`
+
+    return [...doc, `static inline ${type} ${pascal(field.name)}(const uint8_t* data) { return ${value}; }`]
+}
+
+function cppLayout(layout: LayoutSchema): string[] {
+    const offsets = layout.fields.map(field => `static constexpr uint32_t ${pascal(field.name)}Offset = ${field.offset};`)
+    const readers = layout.fields.flatMap(cppField)
+
+    return [
+        `// ${layout.ref}`,
+        `struct ${title(layout)}Layout {`,
+        `    static constexpr uint32_t Size = ${layout.size};`,
+        '',
+        ...offsets.map(line => `    ${line}`),
+        '',
+        ...readers.map(line => `    ${line}`),
+        '};',
+    ]
+}
+
+export function generateCpp(schema: Schema): string {
+    const blocks: string[][] = []
+
+    for (const layout of schema.layouts) {
+        layout.fields.forEach(field => validate(layout, field))
+        blocks.push(cppLayout(layout))
+    }
+
+    return [
+        GENERATED_NOTICE,
+        '#ifndef NPCAP_LAYOUTS_H',
+        '#define NPCAP_LAYOUTS_H',
+        '',
+        '#include <cstdint>',
+        '',
+        '// The fields are in network byte order.',
+        'static inline uint16_t LayoutRead16(const uint8_t* data) {',
+        '    return static_cast<uint16_t>((data[0] << 8) | data[1]);',
+        '}',
+        '',
+        'static inline uint32_t LayoutRead32(const uint8_t* data) {',
+        '    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];',
+        '}',
+        '',
+        blocks.map(block => block.join('\n')).join('\n\n'),
+        '',
+        '#endif',
+        '',
+    ].join('\n')
+}
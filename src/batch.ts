@@ -0,0 +1,80 @@
+import { Buffer } from 'node:buffer'
+
+/** Bytes needed by the columns of a batch of `size` packets (`BATCH_COLUMNS_SIZE` in `lib/batch.h`). */
+export function batchColumnsSize(size: number) {
+    return size * 38 + 4
+}
+
+/**
+ * Packets delivered at once as a struct-of-arrays, filled natively.
+ *
+ * The columns hold `size` entries but only the first `count` belong to the current batch,
+ * both the columns and `data` are overwritten by the next batch.
+ *
+ * @example
+ *
+ * session.on('batch', (batch) => {
+ *     for (let i = 0; i < batch.count; i++)
+ *         bytes[batch.protocol[i]] += batch.lengths[i]
+ * })
+ */
+export class PacketBatch {
+    /** Number of packets in the batch. */
+    count = 0
+
+    /** Raw columns shared with the native session. */
+    columns: Buffer
+
+    /** Captured bytes of the packets, back to back. */
+    data: Buffer
+
+    /** Capture time, in seconds since the epoch. */
+    timestamps: Float64Array
+
+    /** Direction independent hash of the 5-tuple, see `PacketMeta.flowHash`. */
+    flowHash: BigUint64Array
+
+    /** IPv4 source address as a number, `0` for other packets. */
+    saddr: Uint32Array
+
+    /** IPv4 destination address as a number, `0` for other packets. */
+    daddr: Uint32Array
+
+    /** Length of the packet on the wire. */
+    lengths: Uint32Array
+
+    /** The captured bytes of the packet `i` are `data[offsets[i]..offsets[i + 1]]`. */
+    offsets: Uint32Array
+
+    sport: Uint16Array
+    dport: Uint16Array
+
+    /** IP protocol number, `0` for non IP packets. */
+    protocol: Uint8Array
+
+    tcpFlags: Uint8Array
+
+    constructor(size: number, dataSize: number) {
+        this.columns = Buffer.alloc(batchColumnsSize(size))
+        this.data = Buffer.alloc(dataSize)
+
+        const buffer = this.columns.buffer
+        const offset = this.columns.byteOffset
+
+        this.timestamps = new Float64Array(buffer, offset, size)
+        this.flowHash = new BigUint64Array(buffer, offset + size * 8, size)
+        this.saddr = new Uint32Array(buffer, offset + size * 16, size)
+        this.daddr = new Uint32Array(buffer, offset + size * 20, size)
+        this.lengths = new Uint32Array(buffer, offset + size * 24, size)
+        this.offsets = new Uint32Array(buffer, offset + size * 28, size + 1)
+        this.sport = new Uint16Array(buffer, offset + size * 32 + 4, size)
+        this.dport = new Uint16Array(buffer, offset + size * 34 + 4, size)
+        this.protocol = new Uint8Array(buffer, offset + size * 36 + 4, size)
+        this.tcpFlags = new Uint8Array(buffer, offset + size * 37 + 4, size)
+    }
+
+    /** Captured bytes of the packet `index`, without copying them. */
+    packet(index: number): Buffer {
+        return this.data.subarray(this.offsets[index], this.offsets[index + 1])
+    }
+}
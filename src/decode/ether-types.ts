@@ -0,0 +1,30 @@
+import { PROTOCOL_ARP, PROTOCOL_IPV4, PROTOCOL_IPV6 } from '@/types'
+import type { DecodeEmitter, DecodeOptions } from '@/types'
+import type { Buffer } from 'node:buffer'
+import { Arp, IPv4, IPv6 } from './protocols'
+import { DECODE_UNKNOWN_ETHERTYPE, DECODE_UNSUPPORTED, decodeTruncated, decodeUnknown } from './unknown'
+import type { Truncated, Unknown } from './unknown'
+
+export type EtherTypesType =
+    | IPv4
+    | Arp
+    | IPv6
+    | Unknown
+    | Truncated
+
+// http://en.wikipedia.org/wiki/EtherType
+export function etherTypes(type: number, emitter: DecodeEmitter | undefined, rawPacket: Buffer, offset: number, options?: DecodeOptions): EtherTypesType {
+    switch (type) {
+        case PROTOCOL_IPV4:
+            return decodeTruncated(rawPacket, offset, 20, emitter, options) ?? new IPv4(rawPacket, offset, emitter, options)
+        case PROTOCOL_ARP:
+            return decodeTruncated(rawPacket, offset, 28, emitter, options)
+                ?? (rawPacket[offset + 4] === 6 && rawPacket[offset + 5] === 4
+                    ? new Arp(rawPacket, offset, emitter)
+                    : decodeUnknown(DECODE_UNSUPPORTED, type, 'Dont know how to decode other ARP Packets.', rawPacket, offset, emitter, options))
+        case PROTOCOL_IPV6:
+            return decodeTruncated(rawPacket, offset, 40, emitter, options) ?? new IPv6(rawPacket, offset, emitter, options)
+    }
+
+    return decodeUnknown(DECODE_UNKNOWN_ETHERTYPE, type, `Dont know how to decode ethertype ${type}.`, rawPacket, offset, emitter, options)
+}
@@ -1,8 +1,9 @@
-import type { LinkType, PacketData } from '@/types'
+import { PACKET_HEADER_SIZE } from '@/header'
+import type { DecodeEmitter, DecodeOptions, LinkType, PacketData } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
-import { EthernetPacket, NullPacket, SLLPacket } from './packets'
+import { EthernetPacket, NullPacket, RadiotapPacket, SLLPacket } from './packets'
 import { IPv4 } from './protocols'
+import { DECODE_UNKNOWN_LINK_TYPE, DECODE_UNSUPPORTED, decodeTruncated, decodeUnknown, Truncated, Unknown } from './unknown'
 
 export class NpcapHeader {
     caplen: number
@@ -11,7 +12,10 @@ export class NpcapHeader {
     tvUsec: number
 
     constructor(rawHeader: Buffer) {
-        this.tvSec = rawHeader.readUInt32LE(0)
+        // The 64-bit seconds of the `PacketHeader` layout, when present.
+        this.tvSec = rawHeader.length >= PACKET_HEADER_SIZE
+            ? rawHeader.readUInt32LE(20) * 0x100000000 + rawHeader.readUInt32LE(16)
+            : rawHeader.readUInt32LE(0)
         this.tvUsec = rawHeader.readUInt32LE(4)
         this.caplen = rawHeader.readUInt32LE(8)
         this.len = rawHeader.readUInt32LE(12)
@@ -21,9 +25,9 @@ export class NpcapHeader {
 export class NpcapDecode {
     linkType: LinkType
     npcapHeader: NpcapHeader
-    payload: EthernetPacket | NullPacket | IPv4 | SLLPacket
+    payload: EthernetPacket | NullPacket | IPv4 | SLLPacket | RadiotapPacket | Unknown | Truncated
 
-    constructor(packet: PacketData, emitter?: EventEmitter) {
+    constructor(packet: PacketData, emitter?: DecodeEmitter, options?: DecodeOptions) {
         this.linkType = packet.linkType
         this.npcapHeader = new NpcapHeader(packet.header)
 
@@ -31,19 +35,31 @@ export class NpcapDecode {
 
         switch (this.linkType) {
             case 'LINKTYPE_ETHERNET':
-                this.payload = new EthernetPacket(buffer, 0, emitter)
+                this.payload = decodeTruncated(buffer, 0, 14, emitter, options) ?? new EthernetPacket(buffer, 0, emitter, options)
                 break
             case 'LINKTYPE_NULL':
-                this.payload = new NullPacket(buffer, 0, emitter)
+                this.payload = decodeTruncated(buffer, 0, 4, emitter, options) ?? new NullPacket(buffer, 0, emitter, options)
                 break
             case 'LINKTYPE_RAW':
-                this.payload = new IPv4(buffer, 0, emitter)
+                this.payload = decodeTruncated(buffer, 0, 20, emitter, options) ?? new IPv4(buffer, 0, emitter, options)
                 break
             case 'LINKTYPE_LINUX_SLL':
-                this.payload = new SLLPacket(buffer, 0, emitter)
+                this.payload = decodeTruncated(buffer, 0, 16, emitter, options) ?? new SLLPacket(buffer, 0, emitter, options)
                 break
+            case 'LINKTYPE_IEEE802_11_RADIO': {
+                // The fields are read up to the length of the header.
+                const short = decodeTruncated(buffer, 0, 8, emitter, options) ?? decodeTruncated(buffer, 0, buffer.readUInt16LE(2), emitter, options)
+
+                if (short)
+                    this.payload = short
+                else if (buffer[0] !== 0)
+                    this.payload = decodeUnknown(DECODE_UNSUPPORTED, buffer[0], `Dont know how to decode radiotap revision ${buffer[0]}.`, buffer, 0, emitter, options)
+                else
+                    this.payload = new RadiotapPacket(buffer, 0, emitter, options)
+                break
+            }
             default:
-                throw new Error(`[NpcapPacket] Unknown decode link type '${this.linkType}'.`)
+                this.payload = decodeUnknown(DECODE_UNKNOWN_LINK_TYPE, -1, `[NpcapPacket] Unknown decode link type '${this.linkType}'.`, buffer, 0, emitter, options)
         }
 
         return this
@@ -65,11 +81,26 @@ export class NpcapDecode {
         return this.payload instanceof SLLPacket
     }
 
+    isRadiotap(): this is { payload: RadiotapPacket } {
+        return this.payload instanceof RadiotapPacket
+    }
+
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
         return `${this.linkType} ${this.payload}`
     }
 }
 
-export function decode(packet: PacketData, emitter?: EventEmitter) {
-    return new NpcapDecode(packet, emitter)
+export function decode(packet: PacketData, emitter?: DecodeEmitter, options?: DecodeOptions) {
+    return new NpcapDecode(packet, emitter, options)
 }
+
+export * from './subscriptions'
+export * from './unknown'
@@ -1,6 +1,8 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { HeaderExtension, ICMP, IGMP, IPv4, IPv6, NoNext, Tcp, Udp } from './protocols'
+import { DECODE_UNKNOWN_PROTOCOL, decodeTruncated, decodeUnknown } from './unknown'
+import type { Truncated, Unknown } from './unknown'
 
 export type ProtocolsType =
     | HeaderExtension
@@ -11,35 +13,87 @@ export type ProtocolsType =
     | Udp
     | IPv6
     | NoNext
+    | Unknown
+    | Truncated
+
+// IPv6 extension headers, still decoded with `maxLayer: 'l3'`.
+function isExtensionHeader(protocol: number) {
+    switch (protocol) {
+        case 0:
+        case 43:
+        case 51:
+        case 59:
+        case 60:
+        case 135:
+        case 139:
+        case 140:
+            return true
+    }
+
+    return false
+}
+
+// Fixed part of the header, read by the decoders without checking the capture length.
+function minHeaderLength(protocol: number) {
+    switch (protocol) {
+        case 1:
+            return 4
+        case 2:
+        case 17:
+            return 8
+        case 4:
+        case 6:
+            return 20
+        case 41:
+            return 40
+        case 0:
+        case 43:
+        case 51:
+        case 60:
+        case 135:
+        case 139:
+        case 140:
+            return 2
+    }
+
+    return 0
+}
 
 // https://www.iana.org/assignments/protocol-numbers/protocol-numbers.xhtml
-export function protocols(protocol: number, emitter: EventEmitter | undefined, rawPacket: Buffer, offset: number, len: number = 0) {
+export function protocols(protocol: number, emitter: DecodeEmitter | undefined, rawPacket: Buffer, offset: number, len: number = 0, options?: DecodeOptions): ProtocolsType | undefined {
+    if (options?.maxLayer === 'l3' && !isExtensionHeader(protocol))
+        return undefined
+
+    const short = decodeTruncated(rawPacket, offset, minHeaderLength(protocol), emitter, options)
+    if (short)
+        return short
+
     switch (protocol) {
         case 0:
-            return new HeaderExtension(rawPacket, offset, emitter)
+            return new HeaderExtension(rawPacket, offset, emitter, options)
         case 1:
             return new ICMP(rawPacket, offset, emitter)
         case 2:
             return new IGMP(rawPacket, offset, emitter)
         case 4:
-            return new IPv4(rawPacket, offset, emitter)
+            return new IPv4(rawPacket, offset, emitter, options)
         case 6:
-            return new Tcp(rawPacket, offset, len, emitter)
+            return new Tcp(rawPacket, offset, len, emitter, options)
         case 17:
-            return new Udp(rawPacket, offset, emitter)
+            return new Udp(rawPacket, offset, emitter, options)
         case 41:
-            return new IPv6(rawPacket, offset, emitter)
+            return new IPv6(rawPacket, offset, emitter, options)
         case 43:
         case 51:
-            return new HeaderExtension(rawPacket, offset, emitter)
+            return new HeaderExtension(rawPacket, offset, emitter, options)
         case 59:
-            return new NoNext(rawPacket, offset)
+            return new NoNext(rawPacket, offset, options)
         case 60:
         case 135:
         case 139:
         case 140:
-            return new HeaderExtension(rawPacket, offset, emitter)
+            return new HeaderExtension(rawPacket, offset, emitter, options)
     }
 
-    throw new Error(`Dont know how to decode protocol ${protocol}`)
+    return decodeUnknown(DECODE_UNKNOWN_PROTOCOL, protocol, `Dont know how to decode protocol ${protocol}`, rawPacket, offset, emitter, options)
 }
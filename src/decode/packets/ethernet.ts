@@ -1,8 +1,11 @@
 import { int8_to_hex as hex } from '@/decode/utils'
-import { PROTOCOL_ARP, PROTOCOL_IPV4, PROTOCOL_IPV6, PROTOCOL_VLAN, ProtocolName } from '@/types'
+import { PROTOCOL_VLAN, ProtocolName } from '@/types'
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
+import { etherTypes } from '../ether-types'
+import type { EtherTypesType } from '../ether-types'
 import { Arp, IPv4, IPv6, Vlan } from '../protocols'
+import { DECODE_UNSUPPORTED, decodeTruncated, decodeUnknown, Truncated, Unknown } from '../unknown'
 
 export class EthernetAddr {
     addr: number[] = Array.from({ length: 4 })
@@ -50,15 +53,30 @@ export class EthernetPacket {
      */
     vlan?: Vlan
 
+    #payload?: EtherTypesType
+    #decode?: () => EtherTypesType
+
     /**
      * The payload of the packet frame.
      *
      * Supported protocols: IPv4, Arp, IPv6.
      */
-    payload: IPv4 | Arp | IPv6
+    get payload(): EtherTypesType {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload!
+    }
+
+    set payload(payload: EtherTypesType) {
+        this.#payload = payload
+    }
 
     // https://en.wikipedia.org/wiki/Ethernet_frame
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         this.dhost = new EthernetAddr(rawPacket, offset)
         offset += 6
 
@@ -69,31 +87,29 @@ export class EthernetPacket {
         offset += 2
 
         // VLAN-tagged (802.1Q)
-        if (this.type === PROTOCOL_VLAN) {
-            this.vlan = new Vlan(rawPacket, offset)
-            offset += 2
-
-            this.type = rawPacket.readUInt16BE(offset)
-            offset += 2
-        }
+        const short = this.type === PROTOCOL_VLAN ? decodeTruncated(rawPacket, offset, 4, emitter, options) : undefined
 
-        if (this.type < 1536) {
-            // this packet is actually some 802.3 type without an ethertype
-            throw new Error(`802.3 type without an ethertype ${this.type}.`)
+        if (short) {
+            this.payload = short
         }
         else {
-            switch (this.type) {
-                case PROTOCOL_IPV4:
-                    this.payload = new IPv4(rawPacket, offset, emitter)
-                    break
-                case PROTOCOL_ARP:
-                    this.payload = new Arp(rawPacket, offset, emitter)
-                    break
-                case PROTOCOL_IPV6:
-                    this.payload = new IPv6(rawPacket, offset, emitter)
-                    break
-                default:
-                    throw new Error(`Dont know how to decode ethertype ${this.type}.`)
+            if (this.type === PROTOCOL_VLAN) {
+                this.vlan = new Vlan(rawPacket, offset)
+                offset += 2
+
+                this.type = rawPacket.readUInt16BE(offset)
+                offset += 2
+            }
+
+            if (this.type < 1536) {
+                // this packet is actually some 802.3 type without an ethertype
+                this.payload = decodeUnknown(DECODE_UNSUPPORTED, this.type, `802.3 type without an ethertype ${this.type}.`, rawPacket, offset, emitter, options)
+            }
+            else if (options?.lazy) {
+                this.#decode = () => etherTypes(this.type, emitter, rawPacket, offset, options)
+            }
+            else {
+                this.#payload = etherTypes(this.type, emitter, rawPacket, offset, options)
             }
         }
 
@@ -113,6 +129,14 @@ export class EthernetPacket {
         return this.payload instanceof IPv6
     }
 
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
         let ret = `${this.shost} -> ${this.dhost}`
 
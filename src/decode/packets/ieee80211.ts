@@ -0,0 +1,169 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
+import type { Buffer } from 'node:buffer'
+import { decodeTruncated, Truncated } from '../unknown'
+import { EthernetAddr } from './ethernet'
+import { LLCPacket } from './llc'
+
+const MANAGEMENT_SUBTYPES: Record<number, string> = {
+    0: 'Association Request',
+    1: 'Association Response',
+    2: 'Reassociation Request',
+    3: 'Reassociation Response',
+    4: 'Probe Request',
+    5: 'Probe Response',
+    8: 'Beacon',
+    10: 'Disassociation',
+    11: 'Authentication',
+    12: 'Deauthentication',
+    13: 'Action',
+}
+
+const CONTROL_SUBTYPES: Record<number, string> = {
+    8: 'Block Ack Request',
+    9: 'Block Ack',
+    10: 'PS-Poll',
+    11: 'RTS',
+    12: 'CTS',
+    13: 'ACK',
+}
+
+function decodeLLC(rawPacket: Buffer, offset: number, emitter?: DecodeEmitter, options?: DecodeOptions) {
+    return decodeTruncated(rawPacket, offset, 8, emitter, options) ?? new LLCPacket(rawPacket, offset, emitter, options)
+}
+
+export class Ieee80211Packet {
+    static decoderName = 'ieee802.11-packet'
+
+    /**
+     * Frame control field, as read from the frame (little-endian).
+     *
+     * @see {@link https://en.wikipedia.org/wiki/802.11_frame_types | 802.11 frame types}
+     */
+    frameControl: number
+
+    /**
+     * `0` management, `1` control, `2` data.
+     */
+    type: number
+
+    subtype: number
+
+    /**
+     * To DS, From DS, More Fragments, Retry, Power Management, More Data, Protected, Order.
+     */
+    flags: number
+
+    duration: number
+
+    /**
+     * Receiver address.
+     */
+    addr1: EthernetAddr
+
+    /**
+     * Transmitter address, missing in CTS and ACK frames.
+     */
+    addr2?: EthernetAddr
+
+    /**
+     * BSSID, source or destination address depending on the DS bits.
+     */
+    addr3?: EthernetAddr
+
+    sequence?: number
+
+    #payload?: LLCPacket | Truncated
+    #decode?: () => LLCPacket | Truncated | undefined
+
+    /**
+     * The payload of unprotected data frames.
+     */
+    get payload(): LLCPacket | Truncated | undefined {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload
+    }
+
+    set payload(payload: LLCPacket | Truncated | undefined) {
+        this.#payload = payload
+    }
+
+    // https://en.wikipedia.org/wiki/802.11_frame_types
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions, dataPad: boolean = false) {
+        this.frameControl = rawPacket.readUInt16LE(offset)
+        this.type = (this.frameControl >> 2) & 0x03
+        this.subtype = (this.frameControl >> 4) & 0x0F
+        this.flags = this.frameControl >> 8
+        this.duration = rawPacket.readUInt16LE(offset + 2)
+        this.addr1 = new EthernetAddr(rawPacket, offset + 4)
+
+        if (this.type === 1) {
+            // CTS and ACK only carry the receiver address.
+            if (this.subtype !== 12 && this.subtype !== 13)
+                this.addr2 = new EthernetAddr(rawPacket, offset + 10)
+        }
+        else {
+            this.addr2 = new EthernetAddr(rawPacket, offset + 10)
+            this.addr3 = new EthernetAddr(rawPacket, offset + 16)
+            this.sequence = rawPacket.readUInt16LE(offset + 22) >> 4
+        }
+
+        // Null (no data) frames have no body, protected ones can't be read.
+        if (this.type === 2 && (this.subtype & 0x04) === 0 && (this.flags & 0x40) === 0) {
+            let headerLength = 24
+
+            // To DS and From DS: fourth address.
+            if ((this.flags & 0x03) === 0x03)
+                headerLength += 6
+
+            // QoS control, followed by the HT control when the order bit is set.
+            if (this.subtype & 0x08) {
+                headerLength += 2
+
+                if (this.flags & 0x80)
+                    headerLength += 4
+            }
+
+            if (dataPad)
+                headerLength = (headerLength + 3) & ~3
+
+            if (options?.lazy)
+                this.#decode = () => decodeLLC(rawPacket, offset + headerLength, emitter, options)
+            else
+                this.#payload = decodeLLC(rawPacket, offset + headerLength, emitter, options)
+        }
+
+        if (emitter)
+            emitter.emit(Ieee80211Packet.decoderName, this)
+    }
+
+    isLLC(): this is { payload: LLCPacket } {
+        return this.payload instanceof LLCPacket
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
+    toString() {
+        let ret
+
+        if (this.type === 0)
+            ret = MANAGEMENT_SUBTYPES[this.subtype] ?? `Management ${this.subtype}`
+        else if (this.type === 1)
+            ret = CONTROL_SUBTYPES[this.subtype] ?? `Control ${this.subtype}`
+        else
+            ret = `${this.subtype & 0x08 ? 'QoS ' : ''}${this.subtype & 0x04 ? 'Null' : 'Data'}`
+
+        ret += this.addr2 ? ` ${this.addr2} -> ${this.addr1}` : ` -> ${this.addr1}`
+
+        if (this.flags & 0x40)
+            ret += ' protected'
+
+        return this.payload ? `${ret} ${this.payload}` : ret
+    }
+}
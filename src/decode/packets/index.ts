@@ -1,4 +1,6 @@
 export * from './ethernet'
+export * from './ieee80211'
 export * from './llc'
 export * from './null'
+export * from './radiotap'
 export * from './sll'
@@ -1,7 +1,10 @@
-import { PROTOCOL_ARP, PROTOCOL_IPV4, PROTOCOL_IPV6, ProtocolName } from '@/types'
+import { ProtocolName } from '@/types'
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
+import { etherTypes } from '../ether-types'
+import type { EtherTypesType } from '../ether-types'
 import { Arp, IPv4, IPv6 } from '../protocols'
+import { DECODE_UNKNOWN_ETHERTYPE, DECODE_UNSUPPORTED, decodeUnknown, Truncated, Unknown } from '../unknown'
 
 const SNAP = 0xAA
 const LSAP = 0x00
@@ -24,24 +27,39 @@ export class LLCPacket {
      *
      * @see {@link https://en.wikipedia.org/wiki/IEEE_802.2#Control_Field | Control Field}
      */
-    control: number
+    control = 0
 
     /**
      * Determine which protocol is encapsulated in the payload.
      *
      * @see {@link http://en.wikipedia.org/wiki/EtherType | EtherType}
      */
-    type: number
+    type = 0
+
+    #payload?: EtherTypesType
+    #decode?: () => EtherTypesType
 
     /**
      * The payload of the packet frame.
      *
      * Supported protocols: IPv4, Arp, IPv6.
      */
-    payload: IPv4 | Arp | IPv6
+    get payload(): EtherTypesType {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload!
+    }
+
+    set payload(payload: EtherTypesType) {
+        this.#payload = payload
+    }
 
     // https://en.wikipedia.org/wiki/IEEE_802.2#LSAP_Values
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         this.dsap = rawPacket[offset++]
         this.ssap = rawPacket[offset++]
 
@@ -55,27 +73,17 @@ export class LLCPacket {
 
             if (this.type < 1536) {
                 // this packet is actually some 802.3 type without an ethertype
-                throw new Error(`802.3 type without an ethertype ${this.type}.`)
+                this.payload = decodeUnknown(DECODE_UNSUPPORTED, this.type, `802.3 type without an ethertype ${this.type}.`, rawPacket, offset, emitter, options)
+            }
+            else if (options?.lazy) {
+                this.#decode = () => etherTypes(this.type, emitter, rawPacket, offset, options)
             }
             else {
-                // http://en.wikipedia.org/wiki/EtherType
-                switch (this.type) {
-                    case PROTOCOL_IPV4:
-                        this.payload = new IPv4(rawPacket, offset, emitter)
-                        break
-                    case PROTOCOL_ARP:
-                        this.payload = new Arp(rawPacket, offset, emitter)
-                        break
-                    case PROTOCOL_IPV6:
-                        this.payload = new IPv6(rawPacket, offset, emitter)
-                        break
-                    default:
-                        throw new Error(`NpcapPacket: LLCPacket() - Dont know how to decode type ${this.type}.`)
-                }
+                this.#payload = etherTypes(this.type, emitter, rawPacket, offset, options)
             }
         }
         else {
-            throw new Error(`NpcapPacket: LLCPacket() - Unknown LLC types: DSAP: ${this.dsap}, SSAP: ${this.ssap}.`)
+            this.payload = decodeUnknown(DECODE_UNKNOWN_ETHERTYPE, (this.dsap << 8) | this.ssap, `NpcapPacket: LLCPacket() - Unknown LLC types: DSAP: ${this.dsap}, SSAP: ${this.ssap}.`, rawPacket, offset, emitter, options)
         }
 
         if (emitter)
@@ -94,6 +102,14 @@ export class LLCPacket {
         return this.payload instanceof IPv6
     }
 
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
         let ret = `dsap: ${this.dsap} ssap: ${this.ssap}`
 
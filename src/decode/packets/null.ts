@@ -1,6 +1,21 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { IPv4, IPv6 } from '../protocols'
+import { DECODE_UNKNOWN_ETHERTYPE, decodeTruncated, decodeUnknown, Truncated, Unknown } from '../unknown'
+
+// https://www.tcpdump.org/linktypes/LINKTYPE_NULL.html
+function decodeFamily(family: number, rawPacket: Buffer, offset: number, emitter?: DecodeEmitter, options?: DecodeOptions) {
+    switch (family) {
+        case 2:
+            return decodeTruncated(rawPacket, offset, 20, emitter, options) ?? new IPv4(rawPacket, offset, emitter, options)
+        case 24:
+        case 28:
+        case 30:
+            return decodeTruncated(rawPacket, offset, 40, emitter, options) ?? new IPv6(rawPacket, offset, emitter, options)
+    }
+
+    return decodeUnknown(DECODE_UNKNOWN_ETHERTYPE, family, `Dont know how to decode protocol family ${family}.`, rawPacket, offset, emitter, options)
+}
 
 export class NullPacket {
     static decoderName = 'null-packet'
@@ -12,32 +27,39 @@ export class NullPacket {
      */
     type: number
 
+    #payload?: IPv4 | IPv6 | Unknown | Truncated
+    #decode?: () => IPv4 | IPv6 | Unknown | Truncated
+
     /**
      * The payload of the packet frame.
      *
      * Supported protocols: IPv4, IPv6.
      */
-    payload: IPv4 | IPv6
+    get payload(): IPv4 | IPv6 | Unknown | Truncated {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload!
+    }
+
+    set payload(payload: IPv4 | IPv6 | Unknown | Truncated) {
+        this.#payload = payload
+    }
 
     // https://www.tcpdump.org/linktypes/LINKTYPE_NULL.html
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         if (rawPacket[offset] === 0 && rawPacket[offset + 1] === 0)
             this.type = rawPacket[offset + 3]
         else
             this.type = rawPacket[offset]
 
-        switch (this.type) {
-            case 2:
-                this.payload = new IPv4(rawPacket, offset + 4, emitter)
-                break
-            case 24:
-            case 28:
-            case 30:
-                this.payload = new IPv6(rawPacket, offset + 4, emitter)
-                break
-            default:
-                throw new Error(`Dont know how to decode protocol family ${this.type}.`)
-        }
+        if (options?.lazy)
+            this.#decode = () => decodeFamily(this.type, rawPacket, offset + 4, emitter, options)
+        else
+            this.#payload = decodeFamily(this.type, rawPacket, offset + 4, emitter, options)
 
         if (emitter)
             emitter.emit(NullPacket.decoderName, this)
@@ -51,6 +73,14 @@ export class NullPacket {
         return this.payload instanceof IPv6
     }
 
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
         return `${this.type} ${this.payload}`
     }
@@ -0,0 +1,201 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
+import type { Buffer } from 'node:buffer'
+import { decodeTruncated, Truncated } from '../unknown'
+import { Ieee80211Packet } from './ieee80211'
+
+// Alignment and size of the radiotap fields, by present bit.
+// https://www.radiotap.org/fields/defined
+const FIELDS: Array<[number, number]> = [
+    [8, 8], // TSFT
+    [1, 1], // Flags
+    [1, 1], // Rate
+    [2, 4], // Channel
+    [2, 2], // FHSS
+    [1, 1], // Antenna signal (dBm)
+    [1, 1], // Antenna noise (dBm)
+    [2, 2], // Lock quality
+    [2, 2], // TX attenuation
+    [2, 2], // dB TX attenuation
+    [1, 1], // dBm TX power
+    [1, 1], // Antenna
+    [1, 1], // dB antenna signal
+    [1, 1], // dB antenna noise
+    [2, 2], // RX flags
+    [2, 2], // TX flags
+    [1, 1], // RTS retries
+    [1, 1], // Data retries
+    [4, 8], // XChannel
+    [1, 3], // MCS
+    [4, 8], // A-MPDU status
+    [2, 12], // VHT
+    [8, 12], // Timestamp
+    [2, 12], // HE
+    [2, 12], // HE-MU
+    [2, 6], // HE-MU-other-user
+    [1, 1], // 0-length-PSDU
+    [2, 4], // L-SIG
+]
+
+/** The frame ends with its FCS. */
+const FLAG_FCS = 0x10
+
+/** Padding between the 802.11 header and the payload. */
+const FLAG_DATA_PAD = 0x20
+
+function decodeFrame(frame: Buffer, offset: number, emitter: DecodeEmitter | undefined, options: DecodeOptions | undefined, dataPad: boolean) {
+    // Control frames start with 10 bytes (CTS, ACK), the other ones with 24.
+    const needed = ((frame[offset] >> 2) & 0x03) === 1 ? 10 : 24
+
+    return decodeTruncated(frame, offset, needed, emitter, options) ?? new Ieee80211Packet(frame, offset, emitter, options, dataPad)
+}
+
+export class RadiotapPacket {
+    static decoderName = 'radiotap-packet'
+
+    headerRevision: number
+    headerPad: number
+    headerLength: number
+
+    /**
+     * Bitmask of the fields present (first word).
+     *
+     * @see {@link https://www.radiotap.org/fields/defined | Radiotap fields}
+     */
+    presentFlags: number
+
+    /**
+     * Radiotap flags (FCS at end, bad FCS...).
+     */
+    flags?: number
+
+    /**
+     * Legacy data rate in 500 kbps units.
+     */
+    rate?: number
+
+    /**
+     * Channel frequency in MHz.
+     */
+    frequency?: number
+
+    channelFlags?: number
+
+    /**
+     * Antenna signal in dBm.
+     */
+    signal?: number
+
+    /**
+     * Antenna noise in dBm.
+     */
+    noise?: number
+
+    antenna?: number
+
+    #payload?: Ieee80211Packet | Truncated
+    #decode?: () => Ieee80211Packet | Truncated
+
+    /**
+     * The 802.11 frame.
+     */
+    get payload(): Ieee80211Packet | Truncated {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload!
+    }
+
+    set payload(payload: Ieee80211Packet | Truncated) {
+        this.#payload = payload
+    }
+
+    // https://www.radiotap.org
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
+        const start = offset
+
+        this.headerRevision = rawPacket[offset]
+        this.headerPad = rawPacket[offset + 1]
+        this.headerLength = rawPacket.readUInt16LE(offset + 2)
+        this.presentFlags = rawPacket.readUInt32LE(offset + 4)
+        offset += 8
+
+        if (this.headerRevision !== 0)
+            throw new Error(`Dont know how to decode radiotap revision ${this.headerRevision}.`)
+
+        // Skip the extended bitmaps, their fields come after the ones of the first bitmap.
+        for (let word = this.presentFlags; word & 0x80000000; offset += 4)
+            word = rawPacket.readUInt32LE(offset)
+
+        // Fields are aligned on their natural size from the start of the header. The walk stops
+        // at the first field we don't know the size of, every field after it is unreachable.
+        const end = start + this.headerLength
+
+        for (let bit = 0; bit < FIELDS.length; bit++) {
+            if ((this.presentFlags & (1 << bit)) === 0)
+                continue
+
+            const [align, size] = FIELDS[bit]
+
+            offset = start + ((offset - start + align - 1) & ~(align - 1))
+            if (offset + size > end)
+                break
+
+            switch (bit) {
+                case 1:
+                    this.flags = rawPacket[offset]
+                    break
+                case 2:
+                    this.rate = rawPacket[offset]
+                    break
+                case 3:
+                    this.frequency = rawPacket.readUInt16LE(offset)
+                    this.channelFlags = rawPacket.readUInt16LE(offset + 2)
+                    break
+                case 5:
+                    this.signal = rawPacket.readInt8(offset)
+                    break
+                case 6:
+                    this.noise = rawPacket.readInt8(offset)
+                    break
+                case 11:
+                    this.antenna = rawPacket[offset]
+                    break
+            }
+
+            offset += size
+        }
+
+        const flags = this.flags ?? 0
+        const frame = flags & FLAG_FCS ? rawPacket.subarray(0, rawPacket.length - 4) : rawPacket
+
+        if (options?.lazy)
+            this.#decode = () => decodeFrame(frame, end, emitter, options, (flags & FLAG_DATA_PAD) !== 0)
+        else
+            this.#payload = decodeFrame(frame, end, emitter, options, (flags & FLAG_DATA_PAD) !== 0)
+
+        if (emitter)
+            emitter.emit(RadiotapPacket.decoderName, this)
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
+    toString() {
+        let ret = ''
+
+        if (this.frequency !== undefined)
+            ret += `${this.frequency} MHz `
+
+        if (this.rate !== undefined)
+            ret += `${this.rate / 2} Mb/s `
+
+        if (this.signal !== undefined)
+            ret += `${this.signal}dBm signal `
+
+        return `${ret}${this.payload}`
+    }
+}
@@ -1,5 +1,5 @@
+import type { DecodeEmitter } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { EthernetAddr } from '../packets/ethernet'
 import { IPv4Addr } from './ipv4'
 
@@ -71,7 +71,7 @@ export class Arp {
     tpa: IPv4Addr
 
     // http://en.wikipedia.org/wiki/Address_Resolution_Protocol
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter) {
         this.htype = rawPacket.readUInt16BE(offset)
         this.ptype = rawPacket.readUInt16BE(offset + 2)
         this.hlen = rawPacket[offset + 4]
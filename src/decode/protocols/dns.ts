@@ -1,5 +1,5 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { IPv4Addr } from './ipv4'
 import { IPv6Addr } from './ipv6'
 
@@ -139,13 +139,18 @@ export class DNS {
     ancount: number
     nscount: number
     arcount: number
+
+    // Left empty with the `skip.dnsBody` decode option.
     question: DNSRRSet
     answer: DNSRRSet
     authority: DNSRRSet
     additional: DNSRRSet
 
+    #throwOnError: boolean
+    #malformed = false
+
     // http://tools.ietf.org/html/rfc1035
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         // these 2 fields will be deleted soon.
         this.rawPacket = rawPacket
         this.offset = offset
@@ -158,32 +163,72 @@ export class DNS {
         this.arcount = rawPacket.readUInt16BE(offset + 10) // 10, 11
         this.offset += 12
 
-        this.question = this.#decode_RRs(this.qdcount, true)
-        this.answer = this.#decode_RRs(this.ancount, false)
-        this.authority = this.#decode_RRs(this.nscount, false)
-        this.additional = this.#decode_RRs(this.arcount, false)
+        this.question = new DNSRRSet(0)
+        this.answer = new DNSRRSet(0)
+        this.authority = new DNSRRSet(0)
+        this.additional = new DNSRRSet(0)
+        this.#throwOnError = options?.throwOnError !== false
+
+        // Without `throwOnError`, the decode stops at the first malformed record (its set is left empty).
+        if (!options?.skip?.dnsBody) {
+            this.question = this.#decode_RRs(this.qdcount, true)
+            this.answer = this.#decode_RRs(this.ancount, false)
+            this.authority = this.#decode_RRs(this.nscount, false)
+            this.additional = this.#decode_RRs(this.arcount, false)
+        }
 
         if (emitter)
             emitter.emit(DNS.decoderName, this)
     }
 
+    /**
+     * Throws the error, or with `throwOnError` disabled marks the message as malformed.
+     *
+     * @returns `undefined`, returned in turn by the reader that failed.
+     */
+    #fail(message: string): undefined {
+        if (this.#throwOnError)
+            throw new Error(message)
+
+        this.#malformed = true
+        return undefined
+    }
+
     #decode_RRs(count: number, isQuestion: boolean) {
-        if (count > 100)
-            throw new Error(`Malformed DNS packet: too many RRs at offset ${this.offset}`)
+        if (this.#malformed)
+            return new DNSRRSet(0)
+
+        if (count > 100) {
+            this.#fail(`Malformed DNS packet: too many RRs at offset ${this.offset}`)
+            return new DNSRRSet(0)
+        }
 
         const ret = new DNSRRSet(count)
-        for (let i = 0; i < count; i++)
-            ret.rrs[i] = this.#decode_RR(isQuestion)
+        for (let i = 0; i < count; i++) {
+            const rr = this.#decode_RR(isQuestion)
+
+            if (!rr)
+                return new DNSRRSet(0)
+
+            ret.rrs[i] = rr
+        }
 
         return ret
     }
 
-    #decode_RR(isQuestion: boolean) {
+    #decode_RR(isQuestion: boolean): DNSRR | undefined {
         if (this.offset > this.rawPacket.length)
-            throw new Error(`Malformed DNS RR. Offset is beyond packet len (decode_RR) :${this.offset} packet_len:${this.rawPacket.length}`)
+            return this.#fail(`Malformed DNS RR. Offset is beyond packet len (decode_RR) :${this.offset} packet_len:${this.rawPacket.length}`)
 
         const name = this.#readName()
 
+        if (name === undefined)
+            return undefined
+
+        // Type and class, then the TTL and the data length of an answer.
+        if (this.offset + (isQuestion ? 4 : 10) > this.rawPacket.length)
+            return this.#fail(`Malformed DNS RR. Fields are beyond packet len (decode_RR) :${this.offset} packet_len:${this.rawPacket.length}`)
+
         const type = this.rawPacket.readUInt16BE(this.offset)
         this.offset += 2
 
@@ -206,6 +251,10 @@ export class DNS {
         }
         else if (rr.type === 2 && rr.classNum === 1) { // NS, IN
             rr.rdata = this.#readName()
+
+            if (rr.rdata === undefined)
+                return undefined
+
             this.offset -= rr.rdlength // readName moves offset
         }
         else if (rr.type === 28 && rr.classNum === 1 && rr.rdlength === 16) {
@@ -218,15 +267,25 @@ export class DNS {
         return rr
     }
 
-    #readName() {
+    #readName(): string | undefined {
         let result = ''
         let lenOrPtr
         let pointer_follows = 0
         let pos = this.offset
 
-        // eslint-disable-next-line no-cond-assign
-        while ((lenOrPtr = this.rawPacket[pos]) !== 0x00) {
+        for (;;) {
+            // A truncated name would read `undefined` past the end.
+            if (pos >= this.rawPacket.length)
+                return this.#fail(`invalid DNS RR: read beyond end of packet at offset ${pos}`)
+
+            lenOrPtr = this.rawPacket[pos]
+            if (lenOrPtr === 0x00)
+                break
+
             if ((lenOrPtr & 0xC0) === 0xC0) {
+                if (pos + 1 >= this.rawPacket.length)
+                    return this.#fail(`invalid DNS RR: read beyond end of packet at offset ${pos}`)
+
                 // pointer is bottom 6 bits of current byte, plus all 8 bits of next byte
                 pos = ((lenOrPtr & ~0xC0) << 8) | this.rawPacket[pos + 1]
                 pointer_follows++
@@ -234,20 +293,24 @@ export class DNS {
                     this.offset += 2
 
                 if (pointer_follows > 5)
-                    throw new Error(`invalid DNS RR: too many compression pointers found at offset ${pos}`)
+                    return this.#fail(`invalid DNS RR: too many compression pointers found at offset ${pos}`)
             }
             else {
                 if (result.length > 0)
                     result += '.'
 
                 if (lenOrPtr > 63)
-                    throw new Error(`invalid DNS RR: length is too large at offset ${pos}`)
+                    return this.#fail(`invalid DNS RR: length is too large at offset ${pos}`)
 
-                pos++
-                for (let i = pos; i < (pos + lenOrPtr) && i < this.rawPacket.length; i++) {
-                    if (i > this.rawPacket.length)
-                        throw new Error(`invalid DNS RR: read beyond end of packet at offset ${i}`)
+                if (pos + 1 + lenOrPtr > this.rawPacket.length)
+                    return this.#fail(`invalid DNS RR: read beyond end of packet at offset ${pos}`)
 
+                // https://www.rfc-editor.org/rfc/rfc1035#section-2.3.4
+                if (result.length + lenOrPtr > 255)
+                    return this.#fail(`invalid DNS RR: name is too long at offset ${pos}`)
+
+                pos++
+                for (let i = pos; i < (pos + lenOrPtr); i++) {
                     const ch = this.rawPacket[i]
                     result += String.fromCharCode(ch)
                 }
@@ -269,16 +332,16 @@ export class DNS {
 
         ret += this.header.toString()
 
-        if (this.qdcount > 0)
-            ret += `\n  question:${this.question?.rrs[0]}`
+        if (this.question.rrs.length > 0)
+            ret += `\n  question:${this.question.rrs[0]}`
 
-        if (this.ancount > 0)
+        if (this.answer.rrs.length > 0)
             ret += `\n  answer:${this.answer}`
 
-        if (this.nscount > 0)
+        if (this.authority.rrs.length > 0)
             ret += `\n  authority:${this.authority}`
 
-        if (this.arcount > 0)
+        if (this.additional.rrs.length > 0)
             ret += `\n  additional:${this.additional}`
 
         return ret
@@ -1,5 +1,5 @@
+import type { DecodeEmitter } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 
 const typeMessage: Record<number, string> = {
     0: 'Echo Reply',
@@ -64,7 +64,7 @@ export class ICMP {
     checksum: number
 
     // http://en.wikipedia.org/wiki/Internet_Control_Message_Protocol
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter) {
         this.type = rawPacket[offset++]
         this.code = rawPacket[offset++]
         this.checksum = rawPacket.readUInt16BE(offset)
@@ -1,5 +1,5 @@
+import type { DecodeEmitter } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { IPv4Addr } from './ipv4'
 
 const typeVersion: Record<number, number> = {
@@ -29,7 +29,7 @@ export class IGMP {
 
     // IGMP v3
     // https://en.wikipedia.org/wiki/Internet_Group_Management_Protocol
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter) {
         this.type = rawPacket[offset]
         this.maxResponseTime = rawPacket[offset + 1]
         this.checksum = rawPacket.readUInt16BE(offset + 2) // 2, 3
@@ -1,8 +1,9 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { HeaderExtension, ICMP, IGMP, IPv6, NoNext, Tcp, Udp } from '.'
 import { protocols } from '../ip-protocols'
-import { int8_to_dec } from '../utils'
+import { Truncated, Unknown } from '../unknown'
+import { int8_to_dec, LruCache } from '../utils'
 import type { ProtocolsType } from '../ip-protocols'
 
 export class IPFlags {
@@ -29,18 +30,50 @@ export class IPFlags {
     }
 }
 
+// Formatted addresses, by value.
+const ADDRESS_CACHE = new LruCache<number, string>(4096)
+
 export class IPv4Addr {
-    addr: number[] = Array.from({ length: 4 })
+    /**
+     * Address as an unsigned 32-bit number, `192.168.0.1` is `0xC0A80001`.
+     *
+     * Use it as a map key or to compare addresses without formatting them.
+     */
+    value: number
 
     constructor(rawPacket: Buffer, offset: number = 0) {
-        this.addr[0] = rawPacket[offset]
-        this.addr[1] = rawPacket[offset + 1]
-        this.addr[2] = rawPacket[offset + 2]
-        this.addr[3] = rawPacket[offset + 3]
+        this.value = ((rawPacket[offset] << 24) | (rawPacket[offset + 1] << 16) | (rawPacket[offset + 2] << 8) | rawPacket[offset + 3]) >>> 0
+    }
+
+    /**
+     * The 4 bytes of the address, a new array on each read: assign a whole array to change the address.
+     */
+    get addr(): readonly number[] {
+        return [this.value >>> 24, (this.value >>> 16) & 0xFF, (this.value >>> 8) & 0xFF, this.value & 0xFF]
+    }
+
+    set addr(bytes: ArrayLike<number>) {
+        this.value = ((bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3]) >>> 0
+    }
+
+    equals(other: IPv4Addr) {
+        return this.value === other.value
+    }
+
+    hash() {
+        return this.value
     }
 
     toString() {
-        return `${int8_to_dec[this.addr[0]]}.${int8_to_dec[this.addr[1]]}.${int8_to_dec[this.addr[2]]}.${int8_to_dec[this.addr[3]]}`
+        const value = this.value
+        let ret = ADDRESS_CACHE.get(value)
+
+        if (ret === undefined) {
+            ret = `${int8_to_dec[value >>> 24]}.${int8_to_dec[(value >>> 16) & 0xFF]}.${int8_to_dec[(value >>> 8) & 0xFF]}.${int8_to_dec[value & 0xFF]}`
+            ADDRESS_CACHE.set(value, ret)
+        }
+
+        return ret
     }
 }
 
@@ -142,13 +175,28 @@ export class IPv4 {
      */
     daddr: IPv4Addr
 
+    #payload?: ProtocolsType
+    #decode?: () => ProtocolsType | undefined
+
     /**
-     * The payload of the packet frame.
+     * The payload of the packet frame, `undefined` beyond the `maxLayer` decode option.
      */
-    payload: ProtocolsType
+    get payload(): ProtocolsType | undefined {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload
+    }
+
+    set payload(payload: ProtocolsType | undefined) {
+        this.#payload = payload
+    }
 
     // http://en.wikipedia.org/wiki/IPv4
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         const originalOffset = offset
 
         this.version = (rawPacket[offset] & 0xF0) >> 4
@@ -188,7 +236,10 @@ export class IPv4 {
         offset = originalOffset + this.headerLength
 
         // https://www.iana.org/assignments/protocol-numbers/protocol-numbers.xhtml
-        this.payload = protocols(this.protocol, emitter, rawPacket, offset, this.length - this.headerLength)
+        if (options?.lazy)
+            this.#decode = () => protocols(this.protocol, emitter, rawPacket, offset, this.length - this.headerLength, options)
+        else
+            this.#payload = protocols(this.protocol, emitter, rawPacket, offset, this.length - this.headerLength, options)
 
         if (emitter)
             emitter.emit(IPv4.decoderName, this)
@@ -226,6 +277,14 @@ export class IPv4 {
         return this.payload instanceof NoNext
     }
 
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
         let ret = `${this.saddr} -> ${this.daddr}`
         const flags = this.flags.toString()
@@ -233,6 +292,6 @@ export class IPv4 {
         if (flags.length > 2)
             ret += ` flags ${flags}`
 
-        return `${ret} ${this.payload.constructor.name} ${this.payload}`
+        return this.payload ? `${ret} ${this.payload.constructor.name} ${this.payload}` : ret
     }
 }
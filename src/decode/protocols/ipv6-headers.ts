@@ -1,14 +1,15 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { ICMP, IGMP, IPv4, IPv6, Tcp, Udp } from '.'
 import { protocols } from '../ip-protocols'
+import { Truncated, Unknown } from '../unknown'
 import type { ProtocolsType } from '../ip-protocols'
 
 export class NoNext {
-    constructor(rawPacket: Buffer, offset: number = 0) {
+    constructor(rawPacket: Buffer, offset: number = 0, options?: DecodeOptions) {
         const remainingLength = rawPacket.length - offset
 
-        if (remainingLength !== 0)
+        if (remainingLength !== 0 && options?.throwOnError !== false)
             throw new Error(`There is more packet left to be parse, but NoNext.decode was called with ${remainingLength} bytes left.`)
     }
 
@@ -22,9 +23,25 @@ export class HeaderExtension {
 
     nextHeader: number
     headerLength: number
-    payload: ProtocolsType
 
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    #payload?: ProtocolsType
+    #decode?: () => ProtocolsType | undefined
+
+    get payload(): ProtocolsType | undefined {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload
+    }
+
+    set payload(payload: ProtocolsType | undefined) {
+        this.#payload = payload
+    }
+
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         const originalOffset = offset
 
         this.nextHeader = rawPacket[offset++]
@@ -32,7 +49,10 @@ export class HeaderExtension {
 
         offset = originalOffset + this.headerLength
 
-        this.payload = protocols(this.nextHeader, undefined, rawPacket, offset, rawPacket.length - offset)
+        if (options?.lazy)
+            this.#decode = () => protocols(this.nextHeader, undefined, rawPacket, offset, rawPacket.length - offset, options)
+        else
+            this.#payload = protocols(this.nextHeader, undefined, rawPacket, offset, rawPacket.length - offset, options)
 
         if (emitter)
             emitter.emit(HeaderExtension.decoderName, this)
@@ -70,14 +90,22 @@ export class HeaderExtension {
         return this.payload instanceof NoNext
     }
 
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
         let ret = ''
 
         if (this.payload)
-            ret += this.payload.constructor.name
+            ret += `${this.payload.constructor.name} ${this.payload}`
         else
             ret += `proto ${this.nextHeader}`
 
-        return `${ret} ${this.payload}`
+        return ret
     }
 }
@@ -1,37 +1,89 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { HeaderExtension, ICMP, IGMP, IPv4, NoNext, Tcp, Udp } from '.'
 import { protocols } from '../ip-protocols'
-import { int8_to_hex as hex } from '../utils'
+import { Truncated, Unknown } from '../unknown'
+import { int8_to_hex as hex, LruCache } from '../utils'
 import type { ProtocolsType } from '../ip-protocols'
 
+// Formatted addresses, by hash (the entry keeps the words to check for collisions).
+const ADDRESS_CACHE = new LruCache<number, { w0: number, w1: number, w2: number, w3: number, text: string }>(4096)
+
+function word(bytes: ArrayLike<number>, offset: number) {
+    return ((bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3]) >>> 0
+}
+
+// Two zero padded groups of a word.
+function group(w: number) {
+    return `${hex[w >>> 24]}${hex[(w >>> 16) & 0xFF]}:${hex[(w >>> 8) & 0xFF]}${hex[w & 0xFF]}`
+}
+
 export class IPv6Addr {
-    addr = Array.from<number>({ length: 16 })
+    /**
+     * The address as 4 unsigned 32-bit words, most significant first.
+     *
+     * Use `equals()` and `hash()` to compare addresses or key maps without formatting them.
+     */
+    w0: number
+    w1: number
+    w2: number
+    w3: number
 
     constructor(rawPacket: Buffer, offset: number = 0) {
-        this.addr[0] = rawPacket[offset + 0]
-        this.addr[1] = rawPacket[offset + 1]
-        this.addr[2] = rawPacket[offset + 2]
-        this.addr[3] = rawPacket[offset + 3]
-        this.addr[4] = rawPacket[offset + 4]
-        this.addr[5] = rawPacket[offset + 5]
-        this.addr[6] = rawPacket[offset + 6]
-        this.addr[7] = rawPacket[offset + 7]
-        this.addr[8] = rawPacket[offset + 8]
-        this.addr[9] = rawPacket[offset + 9]
-        this.addr[10] = rawPacket[offset + 10]
-        this.addr[11] = rawPacket[offset + 11]
-        this.addr[12] = rawPacket[offset + 12]
-        this.addr[13] = rawPacket[offset + 13]
-        this.addr[14] = rawPacket[offset + 14]
-        this.addr[15] = rawPacket[offset + 15]
+        this.w0 = word(rawPacket, offset)
+        this.w1 = word(rawPacket, offset + 4)
+        this.w2 = word(rawPacket, offset + 8)
+        this.w3 = word(rawPacket, offset + 12)
+    }
+
+    /**
+     * The 16 bytes of the address, a new array on each read: assign a whole array to change the address.
+     */
+    get addr(): readonly number[] {
+        const ret: number[] = []
+
+        for (const w of [this.w0, this.w1, this.w2, this.w3])
+            ret.push(w >>> 24, (w >>> 16) & 0xFF, (w >>> 8) & 0xFF, w & 0xFF)
+
+        return ret
+    }
+
+    set addr(bytes: ArrayLike<number>) {
+        this.w0 = word(bytes, 0)
+        this.w1 = word(bytes, 4)
+        this.w2 = word(bytes, 8)
+        this.w3 = word(bytes, 12)
+    }
+
+    equals(other: IPv6Addr) {
+        return this.w0 === other.w0 && this.w1 === other.w1 && this.w2 === other.w2 && this.w3 === other.w3
+    }
+
+    /**
+     * 32-bit hash of the address (FNV-1a over the words), equal addresses have the same hash.
+     */
+    hash() {
+        let h = 0x811C9DC5
+
+        h = Math.imul(h ^ this.w0, 0x01000193)
+        h = Math.imul(h ^ this.w1, 0x01000193)
+        h = Math.imul(h ^ this.w2, 0x01000193)
+        h = Math.imul(h ^ this.w3, 0x01000193)
+
+        return h >>> 0
     }
 
     toString() {
-        return `${hex[this.addr[0]] + hex[this.addr[1]]}:${hex[this.addr[2]]}${hex[this.addr[3]]}:${
-            hex[this.addr[4]]}${hex[this.addr[5]]}:${hex[this.addr[6]]}${hex[this.addr[7]]}:${
-            hex[this.addr[8]]}${hex[this.addr[9]]}:${hex[this.addr[10]]}${hex[this.addr[11]]}:${
-            hex[this.addr[12]]}${hex[this.addr[13]]}:${hex[this.addr[14]]}${hex[this.addr[15]]}`
+        const key = this.hash()
+        const entry = ADDRESS_CACHE.get(key)
+
+        if (entry && entry.w0 === this.w0 && entry.w1 === this.w1 && entry.w2 === this.w2 && entry.w3 === this.w3)
+            return entry.text
+
+        const text = `${group(this.w0)}:${group(this.w1)}:${group(this.w2)}:${group(this.w3)}`
+
+        ADDRESS_CACHE.set(key, { w0: this.w0, w1: this.w1, w2: this.w2, w3: this.w3, text })
+        return text
     }
 }
 
@@ -98,13 +150,28 @@ export class IPv6 {
      */
     daddr: IPv6Addr
 
+    #payload?: ProtocolsType
+    #decode?: () => ProtocolsType | undefined
+
     /**
-     * The payload of the packet frame.
+     * The payload of the packet frame, `undefined` beyond the `maxLayer` decode option.
      */
-    payload: ProtocolsType
+    get payload(): ProtocolsType | undefined {
+        // Decoded on the first read with the `lazy` option.
+        if (this.#decode) {
+            this.#payload = this.#decode()
+            this.#decode = undefined
+        }
+
+        return this.#payload
+    }
+
+    set payload(payload: ProtocolsType | undefined) {
+        this.#payload = payload
+    }
 
     // https://www.geeksforgeeks.org/internet-protocol-version-6-ipv6-header/
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         const originalOffset = offset
 
         this.version = ((rawPacket[offset] & 0xF0) >> 4) // first 4 bits
@@ -122,7 +189,10 @@ export class IPv6 {
         offset = originalOffset + 40
 
         // https://www.iana.org/assignments/protocol-numbers/protocol-numbers.xhtml
-        this.payload = protocols(this.nextHeader, emitter, rawPacket, offset, rawPacket.length - 40)
+        if (options?.lazy)
+            this.#decode = () => protocols(this.nextHeader, emitter, rawPacket, offset, rawPacket.length - 40, options)
+        else
+            this.#payload = protocols(this.nextHeader, emitter, rawPacket, offset, rawPacket.length - 40, options)
 
         if (emitter)
             emitter.emit(IPv6.decoderName, this)
@@ -162,7 +232,17 @@ export class IPv6 {
         return this.payload instanceof NoNext
     }
 
+    isUnknown(): this is { payload: Unknown } {
+        return this.payload instanceof Unknown
+    }
+
+    isTruncated(): this is { payload: Truncated } {
+        return this.payload instanceof Truncated
+    }
+
     toString() {
-        return `${this.saddr} -> ${this.daddr} ${this.payload.constructor.name} ${this.payload}`
+        const ret = `${this.saddr} -> ${this.daddr}`
+
+        return this.payload ? `${ret} ${this.payload.constructor.name} ${this.payload}` : ret
     }
 }
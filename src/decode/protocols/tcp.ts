@@ -1,5 +1,6 @@
+import { readTcpSackBlocks, TCP_SACK_BLOCK_SIZE } from '@/layouts'
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 
 export class TCPFlags {
     nonce: boolean
@@ -44,6 +45,9 @@ export class TCPFlags {
     }
 }
 
+// Bytes read by the decoder for the options of fixed length.
+const OPTION_LENGTHS: Record<number, number> = { 2: 4, 3: 3, 4: 2, 8: 10 }
+
 export class TCPOptions {
     /**
      * Maximum segment size.
@@ -57,11 +61,21 @@ export class TCPOptions {
     timestamp?: number
     echo?: number
 
-    decode(rawPacket: Buffer, offset: number, len: number) {
+    decode(rawPacket: Buffer, offset: number, len: number, throwOnError: boolean = true) {
         const endOffset = offset + len
 
         while (offset < endOffset) {
-            switch (rawPacket[offset]) {
+            const kind = rawPacket[offset]
+
+            // Stop at the first malformed option instead of reading past the header.
+            if (!throwOnError && kind > 1) {
+                const length = rawPacket[offset + 1]
+
+                if (!(length >= 2) || offset + Math.max(length, OPTION_LENGTHS[kind] ?? 0) > endOffset)
+                    break
+            }
+
+            switch (kind) {
                 case 0: // End of options list
                     offset = endOffset
                     break
@@ -82,49 +96,21 @@ export class TCPOptions {
                     this.sackOk = true
                     offset += 2
                     break
-                case 5: // SACK
-                    this.sack = []
-                    offset += 1
+                case 5: { // SACK (length: 10, 18, 26 or 34)
+                    const length = rawPacket[offset + 1]
 
-                    switch (rawPacket[offset]) {
-                        case 10:
-                            offset += 1
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            break
-                        case 18:
-                            offset += 1
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            break
-                        case 26:
-                            offset += 1
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            break
-                        case 34:
-                            offset += 1
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            this.sack.push([rawPacket.readUInt32BE(offset), rawPacket.readUInt32BE(offset + 4)])
-                            offset += 8
-                            break
-                        default:
-                            console.log(`Invalid TCP SACK option length ${rawPacket[offset + 1]}`)
-                            offset = endOffset
+                    if (length >= 10 && length <= 34 && (length - 2) % TCP_SACK_BLOCK_SIZE === 0) {
+                        this.sack = readTcpSackBlocks(rawPacket, offset + 2, (length - 2) / TCP_SACK_BLOCK_SIZE)
+                        offset += length
+                    }
+                    else {
+                        // Invalid length, the blocks and the options after it can't be read.
+                        this.sack = []
+                        offset = endOffset
                     }
 
                     break
+                }
                 case 8: // Timestamp (length: 10)
                     offset += 2
 
@@ -139,7 +125,11 @@ export class TCPOptions {
                     offset += rawPacket.readUInt8(offset + 1)
                     break
                 default:
-                    throw new Error(`Don't know how to process TCP option ${rawPacket[offset]}`)
+                    if (throwOnError)
+                        throw new Error(`Don't know how to process TCP option ${rawPacket[offset]}`)
+
+                    // Skipped by its length (MPTCP, TCP Fast Open, MD5 signature...), checked above.
+                    offset += rawPacket[offset + 1]
             }
         }
 
@@ -179,12 +169,17 @@ export class Tcp {
     windowSize: number
     checksum: number
     urgentPointer: number
-    options?: TCPOptions
+
+    /**
+     * Options of the header, left empty with the `skip.tcpOptions` decode option.
+     */
+    options: TCPOptions
+
     dataLength: number
     data: Buffer | null
 
     // http://en.wikipedia.org/wiki/Transmission_Control_Protocol
-    constructor(rawPacket: Buffer, offset: number = 0, len: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, len: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         const originalOffset = offset
 
         this.sport = rawPacket.readUInt16BE(offset) // 0, 1
@@ -214,12 +209,15 @@ export class Tcp {
         this.urgentPointer = rawPacket.readUInt16BE(offset) // 18, 19
         offset += 2
 
-        this.options = new TCPOptions()
         const optionsLen = this.headerLength - (offset - originalOffset)
-        if (optionsLen > 0) {
-            this.options.decode(rawPacket, offset, optionsLen)
+
+        this.options = new TCPOptions()
+
+        if (!options?.skip?.tcpOptions && optionsLen > 0 && (options?.throwOnError !== false || offset + optionsLen <= rawPacket.length))
+            this.options.decode(rawPacket, offset, optionsLen, options?.throwOnError !== false)
+
+        if (optionsLen > 0)
             offset += optionsLen
-        }
 
         this.dataLength = len - this.headerLength
         if (this.dataLength > 0) {
@@ -1,5 +1,5 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 import { DNS } from './dns'
 
 export class Udp {
@@ -36,8 +36,15 @@ export class Udp {
      */
     data: Buffer
 
+    /**
+     * DNS message of the data, only decoded here with an explicit `maxLayer: 'app'` (`toString()` decodes it otherwise).
+     */
+    dns?: DNS
+
+    #options?: DecodeOptions
+
     // https://en.wikipedia.org/wiki/User_Datagram_Protocol
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter, options?: DecodeOptions) {
         this.sport = rawPacket.readUInt16BE(offset)
         offset += 2
 
@@ -51,6 +58,10 @@ export class Udp {
         offset += 2
 
         this.data = rawPacket.subarray(offset, offset + (this.length - 8))
+        this.#options = options
+
+        if (options?.maxLayer === 'app' && this.#isDns())
+            this.dns = new DNS(this.data, 0, emitter, options)
 
         if (emitter)
             emitter.emit(Udp.decoderName, this)
@@ -59,9 +70,14 @@ export class Udp {
     toString() {
         let ret = `UDP ${this.sport} -> ${this.dport} len ${this.length}`
 
-        if (this.sport === 53 || this.dport === 53)
-            ret += (new DNS(this.data, 0).toString())
+        if (this.#options?.maxLayer !== 'l4' && this.#isDns())
+            ret += (this.dns ?? new DNS(this.data, 0, undefined, this.#options)).toString()
 
         return ret
     }
+
+    #isDns() {
+        // Without `throwOnError`, a capture cut before the end of the DNS header isn't decoded.
+        return (this.sport === 53 || this.dport === 53) && (this.#options?.throwOnError !== false || this.data.length >= 12)
+    }
 }
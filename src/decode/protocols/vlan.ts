@@ -1,5 +1,5 @@
+import type { DecodeEmitter } from '@/types'
 import type { Buffer } from 'node:buffer'
-import type EventEmitter from 'node:events'
 
 export class Vlan {
     static decoderName = 'vlan'
@@ -9,7 +9,7 @@ export class Vlan {
     id: number
 
     // http://en.wikipedia.org/wiki/IEEE_802.1Q
-    constructor(rawPacket: Buffer, offset: number = 0, emitter?: EventEmitter) {
+    constructor(rawPacket: Buffer, offset: number = 0, emitter?: DecodeEmitter) {
         this.priority = (rawPacket[offset] & 0xE0) >> 5
         this.canonicalFormat = (rawPacket[offset] & 0x10) >> 4
         this.id = ((rawPacket[offset] & 0x0F) << 8) | rawPacket[offset + 1]
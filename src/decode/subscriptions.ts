@@ -0,0 +1,143 @@
+import type { DecodeEmitter, DecodeOptions, PacketData } from '@/types'
+import { NpcapDecode } from '.'
+
+export type LayerHandler<T> = (layer: T) => void
+
+/**
+ * A decoder class (`Tcp`, `IPv4`...) or its `decoderName`.
+ */
+export type LayerDecoder<T> = { decoderName: string, prototype: T } | string
+
+// `maxLayer` needed to build the layers of the decoders, the other ones are built with 'l3'.
+const LAYER_DEPTHS: Record<string, 'l4' | 'app'> = {
+    icmp: 'l4',
+    igmp: 'l4',
+    tcp: 'l4',
+    udp: 'l4',
+    dns: 'app',
+}
+
+const DEPTH_ORDER = { l3: 0, l4: 1, app: 2 }
+
+// Compared by content, the options are often written inline in the `decode()` call.
+function sameOptions(a: DecodeOptions | undefined, b: DecodeOptions | undefined) {
+    if (a === b)
+        return true
+
+    return a !== undefined && b !== undefined
+        && a.lazy === b.lazy
+        && a.maxLayer === b.maxLayer
+        && a.throwOnError === b.throwOnError
+        && a.skip?.tcpOptions === b.skip?.tcpOptions
+        && a.skip?.dnsBody === b.skip?.dnsBody
+}
+
+function fanOut(handlers: LayerHandler<any>[]): LayerHandler<any> {
+    return (layer) => {
+        for (let i = 0; i < handlers.length; i++)
+            handlers[i](layer)
+    }
+}
+
+/**
+ * Per layer handlers, registered once and called by the decoders instead of emitting events.
+ *
+ * `emit()` calls a dispatch function compiled when the handlers change, the layers without handlers
+ * cost a single property lookup. `decode()` doesn't build the layers below the deepest one subscribed.
+ *
+ * @example
+ * const subscriptions = new DecodeSubscriptions()
+ *     .on(Tcp, tcp => console.log(tcp.sport, tcp.dport))
+ *
+ * session.on('packet', packet => subscriptions.decode(packet))
+ */
+export class DecodeSubscriptions implements DecodeEmitter {
+    #handlers = new Map<string, LayerHandler<any>[]>()
+    #dispatch: Record<string, LayerHandler<any> | undefined> = Object.create(null)
+    #maxLayer: 'l3' | 'l4' | 'app' = 'l3'
+
+    // Copy of the options of the last `decode()` call, and them with the `maxLayer` of the handlers.
+    #options?: DecodeOptions
+    #merged: DecodeOptions = { maxLayer: 'l3' }
+
+    /**
+     * Deepest layer the handlers need, the `maxLayer` used by `decode()`.
+     */
+    get maxLayer() {
+        return this.#maxLayer
+    }
+
+    on<T>(decoder: LayerDecoder<T>, handler: LayerHandler<T>): this {
+        const name = typeof decoder === 'string' ? decoder : decoder.decoderName
+        const handlers = this.#handlers.get(name) ?? []
+
+        handlers.push(handler)
+        this.#handlers.set(name, handlers)
+        this.#compile()
+
+        return this
+    }
+
+    off<T>(decoder: LayerDecoder<T>, handler: LayerHandler<T>): this {
+        const name = typeof decoder === 'string' ? decoder : decoder.decoderName
+        const handlers = this.#handlers.get(name)
+        const index = handlers ? handlers.indexOf(handler) : -1
+
+        if (handlers && index >= 0) {
+            handlers.splice(index, 1)
+
+            if (handlers.length === 0)
+                this.#handlers.delete(name)
+
+            this.#compile()
+        }
+
+        return this
+    }
+
+    /**
+     * Calls the handlers of the decoder, returns `false` when there is none.
+     */
+    emit(decoderName: string, layer: any): boolean {
+        const dispatch = this.#dispatch[decoderName]
+
+        if (dispatch === undefined)
+            return false
+
+        dispatch(layer)
+        return true
+    }
+
+    /**
+     * Decodes the packet down to the deepest layer with handlers, and calls them.
+     *
+     * A `maxLayer` given in the options takes precedence.
+     */
+    decode(packet: PacketData, options?: DecodeOptions): NpcapDecode {
+        if (!sameOptions(options, this.#options)) {
+            this.#options = options && { ...options, skip: options.skip && { ...options.skip } }
+            this.#merged = { ...options, maxLayer: options?.maxLayer ?? this.#maxLayer }
+        }
+
+        return new NpcapDecode(packet, this, this.#merged)
+    }
+
+    #compile() {
+        const dispatch: Record<string, LayerHandler<any> | undefined> = Object.create(null)
+        let maxLayer: 'l3' | 'l4' | 'app' = 'l3'
+
+        for (const [name, handlers] of this.#handlers) {
+            dispatch[name] = handlers.length === 1 ? handlers[0] : fanOut(handlers.slice())
+
+            const depth = LAYER_DEPTHS[name]
+
+            if (depth && DEPTH_ORDER[depth] > DEPTH_ORDER[maxLayer])
+                maxLayer = depth
+        }
+
+        this.#dispatch = dispatch
+        this.#maxLayer = maxLayer
+        this.#options = undefined
+        this.#merged = { maxLayer }
+    }
+}
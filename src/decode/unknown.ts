@@ -0,0 +1,119 @@
+import type { DecodeEmitter, DecodeOptions } from '@/types'
+import type { Buffer } from 'node:buffer'
+
+/** No decoder for the link type. */
+export const DECODE_UNKNOWN_LINK_TYPE = 1
+
+/** No decoder for the EtherType, LLC SAP or protocol family. */
+export const DECODE_UNKNOWN_ETHERTYPE = 2
+
+/** No decoder for the IP protocol. */
+export const DECODE_UNKNOWN_PROTOCOL = 3
+
+/** A variant of the header that isn't decoded (802.3 frame, non Ethernet / IPv4 ARP, radiotap revision...). */
+export const DECODE_UNSUPPORTED = 4
+
+/** The capture ends before the end of the header. */
+export const DECODE_TRUNCATED = 5
+
+/**
+ * Layer that couldn't be decoded, with the `throwOnError: false` decode option.
+ */
+export class Unknown {
+    static decoderName = 'unknown'
+
+    /**
+     * One of the `DECODE_*` constants.
+     */
+    code: number
+
+    /**
+     * EtherType, protocol... that has no decoder, `-1` for the link type (see `NpcapDecode.linkType`).
+     */
+    type: number
+
+    /**
+     * Offset of the undecoded layer in the packet.
+     */
+    offset: number
+
+    /**
+     * The undecoded bytes.
+     */
+    data: Buffer
+
+    reason: string
+
+    constructor(code: number, type: number, reason: string, rawPacket: Buffer, offset: number, emitter?: DecodeEmitter) {
+        this.code = code
+        this.type = type
+        this.reason = reason
+        this.offset = offset
+        this.data = rawPacket.subarray(offset)
+
+        if (emitter)
+            emitter.emit(Unknown.decoderName, this)
+    }
+
+    toString() {
+        return `unknown ${this.reason}`
+    }
+}
+
+/**
+ * Layer cut by the end of the capture, with the `throwOnError: false` decode option.
+ */
+export class Truncated {
+    static decoderName = 'truncated'
+
+    code = DECODE_TRUNCATED
+
+    /**
+     * Offset of the truncated header in the packet.
+     */
+    offset: number
+
+    /**
+     * Bytes needed to decode the header.
+     */
+    needed: number
+
+    /**
+     * The captured bytes of the header.
+     */
+    data: Buffer
+
+    constructor(rawPacket: Buffer, offset: number, needed: number, emitter?: DecodeEmitter) {
+        this.offset = offset
+        this.needed = needed
+        this.data = rawPacket.subarray(offset)
+
+        if (emitter)
+            emitter.emit(Truncated.decoderName, this)
+    }
+
+    toString() {
+        return `truncated ${this.data.length} of ${this.needed} bytes at offset ${this.offset}`
+    }
+}
+
+/**
+ * Throws the error, or with the `throwOnError: false` option returns an `Unknown` layer.
+ */
+export function decodeUnknown(code: number, type: number, reason: string, rawPacket: Buffer, offset: number, emitter: DecodeEmitter | undefined, options: DecodeOptions | undefined): Unknown {
+    if (options?.throwOnError !== false)
+        throw new Error(reason)
+
+    return new Unknown(code, type, reason, rawPacket, offset, emitter)
+}
+
+/**
+ * With the `throwOnError: false` option, returns a `Truncated` layer when less than `length` bytes are
+ * captured from `offset`. Otherwise the decoders read past the end and throw a `RangeError`.
+ */
+export function decodeTruncated(rawPacket: Buffer, offset: number, length: number, emitter: DecodeEmitter | undefined, options: DecodeOptions | undefined): Truncated | undefined {
+    if (options?.throwOnError !== false || offset + length <= rawPacket.length)
+        return undefined
+
+    return new Truncated(rawPacket, offset, length, emitter)
+}
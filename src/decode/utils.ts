@@ -8,4 +8,35 @@ for (let i = 0; i <= 255; i++) {
     int8_to_dec[i] = i.toString()
 }
 
-export { int8_to_dec, int8_to_hex, int8_to_hex_nopad }
+/**
+ * Least recently used cache, for the strings formatted again and again (addresses).
+ */
+class LruCache<K, V> {
+    #entries = new Map<K, V>()
+    #capacity: number
+
+    constructor(capacity: number) {
+        this.#capacity = capacity
+    }
+
+    get(key: K): V | undefined {
+        const value = this.#entries.get(key)
+
+        // Map keeps the insertion order, re-inserting moves the key to the most recent end.
+        if (value !== undefined) {
+            this.#entries.delete(key)
+            this.#entries.set(key, value)
+        }
+
+        return value
+    }
+
+    set(key: K, value: V) {
+        if (!this.#entries.delete(key) && this.#entries.size >= this.#capacity)
+            this.#entries.delete(this.#entries.keys().next().value as K)
+
+        this.#entries.set(key, value)
+    }
+}
+
+export { int8_to_dec, int8_to_hex, int8_to_hex_nopad, LruCache }
@@ -0,0 +1,120 @@
+import { Buffer } from 'node:buffer'
+import { endianness } from 'node:os'
+import { int8_to_dec, int8_to_hex as hex } from './decode/utils'
+
+/** Maximum number of answers decoded per message. */
+export const DNS_MAX_ANSWERS = 16
+
+/** Size in bytes of the record filled by the native DNS parser. */
+export const DNS_RECORD_SIZE = 16 + 32 * DNS_MAX_ANSWERS
+
+/** Name id of a missing name. */
+export const DNS_NO_NAME = 0xFFFFFFFF
+
+const DNS_PARSED = 1
+const DNS_MALFORMED = 2
+
+const littleEndian = endianness() === 'LE'
+
+/**
+ * Reads the DNS message of the current packet decoded by the native parser.
+ *
+ * Only the first question and the A, AAAA and CNAME answers are decoded. The names are
+ * interned natively and delivered once, the getters return the same string every time
+ * a name is seen again.
+ *
+ * Layout (`lib/dns.h`), multi-byte fields in host byte order:
+ *
+ * | Offset | Field |
+ * | ------ | ----- |
+ * | 0 | id (u16) |
+ * | 2 | flags (u16) |
+ * | 4 | questionType (u16) |
+ * | 6 | questionClass (u16) |
+ * | 8 | questionName (u32) |
+ * | 12 | answerCount (u16) |
+ * | 14 | status (u8) |
+ * | 16 + 32 * i | answer: name (u32), type (u16), class (u16), ttl (u32), target (u32), address (16 bytes) |
+ */
+export class DnsRecord {
+    /** Raw record shared with the native session. */
+    buffer: Buffer
+
+    /** Interned names by id. */
+    names: string[] = []
+
+    #view: DataView
+
+    constructor(buffer: Buffer = Buffer.alloc(DNS_RECORD_SIZE)) {
+        this.buffer = buffer
+        this.#view = new DataView(buffer.buffer, buffer.byteOffset, DNS_RECORD_SIZE)
+    }
+
+    /**
+     * Adds the names interned natively, starting at the id `firstId`.
+     *
+     * The native table restarts from `0` when it's full.
+     */
+    addNames(firstId: number, names: string[]) {
+        this.names.length = firstId
+
+        for (const name of names)
+            this.names.push(name)
+    }
+
+    /** The packet carries a DNS message. */
+    get valid() { return this.#view.getUint8(14) !== 0 }
+
+    /** The message is malformed, only the fields decoded before the error are meaningful. */
+    get malformed() { return this.#view.getUint8(14) === DNS_MALFORMED }
+
+    get parsed() { return this.#view.getUint8(14) === DNS_PARSED }
+
+    get id() { return this.#view.getUint16(0, littleEndian) }
+    get flags() { return this.#view.getUint16(2, littleEndian) }
+    get isResponse() { return (this.flags & 0x8000) !== 0 }
+    get opcode() { return (this.flags >> 11) & 0x0F }
+    get responseCode() { return this.flags & 0x0F }
+
+    get questionType() { return this.#view.getUint16(4, littleEndian) }
+    get questionClass() { return this.#view.getUint16(6, littleEndian) }
+    get questionNameId() { return this.#view.getUint32(8, littleEndian) }
+    get questionName(): string | undefined { return this.names[this.questionNameId] }
+
+    /** Number of A, AAAA and CNAME answers decoded. */
+    get answerCount() { return this.#view.getUint16(12, littleEndian) }
+
+    answerNameId(index: number) { return this.#view.getUint32(16 + 32 * index, littleEndian) }
+    answerName(index: number): string | undefined { return this.names[this.answerNameId(index)] }
+    answerType(index: number) { return this.#view.getUint16(20 + 32 * index, littleEndian) }
+    answerClass(index: number) { return this.#view.getUint16(22 + 32 * index, littleEndian) }
+    answerTtl(index: number) { return this.#view.getUint32(24 + 32 * index, littleEndian) }
+
+    /** Name id of the CNAME target. */
+    answerTargetId(index: number) { return this.#view.getUint32(28 + 32 * index, littleEndian) }
+    answerTarget(index: number): string | undefined { return this.names[this.answerTargetId(index)] }
+
+    /** IPv4 address of an A answer as an unsigned 32-bit number. */
+    answerAddress4(index: number) { return this.#view.getUint32(32 + 32 * index) }
+
+    /** Address of an A or AAAA answer. */
+    answerAddress(index: number): string | undefined {
+        const type = this.answerType(index)
+        const offset = 32 + 32 * index
+        const buffer = this.buffer
+
+        if (type === 1)
+            return `${int8_to_dec[buffer[offset]]}.${int8_to_dec[buffer[offset + 1]]}.${int8_to_dec[buffer[offset + 2]]}.${int8_to_dec[buffer[offset + 3]]}`
+
+        if (type === 28) {
+            let ret = ''
+
+            for (let i = 0; i < 16; i += 2)
+                ret += `${i > 0 ? ':' : ''}${hex[buffer[offset + i]]}${hex[buffer[offset + i + 1]]}`
+
+            return ret
+        }
+
+        return undefined
+    }
+}
@@ -0,0 +1,78 @@
+import { Buffer } from 'node:buffer'
+import { endianness } from 'node:os'
+
+/** Size in bytes of the header written by the native session. */
+export const PACKET_HEADER_SIZE = 40
+
+const littleEndian = endianness() === 'LE'
+
+/**
+ * Reads the header of the current packet written by the native session.
+ *
+ * The views are created once: the getters return the values of the packet being emitted
+ * and never allocate (except `tvSec64`).
+ *
+ * Layout (`lib/session.h`), in host byte order:
+ *
+ * | Offset | Field |
+ * | ------ | ----- |
+ * | 0 | tvSec (u32, wraps in 2106) |
+ * | 4 | tvUsec (u32) |
+ * | 8 | caplen (u32) |
+ * | 12 | len (u32) |
+ * | 16 | tvSec (u64) |
+ * | 24 | tvNsec (u32) |
+ * | 28 | ifindex (u32) |
+ * | 32 | drops (u32) |
+ * | 36 | sequence (u32) |
+ *
+ * The first 16 bytes are the layout of the `header` Buffer of the previous versions.
+ */
+export class PacketHeader {
+    /** Raw header shared with the native session. */
+    buffer: Buffer
+
+    /** The header as 32-bit words, `words[2]` is `caplen`. */
+    words: Uint32Array
+
+    /** `seconds[0]` holds the 64-bit seconds. */
+    seconds: BigUint64Array
+
+    /**
+     * @param buffer - At least `PACKET_HEADER_SIZE` bytes, aligned on 8 bytes (as the `Buffer.alloc()` ones).
+     */
+    constructor(buffer: Buffer = Buffer.alloc(PACKET_HEADER_SIZE)) {
+        this.buffer = buffer
+        this.words = new Uint32Array(buffer.buffer, buffer.byteOffset, PACKET_HEADER_SIZE / 4)
+        this.seconds = new BigUint64Array(buffer.buffer, buffer.byteOffset + 16, 1)
+    }
+
+    /** Seconds since the epoch, exact up to 2^53. */
+    get tvSec() {
+        return littleEndian
+            ? this.words[5] * 0x100000000 + this.words[4]
+            : this.words[4] * 0x100000000 + this.words[5]
+    }
+
+    get tvSec64() { return this.seconds[0] }
+    get tvUsec() { return this.words[1] }
+    get tvNsec() { return this.words[6] }
+
+    /** Number of bytes in the packet `buffer`. */
+    get caplen() { return this.words[2] }
+
+    /** Length of the packet on the wire. */
+    get len() { return this.words[3] }
+
+    /** Index of the capturing interface, only known for `LINKTYPE_LINUX_SLL2` captures (`0` otherwise). */
+    get ifindex() { return this.words[7] }
+
+    /** Packets dropped by the OS or the interface since the previous packet, live captures only. */
+    get drops() { return this.words[8] }
+
+    /** Number of the packet in the session, from `1`. */
+    get sequence() { return this.words[9] }
+
+    /** Milliseconds since the epoch. */
+    get timestamp() { return this.tvSec * 1000 + this.tvNsec / 1000000 }
+}
@@ -23,7 +23,16 @@ export function createOfflineSession(path: string, options: OfflineSessionOption
     return new NpcapSession(false, path, options)
 }
 
+export * from './batch'
 export * from './decode'
+export * from './dns'
+export * from './header'
+export * from './layout'
+export * from './layouts'
+export * from './meta'
 export * from './npcap'
+export * from './packet'
+export * from './retained'
 export * from './session'
 export * from './types'
+export * from './view'
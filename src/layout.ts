@@ -0,0 +1,56 @@
+import { Buffer } from 'node:buffer'
+import { int8_to_dec, int8_to_hex as hex } from './decode/utils'
+
+/**
+ * Window over one layer of the current packet.
+ *
+ * The views are re-pointed at every packet (see `PacketView.update`), the getters read the
+ * fields from the captured bytes when they are accessed.
+ */
+export abstract class LayerView {
+    /** Captured bytes of the current packet. */
+    buffer: Buffer = Buffer.alloc(0)
+
+    /** Offset of the header in `buffer`. */
+    offset = 0
+
+    /** The layer is present in the current packet. */
+    valid = false
+
+    protected view = new DataView(this.buffer.buffer)
+
+    point(buffer: Buffer, offset: number) {
+        if (buffer !== this.buffer) {
+            this.buffer = buffer
+            this.view = new DataView(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+        }
+
+        this.offset = offset
+        this.valid = true
+    }
+
+    protected formatMac(offset: number): string {
+        const buffer = this.buffer
+        const i = this.offset + offset
+
+        return `${hex[buffer[i]]}:${hex[buffer[i + 1]]}:${hex[buffer[i + 2]]}:${hex[buffer[i + 3]]}:${hex[buffer[i + 4]]}:${hex[buffer[i + 5]]}`
+    }
+
+    protected formatIPv4(offset: number): string {
+        const buffer = this.buffer
+        const i = this.offset + offset
+
+        return `${int8_to_dec[buffer[i]]}.${int8_to_dec[buffer[i + 1]]}.${int8_to_dec[buffer[i + 2]]}.${int8_to_dec[buffer[i + 3]]}`
+    }
+
+    protected formatIPv6(offset: number): string {
+        const buffer = this.buffer
+        const start = this.offset + offset
+        let ret = ''
+
+        for (let i = 0; i < 16; i += 2)
+            ret += `${i > 0 ? ':' : ''}${hex[buffer[start + i]]}${hex[buffer[start + i + 1]]}`
+
+        return ret
+    }
+}
@@ -0,0 +1,121 @@
+// Generated by scripts/codegen.ts from schema/layouts.json, do not edit.
+import type { Buffer } from 'node:buffer'
+import { LayerView } from './layout'
+
+/** Size in bytes of the fixed part of `EthernetLayout`. */
+export const ETHERNET_SIZE = 14
+
+// https://en.wikipedia.org/wiki/Ethernet_frame
+export class EthernetLayout extends LayerView {
+    get dhost() { return this.formatMac(0) }
+    get shost() { return this.formatMac(6) }
+
+    /** EtherType of the payload. */
+    get type() { return this.view.getUint16(this.offset + 12) }
+}
+
+/** Size in bytes of the fixed part of `IPv4Layout`. */
+export const IPV4_SIZE = 20
+
+// http://en.wikipedia.org/wiki/IPv4
+export class IPv4Layout extends LayerView {
+    get version() { return (this.buffer[this.offset] & 0xF0) >> 4 }
+    get headerLength() { return (this.buffer[this.offset] & 0x0F) << 2 }
+    get diffserv() { return this.buffer[this.offset + 1] }
+    get length() { return this.view.getUint16(this.offset + 2) }
+    get identification() { return this.view.getUint16(this.offset + 4) }
+
+    /** Reserved, Don't Fragment and More Fragments bits. */
+    get flags() { return (this.buffer[this.offset + 6] & 0xE0) >> 5 }
+
+    get doNotFragment() { return (this.buffer[this.offset + 6] & 0x40) !== 0 }
+    get moreFragments() { return (this.buffer[this.offset + 6] & 0x20) !== 0 }
+    get fragmentOffset() { return (this.view.getUint16(this.offset + 6) & 0x1FFF) << 3 }
+    get ttl() { return this.buffer[this.offset + 8] }
+    get protocol() { return this.buffer[this.offset + 9] }
+    get headerChecksum() { return this.view.getUint16(this.offset + 10) }
+
+    /** `saddr` as an unsigned 32-bit number. */
+    get saddr4() { return this.view.getUint32(this.offset + 12) }
+
+    get saddr() { return this.formatIPv4(12) }
+
+    /** `daddr` as an unsigned 32-bit number. */
+    get daddr4() { return this.view.getUint32(this.offset + 16) }
+
+    get daddr() { return this.formatIPv4(16) }
+}
+
+/** Size in bytes of the fixed part of `IPv6Layout`. */
+export const IPV6_SIZE = 40
+
+// https://en.wikipedia.org/wiki/IPv6_packet
+export class IPv6Layout extends LayerView {
+    get version() { return (this.buffer[this.offset] & 0xF0) >> 4 }
+    get trafficClass() { return (this.view.getUint16(this.offset) & 0x0FF0) >> 4 }
+    get flowLabel() { return this.view.getUint32(this.offset) & 0x000FFFFF }
+    get payloadLength() { return this.view.getUint16(this.offset + 4) }
+    get nextHeader() { return this.buffer[this.offset + 6] }
+    get hopLimit() { return this.buffer[this.offset + 7] }
+    get saddr() { return this.formatIPv6(8) }
+    get daddr() { return this.formatIPv6(24) }
+}
+
+/** Size in bytes of the fixed part of `TcpLayout`. */
+export const TCP_SIZE = 20
+
+// http://en.wikipedia.org/wiki/Transmission_Control_Protocol
+export class TcpLayout extends LayerView {
+    get sport() { return this.view.getUint16(this.offset) }
+    get dport() { return this.view.getUint16(this.offset + 2) }
+    get seqno() { return this.view.getUint32(this.offset + 4) }
+    get ackno() { return this.view.getUint32(this.offset + 8) }
+    get headerLength() { return (this.buffer[this.offset + 12] & 0xF0) >> 2 }
+
+    /** NS, CWR, ECE, URG, ACK, PSH, RST, SYN and FIN bits. */
+    get flags() { return this.view.getUint16(this.offset + 12) & 0x01FF }
+
+    get fin() { return (this.buffer[this.offset + 13] & 0x01) !== 0 }
+    get syn() { return (this.buffer[this.offset + 13] & 0x02) !== 0 }
+    get rst() { return (this.buffer[this.offset + 13] & 0x04) !== 0 }
+    get psh() { return (this.buffer[this.offset + 13] & 0x08) !== 0 }
+    get ack() { return (this.buffer[this.offset + 13] & 0x10) !== 0 }
+    get urg() { return (this.buffer[this.offset + 13] & 0x20) !== 0 }
+    get windowSize() { return this.view.getUint16(this.offset + 14) }
+    get checksum() { return this.view.getUint16(this.offset + 16) }
+    get urgentPointer() { return this.view.getUint16(this.offset + 18) }
+}
+
+/** Size in bytes of each block read by `readTcpSackBlocks`. */
+export const TCP_SACK_BLOCK_SIZE = 8
+
+// https://www.rfc-editor.org/rfc/rfc2018
+export function readTcpSackBlocks(buffer: Buffer, offset: number, count: number): number[][] {
+    const blocks: number[][] = []
+
+    for (let i = 0; i < count; i++, offset += 8)
+        blocks.push([buffer.readUInt32BE(offset), buffer.readUInt32BE(offset + 4)])
+
+    return blocks
+}
+
+/** Size in bytes of the fixed part of `UdpLayout`. */
+export const UDP_SIZE = 8
+
+// https://en.wikipedia.org/wiki/User_Datagram_Protocol
+export class UdpLayout extends LayerView {
+    get sport() { return this.view.getUint16(this.offset) }
+    get dport() { return this.view.getUint16(this.offset + 2) }
+    get length() { return this.view.getUint16(this.offset + 4) }
+    get checksum() { return this.view.getUint16(this.offset + 6) }
+}
+
+/** Size in bytes of the fixed part of `IcmpLayout`. */
+export const ICMP_SIZE = 8
+
+// https://en.wikipedia.org/wiki/Internet_Control_Message_Protocol
+export class IcmpLayout extends LayerView {
+    get type() { return this.buffer[this.offset] }
+    get code() { return this.buffer[this.offset + 1] }
+    get checksum() { return this.view.getUint16(this.offset + 2) }
+}
@@ -0,0 +1,307 @@
+import { Buffer } from 'node:buffer'
+import { endianness } from 'node:os'
+import { int8_to_dec, int8_to_hex as hex } from './decode/utils'
+
+/** The headers were parsed up to the transport layer. */
+export const META_PARSED = 0x0001
+
+/** The capture ends before the end of the headers. */
+export const META_TRUNCATED = 0x0002
+
+/** `vlan` holds the id of the (outer) 802.1Q tag. */
+export const META_VLAN = 0x0004
+
+/** IP fragment, only the first one has ports. */
+export const META_FRAGMENT = 0x0008
+
+/** The IPv4 header checksum is wrong. */
+export const META_IP_CHECKSUM_BAD = 0x0010
+
+/** The TCP / UDP / ICMP checksum is wrong. */
+export const META_L4_CHECKSUM_BAD = 0x0020
+
+/** The checksums are left to the NIC, they weren't verified. */
+export const META_CHECKSUM_OFFLOAD = 0x0040
+
+/** Tunnels were peeled, the `outer*` fields hold the outermost one. */
+export const META_TUNNEL = 0x0080
+
+/** `mplsLabel` holds the top label of the MPLS stack. */
+export const META_MPLS = 0x0100
+
+export const TUNNEL_NONE = 0
+export const TUNNEL_GRE = 1
+export const TUNNEL_VXLAN = 2
+export const TUNNEL_GENEVE = 3
+
+/** IPv4 / IPv6 directly inside IPv4 / IPv6. */
+export const TUNNEL_IPIP = 4
+
+/** The radiotap fields (`frequency`, `signal`...) were read. */
+export const META_RADIOTAP = 0x0200
+
+/** The 802.11 header was parsed, `frameControl` and the addresses are set. */
+export const META_WLAN = 0x0400
+
+/** Size in bytes of the record filled by the native parser. */
+export const PACKET_META_SIZE = 160
+
+const littleEndian = endianness() === 'LE'
+
+/**
+ * Reads the headers of the current packet parsed by the native parser.
+ *
+ * The record is overwritten for every packet, the getters always return the
+ * values of the packet being emitted and never allocate (except the address strings).
+ *
+ * Layout (`lib/parser.h`), multi-byte fields in host byte order:
+ *
+ * | Offset | Field |
+ * | ------ | ----- |
+ * | 0 | linkType (u16) |
+ * | 2 | flags (u16) |
+ * | 4 | l3Offset (u32) |
+ * | 8 | l4Offset (u32) |
+ * | 12 | payloadOffset (u32) |
+ * | 16 | etherType (u16) |
+ * | 18 | vlan (u16) |
+ * | 20 | ipVersion (u8) |
+ * | 21 | protocol (u8) |
+ * | 22 | ttl (u8) |
+ * | 23 | tcpFlags (u8) |
+ * | 24 | sport (u16) |
+ * | 26 | dport (u16) |
+ * | 28 | payloadLength (u32) |
+ * | 32 | saddr (16 bytes, network order) |
+ * | 48 | daddr (16 bytes, network order) |
+ * | 64 | flowHash (u64) |
+ * | 72 | tunnelType (u8) |
+ * | 73 | tunnelDepth (u8) |
+ * | 74 | outerIpVersion (u8) |
+ * | 75 | outerProtocol (u8) |
+ * | 76 | outerSport (u16) |
+ * | 78 | outerDport (u16) |
+ * | 80 | tunnelId (u32) |
+ * | 84 | mplsLabel (u32) |
+ * | 88 | outerL3Offset (u32) |
+ * | 92 | innerOffset (u32) |
+ * | 96 | outerSaddr (16 bytes, network order) |
+ * | 112 | outerDaddr (16 bytes, network order) |
+ * | 128 | frequency (u16) |
+ * | 130 | channelFlags (u16) |
+ * | 132 | rate (u16) |
+ * | 134 | signal (i8) |
+ * | 135 | noise (i8) |
+ * | 136 | frameControl (u16) |
+ * | 138 | radiotapFlags (u8) |
+ * | 139 | antenna (u8) |
+ * | 140 | addr1 (6 bytes) |
+ * | 146 | addr2 (6 bytes) |
+ * | 152 | addr3 (6 bytes) |
+ * | 158 | sequence (u16) |
+ *
+ * With the `tunnels` option, the fields up to `flowHash` describe the innermost packet.
+ */
+export class PacketMeta {
+    /** Raw record shared with the native session. */
+    buffer: Buffer
+
+    #view: DataView
+
+    constructor(buffer: Buffer = Buffer.alloc(PACKET_META_SIZE)) {
+        this.buffer = buffer
+        this.#view = new DataView(buffer.buffer, buffer.byteOffset, PACKET_META_SIZE)
+    }
+
+    get linkType() { return this.#view.getUint16(0, littleEndian) }
+    get flags() { return this.#view.getUint16(2, littleEndian) }
+
+    /** The headers were parsed up to the transport layer. */
+    get parsed() { return (this.flags & META_PARSED) !== 0 }
+
+    /** The capture ends before the end of the headers. */
+    get truncated() { return (this.flags & META_TRUNCATED) !== 0 }
+
+    /** The IPv4 header checksum is wrong (only with the `checksums` option). */
+    get ipChecksumBad() { return (this.flags & META_IP_CHECKSUM_BAD) !== 0 }
+
+    /** The TCP / UDP / ICMP checksum is wrong (only with the `checksums` option). */
+    get l4ChecksumBad() { return (this.flags & META_L4_CHECKSUM_BAD) !== 0 }
+
+    /** The checksums are left to the NIC (offload), they weren't verified. */
+    get checksumOffload() { return (this.flags & META_CHECKSUM_OFFLOAD) !== 0 }
+
+    /** Offset of the network (IP) header. */
+    get l3Offset() { return this.#view.getUint32(4, littleEndian) }
+
+    /** Offset of the transport header. */
+    get l4Offset() { return this.#view.getUint32(8, littleEndian) }
+
+    /** Offset of the transport payload. */
+    get payloadOffset() { return this.#view.getUint32(12, littleEndian) }
+
+    get etherType() { return this.#view.getUint16(16, littleEndian) }
+
+    /** VLAN id of the outer tag, `-1` if the frame isn't tagged. */
+    get vlan() { return (this.flags & META_VLAN) !== 0 ? this.#view.getUint16(18, littleEndian) : -1 }
+
+    /** `4`, `6` or `0` for non IP packets. */
+    get ipVersion() { return this.#view.getUint8(20) }
+
+    /** IP protocol number of the transport header. */
+    get protocol() { return this.#view.getUint8(21) }
+
+    /** TTL or hop limit. */
+    get ttl() { return this.#view.getUint8(22) }
+
+    get tcpFlags() { return this.#view.getUint8(23) }
+    get sport() { return this.#view.getUint16(24, littleEndian) }
+    get dport() { return this.#view.getUint16(26, littleEndian) }
+
+    /** Transport payload length, from the IP header (the capture might be truncated). */
+    get payloadLength() { return this.#view.getUint32(28, littleEndian) }
+
+    /** IPv4 source address as an unsigned 32-bit number. */
+    get saddr4() { return this.#view.getUint32(32) }
+
+    /** IPv4 destination address as an unsigned 32-bit number. */
+    get daddr4() { return this.#view.getUint32(48) }
+
+    /**
+     * Direction independent hash of the 5-tuple (without the ports for IP fragments), `0n` for non IP packets.
+     *
+     * Both directions of a connection share the same hash. The hash is keyed by a random seed drawn
+     * when the session is opened, it can't be compared across sessions.
+     */
+    get flowHash() { return this.#view.getBigUint64(64, littleEndian) }
+
+    /** Low 32 bits of `flowHash`, to shard or sample flows without a `bigint`. */
+    get flowHash32() { return this.#view.getUint32(littleEndian ? 64 : 68, littleEndian) }
+
+    get saddr() { return this.#formatAddress(this.ipVersion, 32) }
+    get daddr() { return this.#formatAddress(this.ipVersion, 48) }
+
+    /** An encapsulation was peeled (only with the `tunnels` option). */
+    get tunneled() { return (this.flags & META_TUNNEL) !== 0 }
+
+    /** One of the `TUNNEL_*` constants, for the outermost tunnel. */
+    get tunnelType() { return this.#view.getUint8(72) }
+
+    /** Number of encapsulations peeled. */
+    get tunnelDepth() { return this.#view.getUint8(73) }
+
+    /** VNI (VXLAN / GENEVE) or GRE key of the outermost tunnel. */
+    get tunnelId() { return this.#view.getUint32(80, littleEndian) }
+
+    /** Top label of the MPLS stack, `-1` if the packet isn't labeled. */
+    get mplsLabel() { return (this.flags & META_MPLS) !== 0 ? this.#view.getUint32(84, littleEndian) : -1 }
+
+    /** `4` or `6` for the outer IP header of the tunnel, `0` if there's no tunnel. */
+    get outerIpVersion() { return this.#view.getUint8(74) }
+
+    get outerProtocol() { return this.#view.getUint8(75) }
+    get outerSport() { return this.#view.getUint16(76, littleEndian) }
+    get outerDport() { return this.#view.getUint16(78, littleEndian) }
+
+    /** Offset of the outer IP header. */
+    get outerL3Offset() { return this.#view.getUint32(88, littleEndian) }
+
+    /** Offset of the innermost encapsulated frame: Ethernet for VXLAN, GENEVE and GRE bridging, IP otherwise. */
+    get innerOffset() { return this.#view.getUint32(92, littleEndian) }
+
+    /** Outer IPv4 source address as an unsigned 32-bit number. */
+    get outerSaddr4() { return this.#view.getUint32(96) }
+
+    /** Outer IPv4 destination address as an unsigned 32-bit number. */
+    get outerDaddr4() { return this.#view.getUint32(112) }
+
+    get outerSaddr() { return this.#formatAddress(this.outerIpVersion, 96) }
+    get outerDaddr() { return this.#formatAddress(this.outerIpVersion, 112) }
+
+    /** The radiotap header was read (`LINKTYPE_IEEE802_11_RADIO`). */
+    get radiotap() { return (this.flags & META_RADIOTAP) !== 0 }
+
+    /** The 802.11 header was parsed. */
+    get wlan() { return (this.flags & META_WLAN) !== 0 }
+
+    /** Channel frequency in MHz, `0` if not reported. */
+    get frequency() { return this.#view.getUint16(128, littleEndian) }
+
+    /** Channel number derived from `frequency`, `0` if unknown. */
+    get channel() {
+        const frequency = this.frequency
+
+        if (frequency === 2484)
+            return 14
+
+        if (frequency >= 2412 && frequency < 2484)
+            return (frequency - 2407) / 5
+
+        if (frequency > 5950 && frequency <= 7125)
+            return (frequency - 5950) / 5
+
+        if (frequency >= 5000 && frequency <= 5925)
+            return (frequency - 5000) / 5
+
+        return 0
+    }
+
+    get channelFlags() { return this.#view.getUint16(130, littleEndian) }
+
+    /** Legacy data rate in Mbps, `0` if not reported (HT / VHT rates are given as MCS). */
+    get rate() { return this.#view.getUint16(132, littleEndian) / 2 }
+
+    /** Antenna signal in dBm, `0` if not reported. */
+    get signal() { return this.#view.getInt8(134) }
+
+    /** Antenna noise in dBm, `0` if not reported. */
+    get noise() { return this.#view.getInt8(135) }
+
+    get frameControl() { return this.#view.getUint16(136, littleEndian) }
+
+    /** `0` management, `1` control, `2` data. */
+    get frameType() { return (this.frameControl >> 2) & 0x03 }
+
+    get frameSubtype() { return (this.frameControl >> 4) & 0x0F }
+
+    get radiotapFlags() { return this.#view.getUint8(138) }
+    get antenna() { return this.#view.getUint8(139) }
+
+    /** Receiver address. */
+    get addr1() { return this.#formatMac(140) }
+
+    /** Transmitter address, all zeros for CTS and ACK frames. */
+    get addr2() { return this.#formatMac(146) }
+
+    /** BSSID, source or destination address depending on the DS bits. */
+    get addr3() { return this.#formatMac(152) }
+
+    get sequence() { return this.#view.getUint16(158, littleEndian) }
+
+    #formatMac(offset: number): string {
+        const buffer = this.buffer
+
+        if (!this.wlan)
+            return ''
+
+        return `${hex[buffer[offset]]}:${hex[buffer[offset + 1]]}:${hex[buffer[offset + 2]]}:${hex[buffer[offset + 3]]}:${hex[buffer[offset + 4]]}:${hex[buffer[offset + 5]]}`
+    }
+
+    #formatAddress(version: number, offset: number): string {
+        const buffer = this.buffer
+
+        if (version === 4)
+            return `${int8_to_dec[buffer[offset]]}.${int8_to_dec[buffer[offset + 1]]}.${int8_to_dec[buffer[offset + 2]]}.${int8_to_dec[buffer[offset + 3]]}`
+
+        if (version === 6) {
+            let ret = ''
+
+            for (let i = 0; i < 16; i += 2)
+                ret += `${i > 0 ? ':' : ''}${hex[buffer[offset + i]]}${hex[buffer[offset + i + 1]]}`
+
+            return ret
+        }
+
+        return ''
+    }
+}
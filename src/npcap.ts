@@ -1,6 +1,6 @@
 import { createRequire } from 'node:module'
 import type { Buffer } from 'node:buffer'
-import type { CaptureStats, Device, LinkType } from './types'
+import type { CaptureStats, Device, FlowCutoffStats, LinkType, StreamChunk } from './types'
 
 const require = createRequire(import.meta.url)
 const addon = require('../build/Release/npcap.node')
@@ -10,7 +10,7 @@ export interface Session {
      * Opens a live connection for capturing network packets.
      *
      * @param {string} device - The name of the network interface to capture packets from.
-     * @param {() => void} onPacket - A callback function to handle captured packets.
+     * @param {(...header: number[]) => void} onPacket - A callback function to handle captured packets.
      * @param {string} filter - A filter expression for capturing specific packets.
      * @param {number} bufferSize - The size of the buffer for capturing packets.
      * @param {Buffer} header - The buffer for storing the header of captured packets.
@@ -27,7 +27,7 @@ export interface Session {
      */
     openLive: (
         device: string,
-        onPacket: () => void,
+        onPacket: (...header: number[]) => void,
         filter: string,
         bufferSize: number,
         header: Buffer,
@@ -45,7 +45,7 @@ export interface Session {
      * Opens an offline connection for processing captured network packets from a pcap file.
      *
      * @param {string} device - The path to the pcap file.
-     * @param {() => void} onPacket - A callback function to handle packets.
+     * @param {(...header: number[]) => void} onPacket - A callback function to handle packets.
      * @param {string} filter - A filter expression for capturing specific packets.
      * @param {number} bufferSize - The size of the buffer for processing packets.
      * @param {Buffer} header - The header buffer.
@@ -62,7 +62,7 @@ export interface Session {
      */
     openOffline: (
         device: string,
-        onPacket: () => void,
+        onPacket: (...header: number[]) => void,
         filter: string,
         bufferSize: number,
         header: Buffer,
@@ -115,10 +115,218 @@ export interface Session {
      */
     inject: (data: Buffer) => boolean
 
+    /**
+     * Limits the number of bytes of each packet copied into the packet buffer.
+     *
+     * The dump file (`outFile`) still receives the full packet.
+     *
+     * @param {number} length - Maximum number of bytes to copy, `0` to copy the whole packet.
+     * @param {boolean} headers - Copy only up to the end of the transport header.
+     *
+     * @returns {boolean} Returns true if the slice length was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setSliceLength: (length: number, headers: boolean) => boolean
+
+    /**
+     * Compiles the patterns searched in the payload of each packet.
+     *
+     * The matched pattern indexes are written to `matches` as `[count, ...indexes]`.
+     *
+     * @param {Buffer[]} patterns - The byte signatures to search, an empty array disables matching.
+     * @param {Buffer} matches - The buffer receiving the matches, at least `4 * (patterns.length + 1)` bytes.
+     * @param {boolean} onlyMatched - Drop the packets that don't match any pattern.
+     *
+     * @returns {boolean} Returns true if the patterns were compiled.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setPatterns: (patterns: Buffer[], matches: Buffer, onlyMatched: boolean) => boolean
+
+    /**
+     * Enables the per-flow cutoff, flows over their budget are neither delivered nor dumped.
+     *
+     * @param {number} bytes - Transport payload bytes delivered per flow, `0` for no limit.
+     * @param {number} packets - Packets delivered per flow, `0` for no limit.
+     * @param {number} timeout - Seconds without packets after which a flow ends.
+     * @param {number} maxFlows - Maximum number of flows tracked at once.
+     * @param {(flow: FlowCutoffStats) => void} onFlowEnd - Called when a flow that was cut ends.
+     *
+     * @returns {boolean} Returns true if the cutoff was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setFlowCutoff: (bytes: number, packets: number, timeout: number, maxFlows: number, onFlowEnd: (flow: FlowCutoffStats) => void) => boolean
+
+    /**
+     * Sets the direction of the captured packets.
+     *
+     * @param {'in' | 'out' | 'both'} direction - Capture the received, sent or all the packets.
+     * @param {boolean} dedupeLoopback - Drop the outgoing copy of the loopback packets.
+     *
+     * @returns {boolean} Returns true if the direction is applied by the kernel,
+     * false if it's filtered natively from the link-layer header.
+     * @throws {Error} If the arguments are invalid, the session is closed, or the link-layer header
+     * doesn't record the direction while it's needed.
+     */
+    setDirection: (direction: 'in' | 'out' | 'both', dedupeLoopback: boolean) => boolean
+
+    /**
+     * Enables the suppression of duplicated packets.
+     *
+     * @param {number} window - Time window in milliseconds.
+     * @param {number} size - Number of recent packets remembered, `0` disables the suppression.
+     *
+     * @returns {boolean} Returns true if the dedupe was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setDedupe: (window: number, size: number) => boolean
+
+    /**
+     * Sets the buffer filled with the parsed headers of every packet (see `PacketMeta`).
+     *
+     * @param {Buffer | null} meta - Buffer of at least 160 bytes, `null` disables the parsing.
+     *
+     * @returns {boolean} Returns true if the buffer was set.
+     * @throws {Error} If the buffer is too small or not aligned.
+     */
+    setMetadata: (meta: Buffer | null) => boolean
+
+    /**
+     * Enables the native verification of the IPv4, TCP, UDP and ICMP checksums.
+     *
+     * @param {boolean} verify - Whether to verify the checksums.
+     *
+     * @returns {boolean} Returns true if the option was set.
+     * @throws {Error} If the argument is invalid.
+     */
+    setChecksums: (verify: boolean) => boolean
+
+    /**
+     * Enables the reassembly of IP fragments.
+     *
+     * @param {number} timeout - Seconds after which an incomplete datagram is dropped.
+     * @param {number} maxDatagrams - Datagrams reassembled at once, `0` disables the reassembly.
+     * @param {number} maxPerSource - Datagrams reassembled at once per source address.
+     * @param {string} overlap - Overlapping fragments policy.
+     *
+     * @returns {boolean} Returns true if the reassembly was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setReassembly: (timeout: number, maxDatagrams: number, maxPerSource: number, overlap: 'first' | 'last' | 'drop') => boolean
+
+    /**
+     * Enables the reassembly of TCP streams.
+     *
+     * @param {number} maxBuffered - Out-of-order bytes buffered per direction.
+     * @param {number} maxStreams - Connections reassembled at once, `0` disables the reassembly.
+     * @param {number} timeout - Seconds without packets after which a connection ends.
+     * @param {Function} onStream - Called with the in-order data of the connections.
+     *
+     * @returns {boolean} Returns true if the reassembly was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setStreams: (maxBuffered: number, maxStreams: number, timeout: number, onStream: (chunk: StreamChunk) => void) => boolean
+
+    /**
+     * Enables the native DNS decoding.
+     *
+     * @param {Buffer} record - Buffer filled with the DNS message of every packet (see `DnsRecord`).
+     * @param {number} maxNames - Maximum number of interned names.
+     * @param {Function} onNames - Called with the names interned since the previous call.
+     *
+     * @returns {boolean} Returns true if the DNS decoding was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setDns: (record: Buffer, maxNames: number, onNames: (firstId: number, names: string[]) => void) => boolean
+
+    /**
+     * Sets how many encapsulations (GRE, VXLAN, GENEVE, IP in IP) the native parser peels.
+     *
+     * @param {number} depth - Maximum number of nested tunnels, `0` keeps the outer headers.
+     *
+     * @returns {boolean} Returns true if the option was set.
+     * @throws {Error} If the argument is invalid.
+     */
+    setTunnels: (depth: number) => boolean
+
+    /**
+     * Passes the header of each packet to the packet callback, as numbers: `tv_sec`, `tv_usec`,
+     * `caplen` and `len`.
+     *
+     * @param {boolean} enabled - Whether to pass the header fields.
+     *
+     * @returns {boolean} Returns true if the option was set.
+     * @throws {Error} If the argument is invalid.
+     */
+    setHeaderArgs: (enabled: boolean) => boolean
+
+    /**
+     * Sets the memory of the pool holding the retained packets.
+     *
+     * @param {number} maxBytes - Maximum size of the slabs, in bytes.
+     *
+     * @returns {boolean} Returns true if the limit was set.
+     * @throws {Error} If the argument is invalid.
+     */
+    setRetainLimit: (maxBytes: number) => boolean
+
+    /**
+     * Copies the current packet (header and captured bytes) into a slot of the pool.
+     *
+     * @param {number} sequence - Number of the packet to retain (`PacketHeader.sequence`), it must still be the current one.
+     *
+     * @returns {number} Handle of the slot, `-1` if the packet isn't the current one anymore, it is larger than
+     * 128 KiB or the pool reached its limit.
+     * @throws {Error} If the session is closed.
+     */
+    retain: (sequence: number) => number
+
+    /**
+     * Frees a slot taken by `retain`.
+     *
+     * @param {number} handle - Handle returned by `retain`.
+     *
+     * @returns {boolean} Returns true if the slot was freed.
+     * @throws {Error} If the slot was already released (the handles of the previous packets of a slot are rejected).
+     */
+    release: (handle: number) => boolean
+
+    /**
+     * Gets a slab of the pool, the retained packets are read from it in place.
+     *
+     * @param {number} index - Index of the slab, from the handle.
+     */
+    getSlab: (index: number) => ArrayBuffer
+
+    /**
+     * Sets the callback called once the whole file has been read (offline sessions only).
+     *
+     * The flows and the batch still pending are delivered before it.
+     *
+     * @param {() => void} onEnd - Called at the end of the file.
+     *
+     * @returns {boolean} Returns true if the callback was set.
+     * @throws {Error} If the argument is invalid.
+     */
+    setEnd: (onEnd: () => void) => boolean
+
+    /**
+     * Delivers the packets in batches instead of calling the packet callback.
+     *
+     * @param {Buffer} columns - Buffer of at least `size * 38 + 4` bytes holding the columns (see `PacketBatch`).
+     * @param {number} size - Maximum number of packets per batch.
+     * @param {Buffer} data - Buffer receiving the captured bytes.
+     * @param {Function} onBatch - Called with the number of packets of every batch.
+     *
+     * @returns {boolean} Returns true if the batch mode was set.
+     * @throws {Error} If the arguments are invalid.
+     */
+    setBatch: (columns: Buffer, size: number, data: Buffer, onBatch: (count: number) => void) => boolean
+
     /**
      * Close the capture session.
      *
-     * No more `packet` events will be emitted.
+     * The flows still open are reported to the `onFlowEnd` callback first, then no more
+     * packets are delivered.
      */
     close: () => void
 }
@@ -0,0 +1,49 @@
+import type { Buffer } from 'node:buffer'
+import type { DnsRecord } from './dns'
+import type { PacketHeader } from './header'
+import type { PacketMeta } from './meta'
+import type { RetainedPacket } from './retained'
+import type { LinkType, PacketData } from './types'
+
+/**
+ * A packet delivered by a session, its buffers and views are overwritten by the next packet.
+ *
+ * `retain()` is tied to this packet: once the session read the next one, it returns `undefined`
+ * instead of copying the wrong bytes.
+ */
+export class SessionPacket implements PacketData {
+    linkType: LinkType
+    buffer: Buffer
+    header: Buffer
+    headerView: PacketHeader
+    matches?: Uint32Array
+    meta?: PacketMeta
+    dns?: DnsRecord
+
+    /** Number of the packet in the session (`PacketHeader.sequence`) */
+    sequence: number
+
+    #retainer: (sequence: number) => RetainedPacket | undefined
+
+    constructor(
+        session: Pick<SessionPacket, 'linkType' | 'buffer' | 'header' | 'headerView' | 'meta'>,
+        retainer: (sequence: number) => RetainedPacket | undefined,
+        sequence: number,
+        matches?: Uint32Array,
+        dns?: DnsRecord,
+    ) {
+        this.linkType = session.linkType
+        this.buffer = session.buffer
+        this.header = session.header
+        this.headerView = session.headerView
+        this.matches = matches
+        this.meta = session.meta
+        this.dns = dns
+        this.sequence = sequence
+        this.#retainer = retainer
+    }
+
+    retain(): RetainedPacket | undefined {
+        return this.#retainer(this.sequence)
+    }
+}
@@ -0,0 +1,61 @@
+import { Buffer } from 'node:buffer'
+import { PACKET_HEADER_SIZE, PacketHeader } from './header'
+import type { Session } from './npcap'
+import type { LinkType, PacketData } from './types'
+
+// Layout of the handles returned by `Session.retain()`, see lib/pool.h.
+const POOL_MIN_SLOT_SHIFT = 7
+const POOL_SLOT_BITS = 13
+const POOL_CLASS_BITS = 4
+
+/**
+ * A packet copied into a slot of the native pool with `PacketData.retain()`.
+ *
+ * `header` and `buffer` are read in place from the slab, no `Buffer` is allocated for the bytes.
+ * The slot is reused once released: don't keep the buffers after `release()`.
+ */
+export class RetainedPacket implements PacketData {
+    linkType: LinkType
+    header: Buffer
+    headerView: PacketHeader
+    buffer: Buffer
+
+    /** Handle of the slot in the pool */
+    readonly handle: number
+
+    #session?: Pick<Session, 'release'>
+
+    constructor(session: Pick<Session, 'release'>, slab: ArrayBuffer, handle: number, linkType: LinkType) {
+        const sizeClass = (handle >>> POOL_SLOT_BITS) & ((1 << POOL_CLASS_BITS) - 1)
+        const offset = (handle & ((1 << POOL_SLOT_BITS) - 1)) << (POOL_MIN_SLOT_SHIFT + sizeClass)
+
+        this.#session = session
+        this.handle = handle
+        this.linkType = linkType
+        this.header = Buffer.from(slab, offset, PACKET_HEADER_SIZE)
+        this.headerView = new PacketHeader(this.header)
+        this.buffer = Buffer.from(slab, offset + PACKET_HEADER_SIZE, this.headerView.caplen)
+    }
+
+    /**
+     * Index of the slab holding the packet.
+     */
+    static slab(handle: number): number {
+        return handle >>> (POOL_CLASS_BITS + POOL_SLOT_BITS)
+    }
+
+    get released(): boolean {
+        return this.#session === undefined
+    }
+
+    /**
+     * Gives the slot back to the pool, releasing twice does nothing.
+     */
+    release(): void {
+        if (this.#session === undefined)
+            return
+
+        this.#session.release(this.handle)
+        this.#session = undefined
+    }
+}
@@ -1,11 +1,21 @@
 import { Buffer } from 'node:buffer'
+import { PacketBatch } from './batch'
 import { TypedEventEmitter } from './emitter'
+import { DnsRecord } from './dns'
+import { PACKET_HEADER_SIZE, PacketHeader } from './header'
+import { PacketMeta } from './meta'
 import { npcap } from './npcap'
+import { SessionPacket } from './packet'
+import { RetainedPacket } from './retained'
 import type { Session } from './npcap'
-import type { LinkType, LiveSessionOptions, PacketData } from './types'
+import type { FlowCutoffStats, LinkType, LiveSessionOptions, PacketData, PacketHandler, StreamChunk } from './types'
 
 export class NpcapSession extends TypedEventEmitter<{
     packet: [packet: PacketData]
+    flowEnd: [flow: FlowCutoffStats]
+    batch: [batch: PacketBatch]
+    stream: [chunk: StreamChunk]
+    end: []
 }> {
     device: string
 
@@ -14,10 +24,34 @@ export class NpcapSession extends TypedEventEmitter<{
 
     /** Encoded information about the packet (timestamp, size) */
     header: Buffer
+
+    /** Typed view of `header` */
+    headerView: PacketHeader
     linkType: LinkType
 
+    /** Matched pattern indexes as `[count, ...indexes]` */
+    matches?: Uint32Array
+
+    /** Headers of the current packet parsed natively */
+    meta?: PacketMeta
+
+    /** DNS message of the current packet decoded natively */
+    dns?: DnsRecord
+
+    /** Columns of the current batch, only in batch mode */
+    batch?: PacketBatch
+
     session: Session
 
+    // Slabs of the native pool, fetched once when a retained packet first lands in them.
+    #slabs: ArrayBuffer[] = []
+
+    // Packet passed to the `onPacket` handler, allocated once and updated in place.
+    #packet?: SessionPacket
+
+    // `#matchViews[count]` views the `count` matched indexes, created once for each count.
+    #matchViews: Uint32Array[] = []
+
     constructor(live: boolean, device?: string, options: LiveSessionOptions = {}) {
         super()
 
@@ -31,13 +65,37 @@ export class NpcapSession extends TypedEventEmitter<{
             warningHandler = this.warningHandler,
             promiscuous = true,
             minBytes = 16000,
+            sliceLength = 0,
+            patterns = [],
+            onlyMatched = false,
+            flowCutoff,
+            direction = 'both',
+            dedupeLoopback = false,
+            dedupe = false,
+            metadata = false,
+            checksums = false,
+            tunnels = 0,
+            retainLimit,
+            reassembly = false,
+            streams = false,
+            dns = false,
+            batch,
+            onPacket: handler,
         } = options
 
+        // Batches only carry the columns of `PacketBatch`, the matched patterns and DNS records would be lost.
+        if (batch && patterns.length > 0)
+            throw new Error('The `patterns` option can\'t be used with `batch`, the batches don\'t carry the matches.')
+
+        if (batch && dns)
+            throw new Error('The `dns` option can\'t be used with `batch`, the batches don\'t carry the DNS records.')
+
         this.device = device || npcap.defaultDevice() || ''
-        this.buffer = Buffer.alloc(snapLen)
-        this.header = Buffer.alloc(16)
+        this.buffer = Buffer.alloc(typeof sliceLength === 'number' && sliceLength > 0 ? Math.min(sliceLength, snapLen) : snapLen)
+        this.header = Buffer.alloc(PACKET_HEADER_SIZE)
+        this.headerView = new PacketHeader(this.header)
 
-        const onPacket = this.#onPacket.bind(this)
+        const onPacket = handler ? this.#direct(handler) : this.#onPacket.bind(this)
 
         this.session = new npcap.Session()
 
@@ -56,6 +114,88 @@ export class NpcapSession extends TypedEventEmitter<{
             promiscuous,
             minBytes,
         )
+
+        if (sliceLength !== 0)
+            this.session.setSliceLength(sliceLength === 'headers' ? 0 : sliceLength, sliceLength === 'headers')
+
+        if (patterns.length > 0) {
+            const matches = Buffer.alloc(4 * (patterns.length + 1))
+
+            this.session.setPatterns(patterns.map(pattern => Buffer.from(pattern)), matches, onlyMatched)
+            this.matches = new Uint32Array(matches.buffer, matches.byteOffset, patterns.length + 1)
+            this.#matchViews = Array.from({ length: patterns.length + 1 }, (_, count) => this.matches!.subarray(1, 1 + count))
+        }
+
+        if (live && (direction !== 'both' || dedupeLoopback)) {
+            if (!this.session.setDirection(direction, dedupeLoopback))
+                warningHandler(`Capture direction '${direction}' is not supported by the device, it's filtered from the link-layer header.`)
+        }
+
+        if (dedupe) {
+            const { window = 10, size = 4096 } = dedupe === true ? {} : dedupe
+
+            this.session.setDedupe(window, size)
+        }
+
+        if (metadata) {
+            this.meta = new PacketMeta()
+            this.session.setMetadata(this.meta.buffer)
+        }
+
+        if (checksums)
+            this.session.setChecksums(true)
+
+        if (tunnels > 0)
+            this.session.setTunnels(tunnels)
+
+        if (retainLimit !== undefined)
+            this.session.setRetainLimit(retainLimit)
+
+        if (reassembly) {
+            const { timeout = 30, maxDatagrams = 1024, maxPerSource = 64, overlap = 'first' } = reassembly === true ? {} : reassembly
+
+            this.session.setReassembly(timeout, maxDatagrams, maxPerSource, overlap)
+        }
+
+        if (streams) {
+            const { maxBuffered = 262144, maxStreams = 4096, timeout = 60 } = streams === true ? {} : streams
+
+            this.session.setStreams(maxBuffered, maxStreams, timeout, chunk => this.emit('stream', chunk))
+        }
+
+        if (dns) {
+            const { maxNames = 65536 } = dns === true ? {} : dns
+            const record = this.dns = new DnsRecord()
+
+            this.session.setDns(record.buffer, maxNames, (firstId, names) => record.addNames(firstId, names))
+        }
+
+        if (batch) {
+            const { size = 1024, bytes = 4194304 } = batch
+
+            const packets = this.batch = new PacketBatch(size, bytes)
+
+            this.session.setBatch(packets.columns, size, packets.data, (count) => {
+                packets.count = count
+                this.emit('batch', packets)
+            })
+        }
+
+        // Offline sessions stop at the end of the file.
+        if (!live)
+            this.session.setEnd(() => this.emit('end'))
+
+        if (flowCutoff) {
+            const { bytes = 0, packets = 0, timeout = 60, maxFlows = 65536 } = flowCutoff
+
+            this.session.setFlowCutoff(bytes, packets, timeout, maxFlows, flow => this.emit('flowEnd', flow))
+        }
+
+        if (handler) {
+            this.#packet = new SessionPacket(this, this.#retain, 0)
+
+            this.session.setHeaderArgs(true)
+        }
     }
 
     /**
@@ -104,11 +244,12 @@ export class NpcapSession extends TypedEventEmitter<{
     /**
      * Close the capture session.
      *
-     * No more `packet` events will be emitted.
+     * The flows still open are reported with `flowEnd` events first, then no more
+     * events will be emitted.
      */
     close(): void {
-        this.removeAllListeners()
         this.session.close()
+        this.removeAllListeners()
     }
 
     /**
@@ -129,10 +270,41 @@ export class NpcapSession extends TypedEventEmitter<{
     }
 
     #onPacket(): void {
-        this.emit('packet', {
-            buffer: this.buffer,
-            header: this.header,
-            linkType: this.linkType,
-        })
+        this.emit('packet', new SessionPacket(
+            this,
+            this.#retain,
+            this.headerView.sequence,
+            this.matches && this.#matchViews[this.matches[0]],
+            this.dns?.valid ? this.dns : undefined,
+        ))
+    }
+
+    #direct(handler: PacketHandler) {
+        return (tvSec: number, tvUsec: number, caplen: number, len: number) => {
+            const packet = this.#packet!
+
+            packet.sequence = this.headerView.sequence
+
+            if (this.matches)
+                packet.matches = this.#matchViews[this.matches[0]]
+
+            if (this.dns)
+                packet.dns = this.dns.valid ? this.dns : undefined
+
+            handler(packet, tvSec, tvUsec, caplen, len)
+        }
+    }
+
+    // Bound once, the packets share it and pass their own sequence number (checked natively).
+    #retain = (sequence: number): RetainedPacket | undefined => {
+        const handle = this.session.retain(sequence)
+
+        if (handle < 0)
+            return undefined
+
+        const index = RetainedPacket.slab(handle)
+        const slab = this.#slabs[index] ??= this.session.getSlab(index)
+
+        return new RetainedPacket(this.session, slab, handle, this.linkType)
     }
 }
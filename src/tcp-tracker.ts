@@ -1,5 +1,6 @@
 import EventEmitter from 'node:events'
 import type { NpcapDecode } from './decode'
+import type { IPv4Addr } from './decode/protocols'
 
 interface SessionData {
     isn?: number
@@ -14,6 +15,11 @@ interface SessionData {
     bytesPayload: number
 }
 
+// Address and port of an endpoint as one number, the 48 bits are exact in a double.
+function endpoint(addr: IPv4Addr, port: number) {
+    return addr.value * 0x10000 + port
+}
+
 type SessionStates = 'CLOSED' | 'ESTAB' | 'SYN_SENT' | 'SYN_RECV' | 'FIN_WAIT' | 'CLOSE_WAIT' | 'CLOSING' | 'LAST_ASK'
 
 export class TCPSession extends EventEmitter {
@@ -22,6 +28,10 @@ export class TCPSession extends EventEmitter {
     src?: string
     dst?: string
 
+    // `src` and `dst` as numbers, compared to each packet.
+    srcEndpoint?: number
+    dstEndpoint?: number
+
     currentCapTime: number = 0
 
     synTime?: number
@@ -56,14 +66,14 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = packet.payload.payload.payload
-        const src = `${ip.saddr}:${tcp.sport}`
-        const dst = `${ip.daddr}:${tcp.dport}`
 
         this.currentCapTime = packet.npcapHeader.tvSec + (packet.npcapHeader.tvUsec / 1000000)
 
         if (this.state === 'CLOSED') {
-            this.src = src
-            this.dst = dst
+            this.src = `${ip.saddr}:${tcp.sport}`
+            this.dst = `${ip.daddr}:${tcp.dport}`
+            this.srcEndpoint = endpoint(ip.saddr, tcp.sport)
+            this.dstEndpoint = endpoint(ip.daddr, tcp.dport)
 
             if (tcp.flags.syn && !tcp.flags.ack) {
                 // initial SYN??
@@ -99,9 +109,9 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
-        if (src === this.dst && tcp.flags.syn && tcp.flags.ack) {
+        if (src === this.dstEndpoint && tcp.flags.syn && tcp.flags.ack) {
             this.recv.bytesIp += ip.headerLength
             this.recv.bytesTcp += tcp.headerLength
             this.recv.packets[tcp.seqno + 1] = this.currentCapTime
@@ -122,10 +132,10 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
         // TODO: make sure SYN flag isn't set, also match src and dst
-        if (src === this.src && tcp.flags.ack) {
+        if (src === this.srcEndpoint && tcp.flags.ack) {
             this.connectTime = this.currentCapTime
 
             this.send.bytesIp += ip.headerLength
@@ -144,10 +154,10 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
         // Packet came from the active opener / client
-        if (src === this.src) {
+        if (src === this.srcEndpoint) {
             this.send.bytesIp += ip.headerLength
             this.send.bytesTcp += tcp.headerLength
 
@@ -176,7 +186,7 @@ export class TCPSession extends EventEmitter {
                 this.state = 'FIN_WAIT'
         }
         // Packet come from the passive opener / server
-        else if (src === this.dst) {
+        else if (src === this.dstEndpoint) {
             this.recv.bytesIp += ip.headerLength
             this.recv.bytesTcp += tcp.headerLength
 
@@ -216,9 +226,9 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
-        if (src === this.dst && tcp.flags.fin)
+        if (src === this.dstEndpoint && tcp.flags.fin)
             this.state = 'CLOSING'
     }
 
@@ -228,9 +238,9 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
-        if (src === this.src && tcp.flags.fin)
+        if (src === this.srcEndpoint && tcp.flags.fin)
             this.state = 'LAST_ASK'
     }
 
@@ -240,9 +250,9 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
-        if (src === this.dst) {
+        if (src === this.dstEndpoint) {
             this.closeTime = this.currentCapTime
             this.state = 'CLOSED'
 
@@ -256,9 +266,9 @@ export class TCPSession extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = ip.payload
-        const src = `${ip.saddr}:${tcp.sport}`
+        const src = endpoint(ip.saddr, tcp.sport)
 
-        if (src === this.src) {
+        if (src === this.srcEndpoint) {
             this.closeTime = this.currentCapTime
             this.state = 'CLOSED'
 
@@ -270,7 +280,19 @@ export class TCPSession extends EventEmitter {
 }
 
 export class TCPTracker extends EventEmitter {
-    session: Record<string, TCPSession> = {}
+    /**
+     * Sessions by their lowest endpoint, then their highest one (address and port as one number).
+     */
+    sessions = new Map<number, Map<number, TCPSession>>()
+
+    #size = 0
+
+    /**
+     * Number of sessions tracked.
+     */
+    get size() {
+        return this.#size
+    }
 
     trackPacket(packet: NpcapDecode) {
         if (!packet.payload.isIPv4() || !packet.payload.payload.isTcp())
@@ -278,25 +300,39 @@ export class TCPTracker extends EventEmitter {
 
         const ip = packet.payload.payload
         const tcp = packet.payload.payload.payload
-        const src = `${ip.saddr}:${tcp.sport}`
-        const dst = `${ip.daddr}:${tcp.dport}`
+        const src = endpoint(ip.saddr, tcp.sport)
+        const dst = endpoint(ip.daddr, tcp.dport)
 
-        const key = src < dst
-            ? `${src}-${dst}`
-            : `${dst}-${src}`
+        // Both directions share the key.
+        const low = src < dst ? src : dst
+        const high = src < dst ? dst : src
+
+        let peers = this.sessions.get(low)
+        if (!peers) {
+            peers = new Map()
+            this.sessions.set(low, peers)
+        }
 
         let isNew = false
-        let session = this.session[key]
+        let session = peers.get(high)
 
         if (!session) {
+            const created = new TCPSession()
+            const owner = peers
+
             isNew = true
-            session = new TCPSession()
-            this.session[key] = session
+            session = created
+            owner.set(high, created)
+            this.#size++
+
+            created.on('end', () => {
+                owner.delete(high)
+                this.#size--
 
-            session.on('end', () => {
-                delete this.session[key]
+                if (owner.size === 0)
+                    this.sessions.delete(low)
 
-                console.log(`[TCP Tracker] Session removed ${session.src} -> ${session.dst} (Total: ${Object.keys(this.session).length})`)
+                console.log(`[TCP Tracker] Session removed ${created.src} -> ${created.dst} (Total: ${this.#size})`)
             })
         }
 
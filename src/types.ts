@@ -1,4 +1,8 @@
 import type { Buffer } from 'node:buffer'
+import type { DnsRecord } from './dns'
+import type { PacketHeader } from './header'
+import type { PacketMeta } from './meta'
+import type { RetainedPacket } from './retained'
 
 /**
  * Format of the link-type headers.
@@ -10,7 +14,8 @@ export type LinkType =
     | 'LINKTYPE_NULL'
     | 'LINKTYPE_RAW'
     | 'LINKTYPE_LINUX_SLL'
-    // | 'LINKTYPE_IEEE802_11_RADIO'
+    | 'LINKTYPE_LINUX_SLL2'
+    | 'LINKTYPE_IEEE802_11_RADIO'
 
 export interface CaptureStats {
     /**
@@ -28,6 +33,41 @@ export interface CaptureStats {
      * system's buffer when they arrived, because packets weren't being read fast enough.
      */
     ps_drop: number
+
+    /**
+     * Number of duplicated packets suppressed by the `dedupe` option.
+     */
+    duplicates: number
+
+    /**
+     * Number of packets with a wrong IPv4, TCP, UDP or ICMP checksum, see the `checksums` option.
+     */
+    badChecksums: number
+
+    /**
+     * Number of datagrams reassembled from IP fragments, see the `reassembly` option.
+     */
+    reassembled: number
+
+    /**
+     * Number of incomplete datagrams dropped after the reassembly `timeout`.
+     */
+    fragmentTimeouts: number
+
+    /**
+     * Number of incomplete datagrams evicted to make room for new ones.
+     */
+    fragmentEvictions: number
+
+    /**
+     * Number of overlapping fragments received.
+     */
+    fragmentOverlaps: number
+
+    /**
+     * Bytes of the pool slots holding retained packets, see `PacketData.retain()`.
+     */
+    retainedBytes: number
 }
 
 /**
@@ -84,6 +124,47 @@ export interface PacketData {
     linkType: LinkType
     buffer: Buffer
     header: Buffer
+
+    /**
+     * Typed view of `header` (64-bit seconds, nanoseconds, interface index, drops).
+     *
+     * The same instance is reused (and overwritten) for every packet.
+     */
+    headerView?: PacketHeader
+
+    /**
+     * Indexes of the `patterns` found in the packet payload.
+     *
+     * Only available when the session has `patterns`. The views are shared by the packets with
+     * the same number of matches and overwritten by the next packet, copy them to keep them.
+     */
+    matches?: Uint32Array
+
+    /**
+     * Headers of the packet parsed natively (addresses, ports, offsets...).
+     *
+     * Only available when the session has `metadata` enabled. The same instance is
+     * reused (and overwritten) for every packet.
+     */
+    meta?: PacketMeta
+
+    /**
+     * DNS message decoded natively.
+     *
+     * Only available when the session has `dns` enabled and the packet carries a DNS message
+     * (UDP port 53, 5353 or 5355). The same instance is reused for every packet.
+     */
+    dns?: DnsRecord
+
+    /**
+     * Copies the packet (`header` and `buffer`) into the native pool of the session, to keep
+     * it after the handler returns. `release()` it when done.
+     *
+     * Call it as `packet.retain()` before the handler returns (or awaits): once the next packet
+     * was read it returns `undefined`, like when the packet is larger than 128 KiB or the pool
+     * reached the `retainLimit`.
+     */
+    retain?: () => RetainedPacket | undefined
 }
 
 export interface CommonSessionOptions {
@@ -95,6 +176,419 @@ export interface CommonSessionOptions {
      * @see {@link https://npcap.com/guide/wpcap/pcap-filter.html | Npcap Filters Documentation}
      */
     filter?: string
+
+    /**
+     * File path where captured packets will be saved, the packets of a replayed file too.
+     *
+     * Example: '/path/to/save/packets.pcap'
+     */
+    outFile?: string
+
+    /**
+     * Number of bytes of each packet copied into `buffer`.
+     *
+     * Use `'headers'` to copy only up to the end of the transport (TCP/UDP/ICMP) header,
+     * packets that can't be parsed are copied in full.
+     *
+     * `outFile` always receives the full packet (up to `snapLen`).
+     *
+     * @default 0 (The whole packet)
+     */
+    sliceLength?: number | 'headers'
+
+    /**
+     * Byte signatures searched (natively) in the payload of every packet that passes the `filter`.
+     *
+     * The index of each matched pattern is delivered in `PacketData.matches`, once per packet.
+     * The whole captured payload is searched, past `sliceLength` too, but a pattern cut by `snapLen`
+     * isn't found.
+     *
+     * Not available in batch mode (see `batch`).
+     */
+    patterns?: Array<string | Buffer>
+
+    /**
+     * Only deliver the packets whose payload matches at least one of the `patterns`.
+     *
+     * @default false
+     */
+    onlyMatched?: boolean
+
+    /**
+     * Stop delivering (and saving to `outFile`) the packets of a flow after it reached its budget.
+     *
+     * The remaining packets are still counted and reported with the `flowEnd` event, when the flow
+     * ends (FIN, RST or timeout), at the end of the file or when the session is closed.
+     */
+    flowCutoff?: FlowCutoffOptions
+
+    /**
+     * Drop the duplicated packets (like the ingress and egress copies of a SPAN port)
+     * before they are delivered or saved to `outFile`.
+     *
+     * The TTL / hop limit, the IPv4 header checksum and the link-layer header are ignored.
+     *
+     * @default false
+     */
+    dedupe?: boolean | DedupeOptions
+
+    /**
+     * Parse the link, network and transport headers natively and deliver them in `PacketData.meta`,
+     * without decoding the packet in JS.
+     *
+     * @default false
+     */
+    metadata?: boolean
+
+    /**
+     * Verify the IPv4 header, TCP, UDP and ICMP checksums natively.
+     *
+     * Bad checksums are reported in `PacketMeta` (`ipChecksumBad`, `l4ChecksumBad`) and counted in
+     * `CaptureStats.badChecksums`. Outgoing packets and checksums left to the NIC (offload) are not verified.
+     *
+     * @default false
+     */
+    checksums?: boolean
+
+    /**
+     * Number of nested encapsulations (GRE, VXLAN, GENEVE, IP in IP) peeled by the native parser.
+     *
+     * `PacketMeta`, the flow hash, `flowCutoff`, `streams` and the other native features then use the
+     * inner headers, the outermost tunnel is kept in the `PacketMeta.outer*` fields.
+     * VLAN tags (802.1Q / QinQ) and MPLS labels are always skipped.
+     *
+     * @default 0
+     */
+    tunnels?: number
+
+    /**
+     * Memory in bytes of the native pool holding the packets kept with `PacketData.retain()`.
+     *
+     * @default 268435456
+     */
+    retainLimit?: number
+
+    /**
+     * Reassemble the IPv4 / IPv6 fragments natively, the datagram is delivered as a single packet
+     * (with the link-layer and tunnel headers of the first fragment, their lengths updated) once all its
+     * fragments arrived.
+     *
+     * `outFile` still receives the fragments as captured. Under a `flowCutoff`, they are saved once their
+     * datagram is complete and within the budget of its flow.
+     *
+     * @default false
+     */
+    reassembly?: boolean | ReassemblyOptions
+
+    /**
+     * Reassemble the TCP connections natively and deliver their payload, in order,
+     * with the `stream` event (see `StreamChunk`).
+     *
+     * Every direction still open gets a last chunk with `end` set at the end of the file or when
+     * the session is closed.
+     *
+     * @default false
+     */
+    streams?: boolean | StreamOptions
+
+    /**
+     * Decode the DNS messages natively and deliver them in `PacketData.dns` (not available in batch mode).
+     *
+     * The names are interned: each unique name is turned into a JS string once.
+     *
+     * @default false
+     */
+    dns?: boolean | DnsOptions
+
+    /**
+     * Deliver the packets in batches with the `batch` event, as columns (timestamps, addresses,
+     * ports...), instead of one `packet` event per packet.
+     *
+     * A batch is emitted when it is full and every time the pending packets have been read.
+     *
+     * Can't be used with `patterns` nor `dns`.
+     */
+    batch?: BatchOptions
+
+    /**
+     * A single handler called directly for each packet, instead of emitting `packet` events.
+     *
+     * The `packet` object is allocated once and updated in place (don't keep it, use `packet.retain()`),
+     * the header fields are passed as numbers so `header` doesn't need to be read (`tvSec` doesn't wrap in 2038).
+     */
+    onPacket?: PacketHandler
+}
+
+/**
+ * Direct packet handler, see `CommonSessionOptions.onPacket`.
+ *
+ * `caplen` is the number of bytes in `packet.buffer`, `len` the length of the packet on the wire.
+ */
+export type PacketHandler = (packet: PacketData, tvSec: number, tvUsec: number, caplen: number, len: number) => void
+
+/**
+ * Receives each decoded layer, under the `decoderName` of its class: an `EventEmitter` or
+ * a `DecodeSubscriptions` registry.
+ */
+export interface DecodeEmitter {
+    emit: (decoderName: string, layer: any) => boolean
+}
+
+export interface DecodeOptions {
+    /**
+     * Decode each layer the first time its `payload` is read, instead of the whole packet upfront.
+     *
+     * Handlers looking only at the outer layers skip the work of the inner ones. The decoder
+     * events of a layer are emitted when it is decoded.
+     *
+     * The layers are decoded from the packet buffer shared by the session: a `payload` not read
+     * yet is invalid once the handler returns (the buffer holds the next packet).
+     *
+     * @default false
+     */
+    lazy?: boolean
+
+    /**
+     * Deepest layer decoded: `'l3'` stops after the network headers (IP, ARP, IPv6 extension headers),
+     * `'l4'` after the transport headers (TCP, UDP, ICMP, IGMP) and `'app'` also decodes the
+     * application protocols (DNS).
+     *
+     * The `payload` of the last decoded layer is left `undefined`. The DNS messages are decoded
+     * (in `Udp.dns`, with a `dns` event) only when `'app'` is given explicitly, by default
+     * `Udp.toString()` decodes them.
+     *
+     * @default 'app'
+     */
+    maxLayer?: 'l3' | 'l4' | 'app'
+
+    /**
+     * Parts of the protocols left undecoded.
+     */
+    skip?: DecodeSkipOptions
+
+    /**
+     * Throw when a layer can't be decoded. When `false`, the layer is replaced by an `Unknown`
+     * (unknown link type, EtherType or protocol) or a `Truncated` (capture too short) layer, with
+     * an error code and the offset reached, and the decoders never throw on noisy traffic.
+     *
+     * @default true
+     */
+    throwOnError?: boolean
+}
+
+export interface DecodeSkipOptions {
+    /**
+     * Leave `Tcp.options` empty.
+     *
+     * @default false
+     */
+    tcpOptions?: boolean
+
+    /**
+     * Decode only the DNS header (id, flags and counts), the record sets are left empty.
+     *
+     * @default false
+     */
+    dnsBody?: boolean
+}
+
+export interface ReassemblyOptions {
+    /**
+     * Seconds after which an incomplete datagram is dropped.
+     *
+     * @default 30
+     */
+    timeout?: number
+
+    /**
+     * Maximum number of datagrams being reassembled at once, the oldest one is evicted to make room.
+     *
+     * A datagram is evicted as well after 256 fragments (the same fragments resent again and again).
+     *
+     * @default 1024
+     */
+    maxDatagrams?: number
+
+    /**
+     * Maximum number of datagrams being reassembled at once per source address.
+     *
+     * @default 64
+     */
+    maxPerSource?: number
+
+    /**
+     * How the bytes received twice are resolved: keep the `'first'` ones, overwrite them with
+     * the `'last'` ones, or `'drop'` the whole datagram (RFC 5722).
+     *
+     * @default 'first'
+     */
+    overlap?: 'first' | 'last' | 'drop'
+}
+
+export interface DnsOptions {
+    /**
+     * Maximum number of interned names, the table is cleared when full.
+     *
+     * @default 65536
+     */
+    maxNames?: number
+}
+
+export interface BatchOptions {
+    /**
+     * Maximum number of packets per batch.
+     *
+     * @default 1024
+     */
+    size?: number
+
+    /**
+     * Captured bytes buffered per batch, packets longer than it are truncated.
+     *
+     * @default 4194304 (4 MiB)
+     */
+    bytes?: number
+}
+
+export interface DedupeOptions {
+    /**
+     * Time window, in milliseconds, in which a copy of a packet is considered duplicated.
+     *
+     * @default 10
+     */
+    window?: number
+
+    /**
+     * Number of recent packets remembered.
+     *
+     * @default 4096
+     */
+    size?: number
+}
+
+export interface FlowCutoffOptions {
+    /**
+     * Transport payload bytes delivered per flow, `0` for no limit.
+     *
+     * @default 0
+     */
+    bytes?: number
+
+    /**
+     * Packets delivered per flow, `0` for no limit.
+     *
+     * @default 0
+     */
+    packets?: number
+
+    /**
+     * Seconds without packets after which a flow is considered ended.
+     *
+     * A closed connection is also remembered for this long, its last ACK doesn't start a new flow.
+     *
+     * @default 60
+     */
+    timeout?: number
+
+    /**
+     * Maximum number of flows tracked at once, new flows beyond it are not cut.
+     *
+     * @default 65536
+     */
+    maxFlows?: number
+}
+
+/**
+ * Counters of a flow that ended after reaching its cutoff.
+ *
+ * The endpoints are sorted, `A` is the lowest (address, port) pair and not necessarily the client.
+ */
+export interface FlowCutoffStats {
+    addressA: string
+    portA: number
+    addressB: string
+    portB: number
+
+    /**
+     * IP protocol number.
+     */
+    protocol: number
+
+    /**
+     * Packets and payload bytes delivered.
+     */
+    packets: number
+    bytes: number
+
+    /**
+     * Packets and payload bytes seen after the cutoff (not delivered).
+     */
+    cutoffPackets: number
+    cutoffBytes: number
+
+    /**
+     * Capture timestamps (in seconds) of the first and last packets.
+     */
+    firstSeen: number
+    lastSeen: number
+}
+
+export interface StreamChunk {
+    /**
+     * Identifier of the TCP connection, shared by both directions.
+     */
+    id: number
+
+    /**
+     * Endpoints of the direction the data was sent in.
+     */
+    saddr: string
+    sport: number
+    daddr: string
+    dport: number
+
+    /**
+     * Position of `data` in the byte stream of this direction.
+     */
+    offset: number
+
+    /**
+     * Bytes missing (never captured, or given up) right before `data`.
+     */
+    gap: number
+
+    /**
+     * No more data will follow in this direction (FIN, RST, timeout, end of the file or `close()`).
+     */
+    end: boolean
+
+    /**
+     * In-order bytes of the stream.
+     */
+    data: Buffer
+}
+
+export interface StreamOptions {
+    /**
+     * Out-of-order bytes buffered per direction, past it the missing data is reported as a `gap`.
+     *
+     * @default 262144 (256 KiB)
+     */
+    maxBuffered?: number
+
+    /**
+     * Maximum number of connections reassembled at once, new ones beyond it are ignored.
+     *
+     * @default 4096
+     */
+    maxStreams?: number
+
+    /**
+     * Seconds without packets after which a connection is considered ended.
+     *
+     * @default 60
+     */
+    timeout?: number
 }
 
 export interface LiveSessionOptions extends CommonSessionOptions {
@@ -112,13 +606,6 @@ export interface LiveSessionOptions extends CommonSessionOptions {
      */
     snapLen?: number
 
-    /**
-     * File path where captured packets will be saved.
-     *
-     * Example: '/path/to/save/packets.pcap'
-     */
-    outFile?: string
-
     /**
      * Enables monitor mode.
      *
@@ -149,6 +636,26 @@ export interface LiveSessionOptions extends CommonSessionOptions {
      */
     promiscuous?: boolean
 
+    /**
+     * Capture only the packets received (`'in'`), sent (`'out'`) or both.
+     *
+     * Applied in the kernel where supported, otherwise the packets are filtered natively
+     * when the link-layer header records the direction (Linux "cooked" captures). Opening
+     * the session fails when neither is possible (e.g. an Ethernet device without kernel support).
+     *
+     * @default 'both'
+     */
+    direction?: 'in' | 'out' | 'both'
+
+    /**
+     * Drop the outgoing copy of the loopback packets, captured twice on Linux "any" device.
+     *
+     * Opening the session fails on the other link types, their headers don't record the direction.
+     *
+     * @default false
+     */
+    dedupeLoopback?: boolean
+
     /**
      * Set the minimum number of bytes to capture.
      * @NOTE: Only works on Windows.
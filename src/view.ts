@@ -0,0 +1,223 @@
+import { Buffer } from 'node:buffer'
+import { ETHERNET_SIZE, EthernetLayout, IPv4Layout, IPv6Layout, TcpLayout, UDP_SIZE, UdpLayout } from './layouts'
+import { PROTOCOL_IPV4, PROTOCOL_IPV6, PROTOCOL_VLAN } from './types'
+import type { LinkType, PacketData } from './types'
+
+const PROTOCOL_QINQ = 0x88A8
+
+// https://en.wikipedia.org/wiki/Ethernet_frame
+export class EthernetView extends EthernetLayout {
+    /** Length of the header, including the VLAN tags. */
+    headerLength = ETHERNET_SIZE
+
+    /** EtherType of the payload, after the VLAN tags. */
+    get type() { return this.view.getUint16(this.offset + this.headerLength - 2) }
+
+    /** VLAN id of the outer tag, `-1` if the frame isn't tagged. */
+    get vlan() { return this.headerLength > ETHERNET_SIZE ? this.view.getUint16(this.offset + ETHERNET_SIZE) & 0x0FFF : -1 }
+}
+
+// http://en.wikipedia.org/wiki/IPv4
+export class IPv4View extends IPv4Layout {}
+
+// https://en.wikipedia.org/wiki/IPv6_packet
+export class IPv6View extends IPv6Layout {
+    /** Protocol after the extension headers. */
+    protocol = 0
+}
+
+// http://en.wikipedia.org/wiki/Transmission_Control_Protocol
+export class TcpView extends TcpLayout {
+    /** Length of the segment, from the IP header. */
+    segmentLength = 0
+
+    get dataOffset() { return this.offset + this.headerLength }
+    get dataLength() { return Math.max(this.segmentLength - this.headerLength, 0) }
+
+    /** Payload of the segment (allocates a `Buffer` view, not a copy). */
+    get data() { return this.buffer.subarray(this.dataOffset, this.dataOffset + this.dataLength) }
+}
+
+// https://en.wikipedia.org/wiki/User_Datagram_Protocol
+export class UdpView extends UdpLayout {
+    get dataOffset() { return this.offset + UDP_SIZE }
+    get dataLength() { return Math.max(this.length - UDP_SIZE, 0) }
+
+    /** Payload of the datagram (allocates a `Buffer` view, not a copy). */
+    get data() { return this.buffer.subarray(this.dataOffset, this.dataOffset + this.dataLength) }
+}
+
+/**
+ * Flyweight decoder: one preallocated view per layer, re-pointed at every packet.
+ *
+ * Unlike `NpcapDecode`, updating the view allocates nothing, the fields are read from the
+ * captured bytes when they are accessed. The views are only valid until the next packet,
+ * use `clone()` to keep one.
+ *
+ * Supported link types: Ethernet, NULL, RAW and Linux SLL.
+ */
+export class PacketView {
+    linkType: LinkType
+
+    /** Captured bytes, valid up to `caplen`. */
+    buffer: Buffer = Buffer.alloc(0)
+    caplen = 0
+
+    readonly ethernet = new EthernetView()
+    readonly ipv4 = new IPv4View()
+    readonly ipv6 = new IPv6View()
+    readonly tcp = new TcpView()
+    readonly udp = new UdpView()
+
+    constructor(linkType: LinkType) {
+        this.linkType = linkType
+    }
+
+    /**
+     * Re-points the views at a packet delivered by the session.
+     */
+    update(packet: PacketData): this {
+        this.linkType = packet.linkType
+
+        return this.set(packet.buffer, packet.header.readUInt32LE(8))
+    }
+
+    /**
+     * Re-points the views at the first `caplen` bytes of `buffer`.
+     */
+    set(buffer: Buffer, caplen: number = buffer.length): this {
+        this.buffer = buffer
+        this.caplen = Math.min(caplen, buffer.length)
+
+        this.ethernet.valid = false
+        this.ipv4.valid = false
+        this.ipv6.valid = false
+        this.tcp.valid = false
+        this.udp.valid = false
+
+        this.#scan()
+        return this
+    }
+
+    isEthernet() { return this.ethernet.valid }
+    isIPv4() { return this.ipv4.valid }
+    isIPv6() { return this.ipv6.valid }
+    isTcp() { return this.tcp.valid }
+    isUdp() { return this.udp.valid }
+
+    /**
+     * Copies the captured bytes into a new view, which stays valid after the next packet.
+     */
+    clone(): PacketView {
+        const copy = new PacketView(this.linkType)
+
+        return copy.set(Buffer.from(this.buffer.subarray(0, this.caplen)))
+    }
+
+    #scan() {
+        const buffer = this.buffer
+        const caplen = this.caplen
+        let type = 0
+        let offset = 0
+
+        switch (this.linkType) {
+            // https://en.wikipedia.org/wiki/Ethernet_frame
+            case 'LINKTYPE_ETHERNET': {
+                if (caplen < 14)
+                    return
+
+                offset = 12
+                type = buffer.readUInt16BE(offset)
+                offset += 2
+
+                // VLAN-tagged (802.1Q / 802.1ad)
+                while ((type === PROTOCOL_VLAN || type === PROTOCOL_QINQ) && caplen >= offset + 4) {
+                    type = buffer.readUInt16BE(offset + 2)
+                    offset += 4
+                }
+
+                this.ethernet.point(buffer, 0)
+                this.ethernet.headerLength = offset
+                break
+            }
+            // https://www.tcpdump.org/linktypes/LINKTYPE_NULL.html
+            case 'LINKTYPE_NULL': {
+                if (caplen < 4)
+                    return
+
+                const family = buffer[0] === 0 && buffer[1] === 0 ? buffer[3] : buffer[0]
+                type = family === 2 ? PROTOCOL_IPV4 : (family === 24 || family === 28 || family === 30) ? PROTOCOL_IPV6 : 0
+                offset = 4
+                break
+            }
+            case 'LINKTYPE_RAW': {
+                if (caplen < 1)
+                    return
+
+                const version = buffer[0] >> 4
+                type = version === 4 ? PROTOCOL_IPV4 : version === 6 ? PROTOCOL_IPV6 : 0
+                break
+            }
+            // https://www.tcpdump.org/linktypes/LINKTYPE_LINUX_SLL.html
+            case 'LINKTYPE_LINUX_SLL':
+                if (caplen < 16)
+                    return
+
+                type = buffer.readUInt16BE(14)
+                offset = 16
+                break
+            default:
+                return
+        }
+
+        let protocol: number
+        let ipEnd: number
+
+        if (type === PROTOCOL_IPV4) {
+            if (caplen < offset + 20)
+                return
+
+            this.ipv4.point(buffer, offset)
+
+            // Non-first fragments don't carry a transport header.
+            if (this.ipv4.fragmentOffset !== 0)
+                return
+
+            protocol = this.ipv4.protocol
+            ipEnd = offset + this.ipv4.length
+            offset += this.ipv4.headerLength
+        }
+        else if (type === PROTOCOL_IPV6) {
+            if (caplen < offset + 40)
+                return
+
+            this.ipv6.point(buffer, offset)
+            protocol = buffer[offset + 6]
+            ipEnd = offset + 40 + buffer.readUInt16BE(offset + 4)
+            offset += 40
+
+            // Skip the extension headers.
+            while ((protocol === 0 || protocol === 43 || protocol === 60 || protocol === 44 || protocol === 51) && caplen >= offset + 8) {
+                if (protocol === 44 && (buffer.readUInt16BE(offset + 2) & 0xFFF8) !== 0)
+                    return
+
+                const next = buffer[offset]
+                offset += protocol === 44 ? 8 : protocol === 51 ? (buffer[offset + 1] + 2) * 4 : (buffer[offset + 1] + 1) * 8
+                protocol = next
+            }
+
+            this.ipv6.protocol = protocol
+        }
+        else {
+            return
+        }
+
+        if (protocol === 6 && caplen >= offset + 20) {
+            this.tcp.point(buffer, offset)
+            this.tcp.segmentLength = ipEnd - offset
+        }
+        else if (protocol === 17 && caplen >= offset + 8) {
+            this.udp.point(buffer, offset)
+        }
+    }
+}
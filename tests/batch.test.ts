@@ -0,0 +1,34 @@
+import { Buffer } from 'node:buffer'
+import { PacketBatch, batchColumnsSize } from '@/batch'
+import { describe, expect, it } from 'vitest'
+
+describe('packetBatch', () => {
+    it('lays the columns out over a single buffer', () => {
+        const batch = new PacketBatch(4, 64)
+
+        expect(batch.columns).toHaveLength(batchColumnsSize(4))
+        expect(batch.timestamps.byteOffset).toBe(0)
+        expect(batch.flowHash.byteOffset).toBe(32)
+        expect(batch.saddr.byteOffset).toBe(64)
+        expect(batch.daddr.byteOffset).toBe(80)
+        expect(batch.lengths.byteOffset).toBe(96)
+        expect(batch.offsets.byteOffset).toBe(112)
+        expect(batch.offsets).toHaveLength(5)
+        expect(batch.sport.byteOffset).toBe(132)
+        expect(batch.dport.byteOffset).toBe(140)
+        expect(batch.protocol.byteOffset).toBe(148)
+        expect(batch.tcpFlags.byteOffset).toBe(152)
+        expect(batch.tcpFlags.byteOffset + batch.tcpFlags.byteLength).toBe(batch.columns.length)
+    })
+
+    it('slices the packets from the data buffer', () => {
+        const batch = new PacketBatch(2, 8)
+
+        batch.data.set([1, 2, 3, 4, 5])
+        batch.offsets.set([0, 3, 5])
+        batch.count = 2
+
+        expect(batch.packet(0)).toEqual(Buffer.from([1, 2, 3]))
+        expect(batch.packet(1)).toEqual(Buffer.from([4, 5]))
+    })
+})
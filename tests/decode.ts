@@ -0,0 +1,27 @@
+import { Buffer } from 'node:buffer'
+import { PACKET_HEADER_SIZE } from '@/header'
+import type { LinkType } from '@/types'
+
+// Packets handed to the decoders as the session emits them.
+
+/** A TCP ACK from 192.168.0.6:50144 to 99.181.81.5:443, over Ethernet. */
+export const frame = Buffer.from(
+    'e8ada60b3fd4' // dhost
+    + '4c3488b4b2ac' // shost
+    + '0800' // Ethertype (IPv4)
+    + '45000028ebbf4000800699a7c0a8000663b55105c3e001bb717cb4566238f71f5010fee2f6c10000',
+    'hex',
+)
+
+/**
+ * @returns The packet data of `buffer`, its header holds `caplen` and `len` (in host byte order).
+ */
+export function packet(buffer: Buffer, linkType: LinkType = 'LINKTYPE_ETHERNET') {
+    const header = Buffer.alloc(PACKET_HEADER_SIZE)
+    const words = new Uint32Array(header.buffer, header.byteOffset, PACKET_HEADER_SIZE / 4)
+
+    words[2] = buffer.length
+    words[3] = buffer.length
+
+    return { linkType, buffer, header }
+}
@@ -1,4 +1,5 @@
 import { Buffer } from 'node:buffer'
+import EventEmitter from 'node:events'
 import { EthernetAddr, EthernetPacket } from '@/decode/packets'
 import { IPv4 } from '@/decode/protocols'
 import { PROTOCOL_IPV4 } from '@/types'
@@ -70,6 +71,33 @@ describe('ethernetPacket', () => {
         })
 
         // TODO: Test IPv6
+
+        it('should decode the payload when it is read with the lazy option', () => {
+            const emitter = new EventEmitter()
+            const decoded: string[] = []
+
+            emitter.on('ipv4', () => decoded.push('ipv4'))
+            emitter.on('tcp', () => decoded.push('tcp'))
+
+            instance = new EthernetPacket(bufferIPv4WithoutVLAN, 0, emitter, { lazy: true })
+            expect(decoded).toEqual([])
+
+            const ipv4 = instance.payload as IPv4
+            expect(decoded).toEqual(['ipv4'])
+            expect(ipv4.saddr.toString()).toBe('192.168.0.6')
+
+            expect(ipv4.payload.toString()).toContain('50144 -> 443')
+            expect(decoded).toEqual(['ipv4', 'tcp'])
+        })
+
+        it('should throw on an unknown ethertype when the payload is read with the lazy option', () => {
+            const buffer = Buffer.from(bufferIPv4WithoutVLAN)
+            buffer.writeUInt16BE(0x9000, 12)
+
+            instance = new EthernetPacket(buffer, 0, undefined, { lazy: true })
+
+            expect(() => instance.payload).toThrow()
+        })
     })
 
     describe('#toString', () => {
@@ -0,0 +1,65 @@
+import { Buffer } from 'node:buffer'
+import { Ieee80211Packet, LLCPacket } from '@/decode/packets'
+import { describe, expect, it } from 'vitest'
+
+describe('ieee80211Packet', () => {
+    const beacon = new Ieee80211Packet(Buffer.from(
+        '80000000' // beacon, duration
+        + 'ffffffffffff' // receiver
+        + '001122334455' // transmitter
+        + '001122334455' // BSSID
+        + '1000' // sequence = 1
+        + '0000000000000000640011040000', // fixed parameters
+        'hex',
+    ))
+
+    describe('#constructor', () => {
+        it('is a function and returns the instance', () => {
+            expect(Ieee80211Packet).toBeTypeOf('function')
+            expect(beacon).toBe(beacon)
+        })
+
+        it('should decode a management frame', () => {
+            expect(beacon).toHaveProperty('type', 0)
+            expect(beacon).toHaveProperty('subtype', 8)
+            expect(beacon).toHaveProperty('sequence', 1)
+            expect(beacon.addr3?.toString()).toBe('00:11:22:33:44:55')
+            expect(beacon.payload).toBeUndefined()
+        })
+
+        it('should decode the LLC payload of a data frame', () => {
+            const data = new Ieee80211Packet(Buffer.from(
+                '08010000' // data to DS
+                + '001122334455' // BSSID
+                + '66778899aabb' // source
+                + 'ffffffffffff' // destination
+                + '2000'
+                + 'aaaa030000000800' // LLC / SNAP
+                + '46c000200000400001021274c0a82101effffffa94040000' // ipv4
+                + '1600fa04effffffa' // igmpv2
+                + '00000000',
+                'hex',
+            ))
+
+            expect(data).toHaveProperty('type', 2)
+            expect(data).toHaveProperty('flags', 0x01)
+            expect(data.payload).toBeInstanceOf(LLCPacket)
+        })
+
+        it('should not decode protected frames', () => {
+            const data = new Ieee80211Packet(Buffer.from(
+                '0841000000112233445566778899aabbffffffffffff2000'
+                + '0000000000000000',
+                'hex',
+            ))
+
+            expect(data.payload).toBeUndefined()
+        })
+    })
+
+    describe('#toString', () => {
+        it('should return correct string representation', () => {
+            expect(beacon.toString()).toBe('Beacon 00:11:22:33:44:55 -> ff:ff:ff:ff:ff:ff')
+        })
+    })
+})
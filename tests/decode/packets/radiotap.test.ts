@@ -0,0 +1,114 @@
+import { Buffer } from 'node:buffer'
+import { Ieee80211Packet, RadiotapPacket } from '@/decode/packets'
+import { describe, expect, it } from 'vitest'
+import { ipv4, replay, udp } from '../../pcap'
+
+describe('radiotapPacket', () => {
+    const buffer = Buffer.from(
+        '00001800' // revision, pad, length = 24
+        + '2f080000' // present: TSFT, flags, rate, channel, dBm signal, antenna
+        + '0102030405060708' // TSFT
+        + '10' // flags: FCS at end
+        + '0c' // rate = 6 Mb/s
+        + '6c09a000' // channel: 2412 MHz, 2 GHz / OFDM
+        + 'c4' // signal = -60 dBm
+        + '01' // antenna
+        + '8802000001010101010102020202020203030303030330010000' // QoS data from DS
+        + 'aaaa030000000800' // LLC / SNAP
+        + '4500001c000000004011f9b40a0000010a000002' // ipv4
+        + '04d2162e00080000' // udp
+        + 'deadbeef', // FCS
+        'hex',
+    )
+    const instance = new RadiotapPacket(buffer)
+
+    describe('#constructor', () => {
+        it('is a function and returns the instance', () => {
+            expect(RadiotapPacket).toBeTypeOf('function')
+            expect(instance).toBe(instance)
+        })
+
+        it('should decode the radiotap fields', () => {
+            expect(instance).toHaveProperty('headerRevision', 0)
+            expect(instance).toHaveProperty('headerLength', 24)
+            expect(instance).toHaveProperty('presentFlags', 0x82F)
+            expect(instance).toHaveProperty('flags', 0x10)
+            expect(instance).toHaveProperty('rate', 12)
+            expect(instance).toHaveProperty('frequency', 2412)
+            expect(instance).toHaveProperty('channelFlags', 0xA0)
+            expect(instance).toHaveProperty('signal', -60)
+            expect(instance).toHaveProperty('antenna', 1)
+            expect(instance.noise).toBeUndefined()
+            expect(instance.payload).toBeInstanceOf(Ieee80211Packet)
+        })
+
+        it('should skip the extended bitmaps', () => {
+            const extended = new RadiotapPacket(Buffer.from(
+                '00000d00' // revision, pad, length = 13
+                + '20000080' // present: dBm signal, extended bitmap
+                + '00000000' // second bitmap
+                + 'b0' // signal = -80 dBm
+                + 'd4000000090909090909', // ACK
+                'hex',
+            ))
+
+            expect(extended).toHaveProperty('signal', -80)
+            expect(extended.payload.toString()).toBe('ACK -> 09:09:09:09:09:09')
+        })
+
+        it('should throw on an unknown revision', () => {
+            expect(() => new RadiotapPacket(Buffer.from('01000800000000000000000000000000', 'hex'))).toThrow()
+        })
+    })
+
+    describe('#toString', () => {
+        it('should return correct string representation', () => {
+            expect(instance.toString()).toBe('2412 MHz 6 Mb/s -60dBm signal QoS Data 02:02:02:02:02:02 -> 01:01:01:01:01:01 dsap: 170 ssap: 170 IPv4 10.0.0.1 -> 10.0.0.2 Udp UDP 1234 -> 5678 len 8')
+        })
+    })
+})
+
+describe('radiotap capture', () => {
+    // The channel is aligned on 2 bytes after the 1-byte flags field, a pad byte comes first.
+    const frame = Buffer.concat([
+        Buffer.from(
+            '00001000' // revision, pad, length = 16
+            + '2a080000' // present: flags, channel, dBm signal, antenna
+            + '00' // flags
+            + '00' // pad
+            + '8509c000' // channel: 2437 MHz, 2 GHz / CCK
+            + 'c9' // signal = -55 dBm
+            + '02' // antenna
+            + '080200000101010101010202020202020303030303034000' // data from DS, sequence 4
+            + 'aaaa030000000800', // LLC / SNAP
+            'hex',
+        ),
+        ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 17 }, udp({ sport: 1234, dport: 5678 }, Buffer.from('hi'))),
+    ])
+
+    it('is read natively and decoded from an offline session', async () => {
+        const records: Record<string, unknown>[] = []
+        const decoded: RadiotapPacket[] = []
+
+        // LINKTYPE_IEEE802_11_RADIOTAP
+        const session = await replay([frame], { metadata: true }, (session) => {
+            session.on('packet', ({ buffer, headerView, meta }) => {
+                records.push({
+                    frequency: meta!.frequency,
+                    signal: meta!.signal,
+                    antenna: meta!.antenna,
+                    sequence: meta!.sequence,
+                    l3Offset: meta!.l3Offset,
+                    saddr: meta!.saddr,
+                    dport: meta!.dport,
+                })
+                decoded.push(new RadiotapPacket(Buffer.from(buffer.subarray(0, headerView!.caplen))))
+            })
+        }, 127)
+
+        session.close()
+
+        expect(records).toEqual([{ frequency: 2437, signal: -55, antenna: 2, sequence: 4, l3Offset: 48, saddr: '10.0.0.1', dport: 5678 }])
+        expect(decoded[0]).toMatchObject({ frequency: 2437, channelFlags: 0xC0, signal: -55, antenna: 2 })
+    })
+})
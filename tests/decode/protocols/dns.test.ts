@@ -34,6 +34,14 @@ describe('dNS', () => {
             expect(instance).toHaveProperty('header.z', 0)
             expect(instance).toHaveProperty('header.responseCode', 0)
         })
+
+        it('should decode only the header when skipping the body', () => {
+            const header = new DNS(buffer, 0, undefined, { skip: { dnsBody: true } })
+
+            expect(header).toHaveProperty('qdcount', 1)
+            expect(header.question.rrs).toEqual([])
+            expect(header.toString()).not.toContain('question')
+        })
     })
 
     describe('#toString', () => {
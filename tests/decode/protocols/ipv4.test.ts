@@ -51,6 +51,18 @@ describe('iPv4Addr', () => {
 
         it('should decode address correctly', () => {
             expect(instance).toHaveProperty('addr', [192, 168, 1, 1])
+            expect(instance.value).toBe(0xC0A80101)
+        })
+    })
+
+    describe('#equals() / #hash()', () => {
+        it('should compare the numeric addresses', () => {
+            const same = new IPv4Addr(Buffer.from([0, 192, 168, 1, 1]), 1)
+            const other = new IPv4Addr(Buffer.from([192, 168, 1, 2]))
+
+            expect(new IPv4Addr(buffer).equals(same)).toBe(true)
+            expect(new IPv4Addr(buffer).equals(other)).toBe(false)
+            expect(same.hash()).toBe(0xC0A80101)
         })
     })
 
@@ -115,6 +127,14 @@ describe('iPv4', () => {
             expect(instance).toHaveProperty('saddr.addr', [192, 168, 33, 1])
             expect(instance).toHaveProperty('daddr.addr', [239, 255, 255, 250])
         })
+
+        it('should stop at the network layer with maxLayer l3', () => {
+            const l3 = new IPv4(buffer, 0, undefined, { maxLayer: 'l3' })
+
+            expect(l3).toHaveProperty('protocol', 2)
+            expect(l3.payload).toBeUndefined()
+            expect(l3.toString()).toBe('192.168.33.1 -> 239.255.255.250 flags [d]')
+        })
     })
 
     describe('#toString', () => {
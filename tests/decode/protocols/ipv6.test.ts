@@ -13,6 +13,19 @@ describe('iPv6Addr', () => {
 
         it('should decode address correctly', () => {
             expect(instance).toHaveProperty('addr', [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15])
+            expect([instance.w0, instance.w1, instance.w2, instance.w3]).toEqual([0x00010203, 0x04050607, 0x08090A0B, 0x0C0D0E0F])
+        })
+    })
+
+    describe('#equals() / #hash()', () => {
+        it('should compare the address words', () => {
+            const same = new IPv6Addr(Buffer.from(buffer))
+            const other = new IPv6Addr(Buffer.from('000102030405060708090A0B0C0D0E10', 'hex'))
+
+            expect(instance.equals(same)).toBe(true)
+            expect(instance.hash()).toBe(same.hash())
+            expect(instance.equals(other)).toBe(false)
+            expect(instance.hash()).not.toBe(other.hash())
         })
     })
 
@@ -24,6 +37,17 @@ describe('iPv6Addr', () => {
         it('should return correct string representation', () => {
             expect(instance.toString()).toBe('0001:0203:0405:0607:0809:0a0b:0c0d:0e0f')
         })
+
+        it('should format the address set after a cached one', () => {
+            const addr = new IPv6Addr(Buffer.from(buffer))
+
+            // Read from the cache filled by the shared instance.
+            expect(addr.toString()).toBe('0001:0203:0405:0607:0809:0a0b:0c0d:0e0f')
+
+            addr.addr = [0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1]
+            expect(addr.toString()).toBe('fe80:0000:0000:0000:0000:0000:0000:0001')
+            expect(instance.toString()).toBe('0001:0203:0405:0607:0809:0a0b:0c0d:0e0f')
+        })
     })
 })
 
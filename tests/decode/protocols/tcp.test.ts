@@ -1,5 +1,6 @@
 import { Buffer } from 'node:buffer'
 import { Tcp } from '@/decode/protocols'
+import { TCPOptions } from '@/decode/protocols/tcp'
 import { describe, expect, it } from 'vitest'
 
 describe('tcp', () => {
@@ -60,6 +61,15 @@ describe('tcp', () => {
             expect(instance).toHaveProperty('dataLength', 0)
             expect(instance).toHaveProperty('data', null)
         })
+
+        it('should skip the options', () => {
+            const skipped = new Tcp(buffer, 0, 24, undefined, { skip: { tcpOptions: true } })
+
+            expect(skipped.options).toEqual(new TCPOptions())
+            expect(skipped).toHaveProperty('windowSize', 4128)
+            expect(skipped).toHaveProperty('dataLength', 0)
+            expect(skipped).toHaveProperty('data', null)
+        })
     })
 
     describe('#toString', () => {
@@ -0,0 +1,79 @@
+import { Buffer } from 'node:buffer'
+import { DecodeSubscriptions } from '@/decode'
+import { EthernetPacket } from '@/decode/packets'
+import { DNS, IPv4, Tcp } from '@/decode/protocols'
+import { describe, expect, it } from 'vitest'
+import { frame, packet } from '../decode'
+
+describe('decodeSubscriptions', () => {
+    it('calls the handlers of the subscribed layers', () => {
+        const ports: number[] = []
+        const layers: string[] = []
+        const subscriptions = new DecodeSubscriptions()
+            .on(Tcp, tcp => ports.push(tcp.sport, tcp.dport))
+            .on(Tcp, () => layers.push('tcp'))
+            .on('ipv4', () => layers.push('ipv4'))
+
+        subscriptions.decode(packet(frame))
+
+        expect(ports).toEqual([50144, 443])
+        // Each layer is emitted once its payload is decoded.
+        expect(layers).toEqual(['tcp', 'ipv4'])
+        expect(subscriptions.emit(EthernetPacket.decoderName, undefined)).toBe(false)
+    })
+
+    it('stops at the deepest subscribed layer', () => {
+        const subscriptions = new DecodeSubscriptions().on(EthernetPacket, () => {})
+
+        expect(subscriptions.maxLayer).toBe('l3')
+        expect((subscriptions.decode(packet(frame)).payload as EthernetPacket).payload).toBeInstanceOf(IPv4)
+        expect(((subscriptions.decode(packet(frame)).payload as EthernetPacket).payload as IPv4).payload).toBeUndefined()
+
+        subscriptions.on(Tcp, () => {})
+
+        expect(subscriptions.maxLayer).toBe('l4')
+        expect(((subscriptions.decode(packet(frame)).payload as EthernetPacket).payload as IPv4).payload).toBeInstanceOf(Tcp)
+    })
+
+    it('removes handlers', () => {
+        let calls = 0
+        const handler = () => calls++
+        const subscriptions = new DecodeSubscriptions().on(Tcp, handler)
+
+        subscriptions.decode(packet(frame))
+        subscriptions.off(Tcp, handler)
+        subscriptions.decode(packet(frame))
+
+        expect(calls).toBe(1)
+        expect(subscriptions.maxLayer).toBe('l3')
+    })
+
+    it('decodes the DNS layer when subscribed', () => {
+        const dns = Buffer.from('311f01000001000000000000037777770000010001', 'hex')
+        const buffer = Buffer.concat([frame.subarray(0, 42), dns])
+        const names: string[] = []
+
+        buffer.writeUInt16BE(20 + 8 + dns.length, 14 + 2)
+        buffer[14 + 9] = 17
+        buffer.writeUInt16BE(53, 36)
+        buffer.writeUInt16BE(8 + dns.length, 38)
+
+        const subscriptions = new DecodeSubscriptions().on(DNS, message => names.push(message.question.rrs[0].name))
+
+        subscriptions.decode(packet(buffer))
+
+        expect(subscriptions.maxLayer).toBe('app')
+        expect(names).toEqual(['www'])
+    })
+
+    it('follows the options changed in place', () => {
+        const options = { maxLayer: 'l3' as 'l3' | 'l4' }
+        const subscriptions = new DecodeSubscriptions()
+
+        expect(((subscriptions.decode(packet(frame), options).payload as EthernetPacket).payload as IPv4).payload).toBeUndefined()
+
+        options.maxLayer = 'l4'
+
+        expect(((subscriptions.decode(packet(frame), options).payload as EthernetPacket).payload as IPv4).payload).toBeInstanceOf(Tcp)
+    })
+})
@@ -0,0 +1,139 @@
+import { Buffer } from 'node:buffer'
+import EventEmitter from 'node:events'
+import { decode, DECODE_TRUNCATED, DECODE_UNKNOWN_ETHERTYPE, DECODE_UNKNOWN_LINK_TYPE, DECODE_UNKNOWN_PROTOCOL, DECODE_UNSUPPORTED, Truncated, Unknown } from '@/decode'
+import { EthernetPacket } from '@/decode/packets'
+import { DNS, IPv4, Tcp } from '@/decode/protocols'
+import { TCPOptions } from '@/decode/protocols/tcp'
+import type { LinkType } from '@/types'
+import { describe, expect, it } from 'vitest'
+import { frame, packet } from '../decode'
+
+describe('throwOnError', () => {
+    it('returns an Unknown layer for an unknown ethertype', () => {
+        const buffer = Buffer.from(frame)
+        buffer.writeUInt16BE(0x9000, 12)
+
+        const instance = new EthernetPacket(buffer, 0, undefined, { throwOnError: false })
+
+        expect(instance.isUnknown()).toBe(true)
+        expect(instance.payload).toBeInstanceOf(Unknown)
+        expect(instance.payload).toMatchObject({ code: DECODE_UNKNOWN_ETHERTYPE, type: 0x9000, offset: 14 })
+        expect((instance.payload as Unknown).data).toHaveLength(40)
+    })
+
+    it('returns an Unknown layer for an 802.3 frame', () => {
+        const buffer = Buffer.from(frame)
+        buffer.writeUInt16BE(40, 12)
+
+        const instance = new EthernetPacket(buffer, 0, undefined, { throwOnError: false })
+
+        expect(instance.payload).toMatchObject({ code: DECODE_UNSUPPORTED, type: 40 })
+        expect(instance.toString()).toContain('unknown 802.3 type without an ethertype 40.')
+    })
+
+    it('returns an Unknown layer for an unknown IP protocol', () => {
+        const buffer = Buffer.from(frame)
+        buffer[14 + 9] = 255
+
+        const ipv4 = new EthernetPacket(buffer, 0, undefined, { throwOnError: false }).payload as IPv4
+
+        expect(ipv4.isUnknown()).toBe(true)
+        expect(ipv4.payload).toMatchObject({ code: DECODE_UNKNOWN_PROTOCOL, type: 255, offset: 34 })
+    })
+
+    it('returns a Truncated layer where the capture ends', () => {
+        const instance = new EthernetPacket(frame.subarray(0, 44), 0, undefined, { throwOnError: false })
+        const ipv4 = instance.payload as IPv4
+
+        expect(ipv4.isTruncated()).toBe(true)
+        expect(ipv4.payload).toBeInstanceOf(Truncated)
+        expect(ipv4.payload).toMatchObject({ code: DECODE_TRUNCATED, offset: 34, needed: 20 })
+        expect((ipv4.payload as Truncated).data).toHaveLength(10)
+    })
+
+    it('truncates a VLAN tag cut by the capture', () => {
+        const buffer = Buffer.from(frame.subarray(0, 16))
+        buffer.writeUInt16BE(0x8100, 12)
+
+        const instance = new EthernetPacket(buffer, 0, undefined, { throwOnError: false })
+
+        expect(instance.isTruncated()).toBe(true)
+        expect(instance.payload).toMatchObject({ offset: 14, needed: 4 })
+    })
+
+    it('skips the TCP options cut by the capture', () => {
+        const buffer = Buffer.from(frame)
+        buffer[14 + 20 + 12] = 0x80 // 32 bytes header, 12 bytes of options
+
+        const ipv4 = new EthernetPacket(buffer, 0, undefined, { throwOnError: false }).payload as IPv4
+
+        expect(ipv4.isTcp()).toBe(true)
+        expect((ipv4.payload as Tcp).headerLength).toBe(32)
+    })
+
+    it('skips the TCP options it doesn\'t know', () => {
+        // MD5 signature (18 bytes), MPTCP capable (12 bytes), MSS, end of options.
+        const options = Buffer.from(`1312${'00'.repeat(16)}1e0c${'00'.repeat(10)}020405b400000000`, 'hex')
+
+        expect(new TCPOptions().decode(options, 0, options.length, false)).toMatchObject({ mss: 1460 })
+        expect(() => new TCPOptions().decode(options, 0, options.length)).toThrow('Don\'t know how to process TCP option 19')
+    })
+
+    it('stops a DNS name cut by the capture', () => {
+        const dns = Buffer.from('311f01000001000000000000037777770000010001', 'hex')
+        const udp = Buffer.alloc(8)
+        udp.writeUInt16BE(53, 2)
+        udp.writeUInt16BE(8 + dns.length, 4)
+
+        const buffer = Buffer.from(frame.subarray(0, 34))
+        buffer.writeUInt16BE(20 + 8 + dns.length, 14 + 2)
+        buffer[14 + 9] = 17
+
+        // The DNS header is captured, not the question.
+        const truncated = Buffer.concat([buffer, udp, dns]).subarray(0, 54)
+        const ipv4 = new EthernetPacket(truncated, 0, undefined, { throwOnError: false }).payload as IPv4
+
+        expect(ipv4.isUdp()).toBe(true)
+        expect(ipv4.toString()).toContain('DNS')
+        expect(() => new EthernetPacket(truncated).toString()).toThrow('invalid DNS RR: read beyond end of packet at offset 12')
+    })
+
+    it('keeps the DNS records decoded before a malformed one', () => {
+        // A question, then an answer cut after its name.
+        const message = Buffer.from('311f81800001000100000000076578616d706c6503636f6d0000010001c00c0001', 'hex')
+        const dns = new DNS(message, 0, undefined, { throwOnError: false })
+
+        expect(dns.question.rrs).toHaveLength(1)
+        expect(dns.question.rrs[0]).toMatchObject({ name: 'example.com', type: 1 })
+        expect(dns.answer.rrs).toEqual([])
+        expect(() => new DNS(message)).toThrow('Malformed DNS RR. Fields are beyond packet len')
+    })
+
+    it('returns an Unknown layer for an unknown link type', () => {
+        const instance = decode(packet(frame, 'LINKTYPE_PPP' as LinkType), undefined, { throwOnError: false })
+
+        expect(instance.isUnknown()).toBe(true)
+        expect(instance.payload).toMatchObject({ code: DECODE_UNKNOWN_LINK_TYPE, offset: 0 })
+    })
+
+    it('emits the unknown and truncated decoder events', () => {
+        const emitter = new EventEmitter()
+        const decoded: string[] = []
+
+        emitter.on(Unknown.decoderName, () => decoded.push('unknown'))
+        emitter.on(Truncated.decoderName, () => decoded.push('truncated'))
+
+        decode(packet(frame.subarray(0, 10)), emitter, { throwOnError: false })
+        decode(packet(frame, 'LINKTYPE_PPP' as LinkType), emitter, { throwOnError: false })
+
+        expect(decoded).toEqual(['truncated', 'unknown'])
+    })
+
+    it('still throws by default', () => {
+        const buffer = Buffer.from(frame)
+        buffer.writeUInt16BE(0x9000, 12)
+
+        expect(() => new EthernetPacket(buffer)).toThrow('Dont know how to decode ethertype 36864.')
+        expect(() => decode(packet(frame, 'LINKTYPE_PPP' as LinkType))).toThrow()
+    })
+})
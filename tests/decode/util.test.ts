@@ -1,4 +1,4 @@
-import { int8_to_dec, int8_to_hex, int8_to_hex_nopad } from '@/decode/utils'
+import { int8_to_dec, int8_to_hex, int8_to_hex_nopad, LruCache } from '@/decode/utils'
 import { describe, expect, it } from 'vitest'
 
 describe('util', () => {
@@ -37,4 +37,19 @@ describe('util', () => {
             expect(int8_to_hex_nopad[255]).toBe('ff')
         })
     })
+
+    describe('lruCache', () => {
+        it('evicts the least recently used entry', () => {
+            const cache = new LruCache<number, string>(2)
+
+            cache.set(1, 'a')
+            cache.set(2, 'b')
+            expect(cache.get(1)).toBe('a')
+
+            cache.set(3, 'c')
+            expect(cache.get(2)).toBeUndefined()
+            expect(cache.get(1)).toBe('a')
+            expect(cache.get(3)).toBe('c')
+        })
+    })
 })
@@ -0,0 +1,56 @@
+import { Buffer } from 'node:buffer'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, udp } from './pcap'
+import type { DedupeOptions } from '@/types'
+import type { Frame } from './pcap'
+
+function datagram(payload: string, ttl = 64) {
+    return ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 17, ttl }, udp({ sport: 5000, dport: 6000 }, Buffer.from(payload)))
+}
+
+// Each packet delivered by the session, with the number of duplicates suppressed.
+async function dedupe(frames: (Buffer | Frame)[], options: DedupeOptions | true = true) {
+    const packets: Buffer[] = []
+
+    const session = await replay(frames, { dedupe: options }, (session) => {
+        session.on('packet', packet => packets.push(Buffer.from(packet.buffer.subarray(0, packet.headerView!.caplen))))
+    })
+
+    const { duplicates } = session.stats()
+
+    session.close()
+    return { packets, duplicates }
+}
+
+describe('dedupe', () => {
+    it('drops the copies forwarded by a router', async () => {
+        // The TTL and the header checksum differ.
+        const { packets, duplicates } = await dedupe([ethernet(datagram('mirrored')), ethernet(datagram('mirrored', 63))])
+
+        expect(packets).toEqual([ethernet(datagram('mirrored'))])
+        expect(duplicates).toBe(1)
+    })
+
+    it('keeps the copies out of the window', async () => {
+        const frames = [{ data: ethernet(datagram('resent')), time: 1700000000 }, { data: ethernet(datagram('resent')), time: 1700000000.05 }]
+        const { packets, duplicates } = await dedupe(frames, { window: 10 })
+
+        expect(packets).toHaveLength(2)
+        expect(duplicates).toBe(0)
+    })
+
+    it('keeps the packets with another payload', async () => {
+        const { packets, duplicates } = await dedupe([ethernet(datagram('first')), ethernet(datagram('other'))])
+
+        expect(packets).toEqual([ethernet(datagram('first')), ethernet(datagram('other'))])
+        expect(duplicates).toBe(0)
+    })
+
+    it('ignores the link-layer header', async () => {
+        // Tagged on the trunk port, untagged on the access port.
+        const { packets, duplicates } = await dedupe([ethernet(datagram('tagged'), 0x0800, [100]), ethernet(datagram('tagged'))])
+
+        expect(packets).toEqual([ethernet(datagram('tagged'), 0x0800, [100])])
+        expect(duplicates).toBe(1)
+    })
+})
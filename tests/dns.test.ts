@@ -0,0 +1,170 @@
+import { Buffer } from 'node:buffer'
+import { endianness } from 'node:os'
+import { DNS_NO_NAME, DNS_RECORD_SIZE, DnsRecord } from '@/dns'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, udp } from './pcap'
+import type { DnsOptions } from '@/types'
+
+// https://datatracker.ietf.org/doc/html/rfc1035#section-4.1
+function labels(name: string) {
+    return Buffer.concat([...name.split('.').map(label => Buffer.concat([Buffer.from([label.length]), Buffer.from(label)])), Buffer.from([0])])
+}
+
+function u16(...values: number[]) {
+    const buffer = Buffer.alloc(values.length * 2)
+
+    values.forEach((value, i) => buffer.writeUInt16BE(value, i * 2))
+    return buffer
+}
+
+// Header of a response with `questions` and `answers` records, followed by `body`.
+function response(questions: number, answers: number, ...body: Buffer[]) {
+    return ethernet(ipv4({ saddr: '10.0.0.53', daddr: '10.0.0.1', protocol: 17 }, udp({ sport: 53, dport: 50000 }, Buffer.concat([u16(0x1234, 0x8180, questions, answers, 0, 0), ...body]))))
+}
+
+// Fields of each message parsed natively, the record is reused by the next packet.
+async function parse(frames: Buffer[], options: DnsOptions = {}) {
+    const messages: Record<string, unknown>[] = []
+
+    const session = await replay(frames, { dns: options }, (session) => {
+        session.on('packet', ({ dns }) => messages.push({
+            malformed: dns!.malformed,
+            questionName: dns!.questionName,
+            answers: Array.from({ length: dns!.answerCount }, (_, i) => [dns!.answerName(i), dns!.answerTarget(i) ?? dns!.answerAddress(i)]),
+        }))
+    })
+
+    session.close()
+    return messages
+}
+
+function record() {
+    const buffer = Buffer.alloc(DNS_RECORD_SIZE)
+    const le = endianness() === 'LE'
+    const write16 = (value: number, offset: number) => le ? buffer.writeUInt16LE(value, offset) : buffer.writeUInt16BE(value, offset)
+    const write32 = (value: number, offset: number) => le ? buffer.writeUInt32LE(value, offset) : buffer.writeUInt32BE(value, offset)
+
+    write16(0x1234, 0)
+    write16(0x8180, 2)
+    write16(1, 4)
+    write16(1, 6)
+    write32(0, 8)
+    write16(2, 12)
+    buffer[14] = 1
+
+    // www.example.com CNAME example.com
+    write32(0, 16)
+    write16(5, 20)
+    write16(1, 22)
+    write32(300, 24)
+    write32(1, 28)
+
+    // example.com A 93.184.216.34
+    write32(1, 48)
+    write16(1, 52)
+    write16(1, 54)
+    write32(60, 56)
+    write32(DNS_NO_NAME, 60)
+    buffer.set([93, 184, 216, 34], 64)
+
+    return buffer
+}
+
+describe('dnsRecord', () => {
+    it('reads the header and the question', () => {
+        const dns = new DnsRecord(record())
+        dns.addNames(0, ['www.example.com', 'example.com'])
+
+        expect(dns.valid).toBe(true)
+        expect(dns.malformed).toBe(false)
+        expect(dns.id).toBe(0x1234)
+        expect(dns.isResponse).toBe(true)
+        expect(dns.responseCode).toBe(0)
+        expect(dns.questionName).toBe('www.example.com')
+        expect(dns.questionType).toBe(1)
+        expect(dns.questionClass).toBe(1)
+    })
+
+    it('reads the answers', () => {
+        const dns = new DnsRecord(record())
+        dns.addNames(0, ['www.example.com', 'example.com'])
+
+        expect(dns.answerCount).toBe(2)
+        expect(dns.answerName(0)).toBe('www.example.com')
+        expect(dns.answerType(0)).toBe(5)
+        expect(dns.answerTtl(0)).toBe(300)
+        expect(dns.answerTarget(0)).toBe('example.com')
+        expect(dns.answerName(1)).toBe('example.com')
+        expect(dns.answerTarget(1)).toBeUndefined()
+        expect(dns.answerAddress(1)).toBe('93.184.216.34')
+        expect(dns.answerAddress4(1)).toBe(0x5DB8D822)
+    })
+
+    it('restarts the names when the native table is cleared', () => {
+        const dns = new DnsRecord()
+
+        dns.addNames(0, ['a', 'b'])
+        dns.addNames(2, ['c'])
+        expect(dns.names).toEqual(['a', 'b', 'c'])
+
+        dns.addNames(0, ['d'])
+        expect(dns.names).toEqual(['d'])
+    })
+})
+
+describe('native DNS parser', () => {
+    it('follows the compression pointers', async () => {
+        const [message] = await parse([response(
+            1,
+            2,
+            labels('www.example.com'),
+            u16(1, 1),
+            // At 33: www.example.com CNAME cdn + example.com (at 16).
+            u16(0xC00C, 5, 1, 0, 300, 6),
+            Buffer.from([3, ...Buffer.from('cdn'), 0xC0, 16]),
+            // At 51: cdn.example.com (at 45) A 1.2.3.4.
+            u16(0xC02D, 1, 1, 0, 60, 4),
+            Buffer.from([1, 2, 3, 4]),
+        )])
+
+        expect(message).toEqual({
+            malformed: false,
+            questionName: 'www.example.com',
+            answers: [['www.example.com', 'cdn.example.com'], ['cdn.example.com', '1.2.3.4']],
+        })
+    })
+
+    it('rejects the pointers that could loop', async () => {
+        const messages = await parse([
+            // The question name points to itself.
+            response(1, 0, u16(0xC00C, 1, 1)),
+            // The answer name (at 29) points forward to its target (at 41), which points back to it.
+            response(1, 1, labels('example.com'), u16(1, 1), u16(0xC029, 5, 1, 0, 300, 2, 0xC01D)),
+        ])
+
+        expect(messages[0]).toMatchObject({ malformed: true, questionName: undefined })
+        expect(messages[1]).toMatchObject({ malformed: true, questionName: 'example.com', answers: [] })
+    })
+
+    it('caps the names at 255 bytes', async () => {
+        const label = 'a'.repeat(63)
+        const longest = [label, label, label, label].join('.')
+
+        const [accepted, rejected] = await parse([
+            response(1, 0, labels(longest), u16(1, 1)),
+            response(1, 0, labels(`${longest}.b`), u16(1, 1)),
+        ])
+
+        expect(accepted).toMatchObject({ malformed: false, questionName: longest })
+        expect(rejected).toMatchObject({ malformed: true, questionName: undefined })
+    })
+
+    it('follows the name table when it is cleared', async () => {
+        const question = (name: string) => response(1, 0, labels(name), u16(1, 1))
+
+        // The smallest table holds the names of a single message, each one clears it.
+        const messages = await parse([question('a.example'), question('b.example'), question('a.example')], { maxNames: 1 })
+
+        expect(messages.map(message => message.questionName)).toEqual(['a.example', 'b.example', 'a.example'])
+    })
+})
@@ -0,0 +1,109 @@
+import { Buffer } from 'node:buffer'
+import { createOfflineSession } from '@/index'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, tcp, TCP_ACK, TCP_FIN, TCP_PSH, TCP_SYN, writePcap } from './pcap'
+import type { FlowCutoffStats } from '@/types'
+
+function segment(fromClient: boolean, flags: number, payload = Buffer.alloc(0), sport = 50000) {
+    const [saddr, daddr] = fromClient ? ['10.0.0.1', '10.0.0.2'] : ['10.0.0.2', '10.0.0.1']
+    const ports = fromClient ? { sport, dport: 80 } : { sport: 80, dport: sport }
+
+    return ethernet(ipv4({ saddr, daddr, protocol: 6 }, tcp({ ...ports, flags }, payload)))
+}
+
+describe('flowCutoff', () => {
+    it('reports the flows still open at the end of the file', async () => {
+        const frames = Array.from({ length: 5 }, () => segment(true, TCP_ACK | TCP_PSH, Buffer.from('data')))
+        const flows: FlowCutoffStats[] = []
+        let packets = 0
+
+        const session = await replay(frames, { flowCutoff: { packets: 2 } }, (session) => {
+            session.on('packet', () => packets++)
+            session.on('flowEnd', flow => flows.push(flow))
+        })
+
+        session.close()
+
+        expect(packets).toBe(2)
+        expect(flows).toHaveLength(1)
+        expect(flows[0]).toMatchObject({ addressA: '10.0.0.1', portA: 50000, packets: 2, bytes: 8, cutoffPackets: 3, cutoffBytes: 12 })
+    })
+
+    it('reports the flows still open when the session is closed', async () => {
+        const frames = [
+            ...Array.from({ length: 3 }, () => segment(true, TCP_ACK | TCP_PSH, Buffer.from('data'))),
+            segment(true, TCP_SYN, Buffer.alloc(0), 50001),
+            segment(true, TCP_ACK, Buffer.alloc(0), 50001),
+        ]
+
+        const session = createOfflineSession(writePcap(frames), { flowCutoff: { packets: 1 } })
+        const flows: FlowCutoffStats[] = []
+        let packets = 0
+        let ended = false
+
+        session.on('flowEnd', flow => flows.push(flow))
+        session.on('end', () => ended = true)
+
+        await new Promise<void>((resolve) => {
+            session.on('packet', () => {
+                // First packet of the second flow.
+                if (++packets === 2) {
+                    session.close()
+                    resolve()
+                }
+            })
+        })
+
+        expect(ended).toBe(false)
+        expect(flows).toHaveLength(1)
+        expect(flows[0]).toMatchObject({ portA: 50000, packets: 1, cutoffPackets: 2 })
+    })
+
+    it('ignores the last ACK of a closed connection', async () => {
+        const frames = [
+            segment(true, TCP_SYN),
+            segment(false, TCP_SYN | TCP_ACK),
+            segment(true, TCP_ACK),
+            segment(true, TCP_ACK | TCP_PSH, Buffer.from('GET / HTTP/1.1\r\n\r\n')),
+            segment(false, TCP_ACK | TCP_PSH, Buffer.from('HTTP/1.1 200 OK\r\n\r\n')),
+            segment(true, TCP_FIN | TCP_ACK),
+            segment(false, TCP_FIN | TCP_ACK),
+            segment(true, TCP_ACK),
+        ]
+
+        const flows: FlowCutoffStats[] = []
+        let packets = 0
+
+        const session = await replay(frames, { flowCutoff: { packets: 2 } }, (session) => {
+            session.on('packet', () => packets++)
+            session.on('flowEnd', flow => flows.push(flow))
+        })
+
+        session.close()
+
+        expect(packets).toBe(2)
+        expect(flows).toHaveLength(1)
+        expect(flows[0]).toMatchObject({ packets: 2, cutoffPackets: 5 })
+    })
+
+    it('starts a new flow when the ports are reused', async () => {
+        const frames = [
+            segment(true, TCP_SYN),
+            segment(true, TCP_FIN | TCP_ACK),
+            segment(false, TCP_FIN | TCP_ACK),
+            segment(true, TCP_ACK),
+            segment(true, TCP_SYN),
+        ]
+
+        let packets = 0
+
+        const session = await replay(frames, { flowCutoff: { packets: 2 } }, (session) => {
+            session.on('packet', () => packets++)
+        })
+
+        session.close()
+
+        // Both SYNs and the first FIN, the last ACK belongs to the cut connection.
+        expect(packets).toBe(3)
+    })
+})
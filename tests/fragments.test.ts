@@ -0,0 +1,153 @@
+import { Buffer } from 'node:buffer'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, udp } from './pcap'
+import type { ReassemblyOptions } from '@/types'
+import type { Frame } from './pcap'
+
+// https://datatracker.ietf.org/doc/html/rfc7348
+function vxlan(vni: number, frame: Buffer, outer = '192.168.0.1') {
+    const header = Buffer.alloc(8)
+
+    header[0] = 0x08
+    header.writeUInt32BE(vni << 8, 4)
+
+    return ethernet(ipv4({ saddr: outer, daddr: '192.168.0.2', protocol: 17 }, udp({ sport: 40000, dport: 4789 }, Buffer.concat([header, frame]))))
+}
+
+// The UDP datagram `payload` in two IPv4 fragments.
+function fragments(payload: Buffer, id = 7, saddr = '10.0.0.1') {
+    const datagram = udp({ sport: 5000, dport: 6000 }, payload)
+    const fields = { saddr, daddr: '10.0.0.2', protocol: 17, id }
+
+    return {
+        whole: ipv4(fields, datagram),
+        first: ipv4({ ...fields, more: true }, datagram.subarray(0, 16)),
+        last: ipv4({ ...fields, offset: 16 }, datagram.subarray(16)),
+    }
+}
+
+// Each packet delivered by the session, with its stats at the end of the file.
+async function reassemble(frames: (Buffer | Frame)[], options: ReassemblyOptions) {
+    const packets: Buffer[] = []
+
+    const session = await replay(frames, { reassembly: options }, (session) => {
+        session.on('packet', packet => packets.push(Buffer.from(packet.buffer.subarray(0, packet.headerView!.caplen))))
+    })
+
+    const stats = session.stats()
+
+    session.close()
+    return { packets, stats }
+}
+
+describe('reassembly', () => {
+    it('fixes the lengths of the tunnel headers', async () => {
+        const { whole, first, last } = fragments(Buffer.from('reassembled in a tunnel'))
+        const packets: Buffer[] = []
+
+        const session = await replay([vxlan(42, ethernet(first)), vxlan(42, ethernet(last))], { reassembly: true, tunnels: 1, metadata: true }, (session) => {
+            session.on('packet', (packet) => {
+                packets.push(Buffer.from(packet.buffer.subarray(0, packet.headerView!.caplen)))
+                expect(packet.meta!.tunnelId).toBe(42)
+                expect(packet.meta!.payloadLength).toBe(23)
+            })
+        })
+
+        // Built with the lengths and checksums of a datagram never fragmented.
+        expect(packets).toEqual([vxlan(42, ethernet(whole))])
+        session.close()
+    })
+
+    it('keeps the datagrams of each tunnel apart', async () => {
+        const a = fragments(Buffer.from('sent in the tunnel 1...'))
+        const b = fragments(Buffer.from('sent in the tunnel 2...'))
+        const packets: Buffer[] = []
+
+        // Same inner addresses and identification in both tunnels.
+        const frames = [vxlan(1, ethernet(a.first)), vxlan(2, ethernet(b.first)), vxlan(2, ethernet(b.last)), vxlan(1, ethernet(a.last))]
+
+        const session = await replay(frames, { reassembly: true, tunnels: 1 }, (session) => {
+            session.on('packet', packet => packets.push(Buffer.from(packet.buffer.subarray(0, packet.headerView!.caplen))))
+        })
+
+        expect(packets).toEqual([vxlan(2, ethernet(b.whole)), vxlan(1, ethernet(a.whole))])
+        session.close()
+    })
+})
+
+describe('reassembly limits', () => {
+    const { whole, first, last } = fragments(Buffer.from('the bytes received first'))
+
+    // The first fragment again, with other bytes after the UDP header.
+    const resent = Buffer.from(first)
+
+    resent.write('resent..', resent.length - 8)
+
+    const frames = [ethernet(first), ethernet(resent), ethernet(last)]
+
+    it('keeps the bytes received first', async () => {
+        const { packets, stats } = await reassemble(frames, { overlap: 'first' })
+
+        expect(packets).toEqual([ethernet(whole)])
+        expect(stats.fragmentOverlaps).toBe(1)
+    })
+
+    it('overwrites them with the last fragment', async () => {
+        const { packets, stats } = await reassemble(frames, { overlap: 'last' })
+
+        expect(packets).toEqual([ethernet(fragments(Buffer.from('resent..s received first')).whole)])
+        expect(stats.fragmentOverlaps).toBe(1)
+    })
+
+    it('drops the datagrams with overlaps', async () => {
+        const { packets, stats } = await reassemble(frames, { overlap: 'drop' })
+
+        // The last fragment starts another datagram, never completed.
+        expect(packets).toEqual([])
+        expect(stats).toMatchObject({ fragmentOverlaps: 1, reassembled: 0 })
+    })
+
+    it('drops the datagrams after the timeout', async () => {
+        const { packets, stats } = await reassemble([{ data: ethernet(first), time: 1700000000 }, { data: ethernet(last), time: 1700000010 }], { timeout: 5 })
+
+        expect(packets).toEqual([])
+        expect(stats.fragmentTimeouts).toBe(1)
+    })
+
+    it('evicts the oldest datagram when the table is full', async () => {
+        const a = fragments(Buffer.from('evicted by the datagram b'), 1)
+        const b = fragments(Buffer.from('evicts the datagram a...'), 2)
+
+        const { packets, stats } = await reassemble([a.first, b.first, b.last, a.last].map(frame => ethernet(frame)), { maxDatagrams: 1 })
+
+        expect(packets).toEqual([ethernet(b.whole)])
+        expect(stats).toMatchObject({ fragmentEvictions: 1, reassembled: 1 })
+    })
+
+    it('evicts the oldest datagram of a source over its limit', async () => {
+        const a = fragments(Buffer.from('evicted by the datagram b'), 1)
+        const b = fragments(Buffer.from('evicts the datagram a...'), 2)
+        const c = fragments(Buffer.from('sent by another source..'), 3, '10.0.0.3')
+
+        const { packets, stats } = await reassemble([a.first, b.first, c.first, c.last, b.last, a.last].map(frame => ethernet(frame)), { maxPerSource: 1 })
+
+        expect(packets).toEqual([ethernet(c.whole), ethernet(b.whole)])
+        expect(stats).toMatchObject({ fragmentEvictions: 1, reassembled: 2 })
+    })
+
+    it('evicts the datagrams resent too many times', async () => {
+        // A datagram is evicted after 256 fragments.
+        const resent = (copies: number) => [...Array.from({ length: copies }, () => ethernet(first)), ethernet(last)]
+
+        const kept = await reassemble(resent(255), {})
+
+        expect(kept.packets).toEqual([ethernet(whole)])
+        expect(kept.stats).toMatchObject({ fragmentOverlaps: 254, fragmentEvictions: 0 })
+
+        const evicted = await reassemble(resent(256), {})
+
+        // The last fragment is the 257th one.
+        expect(evicted.packets).toEqual([])
+        expect(evicted.stats).toMatchObject({ fragmentEvictions: 1, reassembled: 0 })
+    })
+})
@@ -0,0 +1,63 @@
+import { Buffer } from 'node:buffer'
+import { endianness } from 'node:os'
+import { NpcapHeader } from '@/decode'
+import { PACKET_HEADER_SIZE, PacketHeader } from '@/header'
+import { describe, expect, it } from 'vitest'
+
+// Header as written by lib/session.cpp, in host byte order.
+function header(fields: { tvSec: number, tvNsec: number, caplen: number, len: number, ifindex?: number, drops?: number, sequence?: number }) {
+    const buffer = Buffer.alloc(PACKET_HEADER_SIZE)
+    const le = endianness() === 'LE'
+    const write32 = (value: number, offset: number) => le ? buffer.writeUInt32LE(value, offset) : buffer.writeUInt32BE(value, offset)
+
+    write32(fields.tvSec % 0x100000000, 0)
+    write32(Math.floor(fields.tvNsec / 1000), 4)
+    write32(fields.caplen, 8)
+    write32(fields.len, 12)
+    le ? buffer.writeBigUInt64LE(BigInt(fields.tvSec), 16) : buffer.writeBigUInt64BE(BigInt(fields.tvSec), 16)
+    write32(fields.tvNsec, 24)
+    write32(fields.ifindex ?? 0, 28)
+    write32(fields.drops ?? 0, 32)
+    write32(fields.sequence ?? 0, 36)
+
+    return buffer
+}
+
+describe('PacketHeader', () => {
+    it('reads the fields in place', () => {
+        const view = new PacketHeader(header({ tvSec: 1700000000, tvNsec: 123456000, caplen: 60, len: 1514, ifindex: 3, drops: 7, sequence: 12 }))
+
+        expect(view.tvSec).toBe(1700000000)
+        expect(view.tvUsec).toBe(123456)
+        expect(view.tvNsec).toBe(123456000)
+        expect(view.caplen).toBe(60)
+        expect(view.len).toBe(1514)
+        expect(view.ifindex).toBe(3)
+        expect(view.drops).toBe(7)
+        expect(view.sequence).toBe(12)
+        expect(view.timestamp).toBe(1700000000123.456)
+    })
+
+    it('keeps the seconds after 2038 and 2106', () => {
+        const view = new PacketHeader(header({ tvSec: 2 ** 32 + 5, tvNsec: 0, caplen: 0, len: 0 }))
+
+        expect(view.tvSec).toBe(2 ** 32 + 5)
+        expect(view.tvSec64).toBe(2n ** 32n + 5n)
+        expect(view.words[0]).toBe(5)
+    })
+
+    it('follows the buffer it views', () => {
+        const buffer = Buffer.alloc(PACKET_HEADER_SIZE)
+        const view = new PacketHeader(buffer)
+
+        header({ tvSec: 1, tvNsec: 0, caplen: 42, len: 42 }).copy(buffer)
+        expect(view.caplen).toBe(42)
+    })
+
+    it('is read by the decoder', () => {
+        const raw = header({ tvSec: 2 ** 31 + 1, tvNsec: 0, caplen: 14, len: 14 })
+
+        expect(new NpcapHeader(raw)).toMatchObject({ tvSec: 2 ** 31 + 1, caplen: 14 })
+        expect(new NpcapHeader(raw.subarray(0, 16))).toMatchObject({ tvSec: 2 ** 31 + 1, caplen: 14 })
+    })
+})
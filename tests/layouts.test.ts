@@ -0,0 +1,57 @@
+import { Buffer } from 'node:buffer'
+import { readFileSync } from 'node:fs'
+import { resolve } from 'node:path'
+import { TCPOptions } from '@/decode/protocols/tcp'
+import { readTcpSackBlocks, TcpLayout } from '@/layouts'
+import { describe, expect, it } from 'vitest'
+import { generateCpp, generateTs } from '../scripts/layouts'
+import type { Schema } from '../scripts/layouts'
+
+const root = resolve(import.meta.dirname, '..')
+const schema: Schema = JSON.parse(readFileSync(resolve(root, 'schema/layouts.json'), 'utf8'))
+
+describe('layouts', () => {
+    it('are generated from the schema', () => {
+        expect(readFileSync(resolve(root, 'src/layouts.ts'), 'utf8')).toBe(generateTs(schema))
+        expect(readFileSync(resolve(root, 'lib/layouts.h'), 'utf8')).toBe(generateCpp(schema))
+    })
+
+    it('rejects the fields out of the layout', () => {
+        const layout = { name: 'bad', ref: '', size: 4, fields: [{ name: 'value', offset: 2, type: 'u32' as const }] }
+
+        expect(() => generateTs({ layouts: [layout] })).toThrow('bad.value ends after the 4 bytes of the layout.')
+    })
+
+    it('rejects the masks with bits below the shift', () => {
+        const layout = { name: 'bad', ref: '', size: 1, fields: [{ name: 'value', offset: 0, type: 'u8' as const, mask: '0x1F', shift: 4 }] }
+
+        expect(() => generateCpp({ layouts: [layout] })).toThrow('bad.value has bits of its mask below the shift.')
+    })
+
+    it('reads the header fields in place', () => {
+        const tcp = new TcpLayout()
+
+        tcp.point(Buffer.from('0000b5dd00500aaf604e0000000060c2102044b20000', 'hex'), 2)
+
+        expect(tcp.sport).toBe(46557)
+        expect(tcp.dport).toBe(80)
+        expect(tcp.headerLength).toBe(24)
+        expect(tcp.syn).toBe(true)
+        expect(tcp.ack).toBe(false)
+    })
+
+    it('reads the repeated blocks', () => {
+        const buffer = Buffer.from('00000001000000020000000300000004', 'hex')
+
+        expect(readTcpSackBlocks(buffer, 0, 2)).toEqual([[1, 2], [3, 4]])
+    })
+
+    it('are used for the TCP SACK option', () => {
+        const options = new TCPOptions()
+
+        // NOP, NOP, SACK with 2 blocks, end of options.
+        options.decode(Buffer.from('0101051200000001000000020000000300000004000000', 'hex'), 0, 23)
+
+        expect(options.sack).toEqual([[1, 2], [3, 4]])
+    })
+})
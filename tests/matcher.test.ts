@@ -0,0 +1,51 @@
+import { Buffer } from 'node:buffer'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, tcp, TCP_ACK, TCP_PSH } from './pcap'
+import type { Frame } from './pcap'
+import type { OfflineSessionOptions } from '@/types'
+
+function segment(payload: string) {
+    return ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, tcp({ sport: 50000, dport: 80, flags: TCP_ACK | TCP_PSH }, Buffer.from(payload))))
+}
+
+// Matched indexes (sorted) and delivered length of each packet.
+async function match(frames: (Buffer | Frame)[], options: OfflineSessionOptions) {
+    const packets: { matches: number[], length: number }[] = []
+
+    const session = await replay(frames, options, (session) => {
+        session.on('packet', packet => packets.push({ matches: [...packet.matches!].sort((a, b) => a - b), length: packet.headerView!.caplen }))
+    })
+
+    session.close()
+
+    return packets
+}
+
+describe('patterns', () => {
+    it('reports the overlapping patterns once each', async () => {
+        const packets = await match([segment('ushers'), segment('his hershe')], { patterns: ['he', 'she', 'his', 'hers'] })
+
+        expect(packets.map(packet => packet.matches)).toEqual([[0, 1, 3], [0, 1, 2, 3]])
+    })
+
+    it('only delivers the matched packets', async () => {
+        const packets = await match([segment('nothing'), segment('GET /')], { patterns: ['GET '], onlyMatched: true })
+
+        expect(packets).toEqual([{ matches: [0], length: 59 }])
+    })
+
+    it('searches the payload past the slice', async () => {
+        const packets = await match([segment('0123456789 needle')], { patterns: ['needle'], sliceLength: 58 })
+
+        expect(packets).toEqual([{ matches: [0], length: 58 }])
+    })
+
+    it('doesn\'t match the patterns cut at the captured length', async () => {
+        const full = segment('needle haystack')
+
+        // Captured up to 'needle hay'.
+        const packets = await match([{ data: full.subarray(0, 64), len: full.length }], { patterns: ['needle', 'haystack'] })
+
+        expect(packets).toEqual([{ matches: [0], length: 64 }])
+    })
+})
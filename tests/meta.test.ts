@@ -0,0 +1,342 @@
+import { Buffer } from 'node:buffer'
+import { endianness } from 'node:os'
+import { META_CHECKSUM_OFFLOAD, META_FRAGMENT, META_L4_CHECKSUM_BAD, META_MPLS, META_PARSED, META_RADIOTAP, META_TRUNCATED, META_TUNNEL, META_VLAN, META_WLAN, PACKET_META_SIZE, PacketMeta, TUNNEL_VXLAN } from '@/meta'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, ipv6, replay, TCP_ACK, TCP_PSH, TCP_SYN, tcp, udp } from './pcap'
+import type { Frame } from './pcap'
+
+function record(fields: { flags: number, vlan?: number, ipVersion: number, saddr: number[], daddr: number[] }) {
+    const buffer = Buffer.alloc(PACKET_META_SIZE)
+    const le = endianness() === 'LE'
+    const write16 = (value: number, offset: number) => le ? buffer.writeUInt16LE(value, offset) : buffer.writeUInt16BE(value, offset)
+    const write32 = (value: number, offset: number) => le ? buffer.writeUInt32LE(value, offset) : buffer.writeUInt32BE(value, offset)
+
+    write16(1, 0)
+    write16(fields.flags, 2)
+    write32(14, 4)
+    write32(34, 8)
+    write32(54, 12)
+    write16(fields.ipVersion === 4 ? 0x0800 : 0x86DD, 16)
+    write16(fields.vlan ?? 0, 18)
+    buffer[20] = fields.ipVersion
+    buffer[21] = 6
+    buffer[22] = 128
+    buffer[23] = 0x18
+    write16(50144, 24)
+    write16(443, 26)
+    write32(10, 28)
+    buffer.set(fields.saddr, 32)
+    buffer.set(fields.daddr, 48)
+    le ? buffer.writeBigUInt64LE(0x0123456789ABCDEFn, 64) : buffer.writeBigUInt64BE(0x0123456789ABCDEFn, 64)
+
+    return buffer
+}
+
+describe('packetMeta', () => {
+    it('reads the fields of an IPv4 record', () => {
+        const meta = new PacketMeta(record({ flags: META_PARSED, ipVersion: 4, saddr: [192, 168, 0, 6], daddr: [99, 181, 81, 5] }))
+
+        expect(meta.linkType).toBe(1)
+        expect(meta.parsed).toBe(true)
+        expect(meta.truncated).toBe(false)
+        expect(meta.l3Offset).toBe(14)
+        expect(meta.l4Offset).toBe(34)
+        expect(meta.payloadOffset).toBe(54)
+        expect(meta.etherType).toBe(0x0800)
+        expect(meta.vlan).toBe(-1)
+        expect(meta.ipVersion).toBe(4)
+        expect(meta.protocol).toBe(6)
+        expect(meta.ttl).toBe(128)
+        expect(meta.tcpFlags).toBe(0x18)
+        expect(meta.sport).toBe(50144)
+        expect(meta.dport).toBe(443)
+        expect(meta.payloadLength).toBe(10)
+        expect(meta.saddr4).toBe(0xC0A80006)
+        expect(meta.saddr).toBe('192.168.0.6')
+        expect(meta.daddr).toBe('99.181.81.5')
+        expect(meta.flowHash).toBe(0x0123456789ABCDEFn)
+        expect(meta.flowHash32).toBe(0x89ABCDEF)
+    })
+
+    it('reads the VLAN id and IPv6 addresses', () => {
+        const saddr = [0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x11, 0x22, 0xFF, 0xFE, 0x33, 0x44, 0x55]
+        const daddr = [0xFF, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01]
+        const meta = new PacketMeta(record({ flags: META_PARSED | META_VLAN, vlan: 42, ipVersion: 6, saddr, daddr }))
+
+        expect(meta.vlan).toBe(42)
+        expect(meta.saddr).toBe('fe80:0000:0000:0000:0211:22ff:fe33:4455')
+        expect(meta.daddr).toBe('ff02:0000:0000:0000:0000:0000:0000:0001')
+    })
+
+    it('reads the checksum flags', () => {
+        const meta = new PacketMeta(record({ flags: META_PARSED | META_L4_CHECKSUM_BAD, ipVersion: 4, saddr: [10, 0, 0, 1], daddr: [10, 0, 0, 2] }))
+
+        expect(meta.ipChecksumBad).toBe(false)
+        expect(meta.l4ChecksumBad).toBe(true)
+        expect(meta.checksumOffload).toBe(false)
+
+        const offload = new PacketMeta(record({ flags: META_PARSED | META_CHECKSUM_OFFLOAD, ipVersion: 4, saddr: [10, 0, 0, 1], daddr: [10, 0, 0, 2] }))
+
+        expect(offload.l4ChecksumBad).toBe(false)
+        expect(offload.checksumOffload).toBe(true)
+    })
+
+    it('reads the outer headers of a tunnel', () => {
+        const buffer = record({ flags: META_PARSED | META_TUNNEL | META_MPLS, ipVersion: 4, saddr: [192, 168, 0, 6], daddr: [192, 168, 0, 7] })
+        const le = endianness() === 'LE'
+
+        buffer[72] = TUNNEL_VXLAN
+        buffer[73] = 1
+        buffer[74] = 4
+        buffer[75] = 17
+        le ? buffer.writeUInt16LE(4789, 78) : buffer.writeUInt16BE(4789, 78)
+        le ? buffer.writeUInt32LE(0x1234, 80) : buffer.writeUInt32BE(0x1234, 80)
+        le ? buffer.writeUInt32LE(16, 84) : buffer.writeUInt32BE(16, 84)
+        le ? buffer.writeUInt32LE(50, 92) : buffer.writeUInt32BE(50, 92)
+        buffer.set([10, 1, 0, 1], 96)
+        buffer.set([10, 1, 0, 2], 112)
+
+        const meta = new PacketMeta(buffer)
+
+        expect(meta.tunneled).toBe(true)
+        expect(meta.tunnelType).toBe(TUNNEL_VXLAN)
+        expect(meta.tunnelDepth).toBe(1)
+        expect(meta.tunnelId).toBe(0x1234)
+        expect(meta.mplsLabel).toBe(16)
+        expect(meta.outerProtocol).toBe(17)
+        expect(meta.outerDport).toBe(4789)
+        expect(meta.innerOffset).toBe(50)
+        expect(meta.outerSaddr).toBe('10.1.0.1')
+        expect(meta.outerDaddr4).toBe(0x0A010002)
+        expect(meta.saddr).toBe('192.168.0.6')
+    })
+
+    it('has no tunnel by default', () => {
+        const meta = new PacketMeta(record({ flags: META_PARSED, ipVersion: 4, saddr: [10, 0, 0, 1], daddr: [10, 0, 0, 2] }))
+
+        expect(meta.tunneled).toBe(false)
+        expect(meta.mplsLabel).toBe(-1)
+        expect(meta.outerSaddr).toBe('')
+    })
+
+    it('reads the radiotap and 802.11 fields', () => {
+        const buffer = record({ flags: META_PARSED | META_RADIOTAP | META_WLAN, ipVersion: 4, saddr: [10, 0, 0, 1], daddr: [10, 0, 0, 2] })
+        const le = endianness() === 'LE'
+
+        le ? buffer.writeUInt16LE(5180, 128) : buffer.writeUInt16BE(5180, 128)
+        le ? buffer.writeUInt16LE(108, 132) : buffer.writeUInt16BE(108, 132)
+        buffer.writeInt8(-42, 134)
+        le ? buffer.writeUInt16LE(0x0288, 136) : buffer.writeUInt16BE(0x0288, 136)
+        buffer.set([0x00, 0x11, 0x22, 0x33, 0x44, 0x55], 146)
+        le ? buffer.writeUInt16LE(7, 158) : buffer.writeUInt16BE(7, 158)
+
+        const meta = new PacketMeta(buffer)
+
+        expect(meta.radiotap).toBe(true)
+        expect(meta.frequency).toBe(5180)
+        expect(meta.channel).toBe(36)
+        expect(meta.rate).toBe(54)
+        expect(meta.signal).toBe(-42)
+        expect(meta.noise).toBe(0)
+        expect(meta.frameType).toBe(2)
+        expect(meta.frameSubtype).toBe(8)
+        expect(meta.addr2).toBe('00:11:22:33:44:55')
+        expect(meta.sequence).toBe(7)
+    })
+})
+
+// Fields of a record read natively, the record is reused by the next packet.
+function fields(meta: PacketMeta) {
+    return {
+        flags: meta.flags,
+        vlan: meta.vlan,
+        etherType: meta.etherType,
+        ipVersion: meta.ipVersion,
+        protocol: meta.protocol,
+        l3Offset: meta.l3Offset,
+        l4Offset: meta.l4Offset,
+        payloadOffset: meta.payloadOffset,
+        payloadLength: meta.payloadLength,
+        sport: meta.sport,
+        dport: meta.dport,
+        tcpFlags: meta.tcpFlags,
+        saddr: meta.saddr,
+        daddr: meta.daddr,
+    }
+}
+
+async function parse(frames: (Buffer | Frame)[]) {
+    const records: Record<string, unknown>[] = []
+
+    const session = await replay(frames, { metadata: true }, (session) => {
+        session.on('packet', ({ meta }) => records.push(fields(meta!)))
+    })
+
+    session.close()
+    return records
+}
+
+// Linux cooked capture v2 header, as captured on the `any` device.
+function sll2(ifindex: number, payload: Buffer, type = 0x0800) {
+    const header = Buffer.alloc(20)
+
+    header.writeUInt16BE(type, 0)
+    header.writeUInt32BE(ifindex, 4)
+    header.writeUInt16BE(1, 8)
+    header[10] = 0
+    header[11] = 6
+    header.write('00112233445566770000', 12, 'hex')
+
+    return Buffer.concat([header, payload])
+}
+
+// IPv6 extension header of 8 bytes (Hop-by-Hop or Destination Options), padded with zeros.
+function extension(nextHeader: number) {
+    return Buffer.from([nextHeader, 0, 0, 0, 0, 0, 0, 0])
+}
+
+describe('native meta', () => {
+    it('skips the VLAN tags', async () => {
+        const segment = tcp({ sport: 50144, dport: 443, flags: TCP_PSH | TCP_ACK }, Buffer.from('hello'))
+        const [meta] = await parse([ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, segment), 0x0800, [100, 200])])
+
+        // The outer tag (802.1ad) is the one reported.
+        expect(meta).toEqual({
+            flags: META_PARSED | META_VLAN,
+            vlan: 100,
+            etherType: 0x0800,
+            ipVersion: 4,
+            protocol: 6,
+            l3Offset: 22,
+            l4Offset: 42,
+            payloadOffset: 62,
+            payloadLength: 5,
+            sport: 50144,
+            dport: 443,
+            tcpFlags: TCP_PSH | TCP_ACK,
+            saddr: '10.0.0.1',
+            daddr: '10.0.0.2',
+        })
+    })
+
+    it('follows the IPv6 extension headers', async () => {
+        const payload = Buffer.concat([extension(60), extension(17), udp({ sport: 5353, dport: 5353 }, Buffer.from('query'))])
+        const [meta] = await parse([ethernet(ipv6({ saddr: 'fe80::1', daddr: 'ff02::fb', nextHeader: 0 }, payload), 0x86DD)])
+
+        expect(meta).toMatchObject({
+            flags: META_PARSED,
+            ipVersion: 6,
+            protocol: 17,
+            l3Offset: 14,
+            l4Offset: 70,
+            payloadOffset: 78,
+            payloadLength: 5,
+            sport: 5353,
+            dport: 5353,
+        })
+        expect(meta.saddr).toMatch(/^fe80:/)
+    })
+
+    it('reads the ports of the first fragment only', async () => {
+        const datagram = udp({ sport: 5000, dport: 6000 }, Buffer.alloc(24))
+        const fields = { saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 17 }
+
+        // IPv6 fragment header: UDP, offset 16 bytes, identification 9.
+        const fragment = Buffer.from([17, 0, 0, 16, 0, 0, 0, 9])
+
+        const [first, last, v6] = await parse([
+            ethernet(ipv4({ ...fields, more: true }, datagram.subarray(0, 16))),
+            ethernet(ipv4({ ...fields, offset: 16 }, datagram.subarray(16))),
+            ethernet(ipv6({ saddr: 'fe80::1', daddr: 'fe80::2', nextHeader: 44 }, Buffer.concat([fragment, datagram.subarray(16)])), 0x86DD),
+        ])
+
+        expect(first).toMatchObject({ flags: META_PARSED | META_FRAGMENT, sport: 5000, dport: 6000, l4Offset: 34, payloadOffset: 42, payloadLength: 8 })
+        expect(last).toMatchObject({ flags: META_PARSED | META_FRAGMENT, sport: 0, dport: 0, l4Offset: 34, payloadOffset: 34, payloadLength: 16 })
+        expect(v6).toMatchObject({ flags: META_PARSED | META_FRAGMENT, ipVersion: 6, protocol: 17, sport: 0, payloadOffset: 62, payloadLength: 16 })
+    })
+
+    it('flags the packets cut by the capture', async () => {
+        const frame = ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, tcp({ sport: 50144, dport: 443, flags: TCP_SYN })))
+        const [tcpCut, ipCut] = await parse([
+            { data: frame.subarray(0, 44), len: frame.length },
+            { data: frame.subarray(0, 24), len: frame.length },
+        ])
+
+        // The IP header is complete, not the TCP one.
+        expect(tcpCut).toMatchObject({ flags: META_TRUNCATED, ipVersion: 4, protocol: 6, l4Offset: 34, sport: 0 })
+        expect(ipCut).toMatchObject({ flags: META_TRUNCATED, ipVersion: 0, l3Offset: 14 })
+    })
+
+    it('reads the Linux cooked captures', async () => {
+        const records: Record<string, unknown>[] = []
+        const segment = tcp({ sport: 50144, dport: 443, flags: TCP_PSH | TCP_ACK }, Buffer.from('hello'))
+        const frames = [
+            sll2(3, ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, segment)),
+            sll2(7, ipv6({ saddr: 'fe80::1', daddr: 'fe80::2', nextHeader: 17 }, udp({ sport: 5353, dport: 5353 }, Buffer.from('mdns'))), 0x86DD),
+        ]
+
+        const session = await replay(frames, { metadata: true }, (session) => {
+            session.on('packet', packet => records.push({ ...fields(packet.meta!), ifindex: packet.headerView!.ifindex }))
+        }, 276)
+
+        session.close()
+
+        expect(records).toEqual([
+            {
+                flags: META_PARSED,
+                vlan: -1,
+                etherType: 0x0800,
+                ipVersion: 4,
+                protocol: 6,
+                l3Offset: 20,
+                l4Offset: 40,
+                payloadOffset: 60,
+                payloadLength: 5,
+                sport: 50144,
+                dport: 443,
+                tcpFlags: TCP_PSH | TCP_ACK,
+                saddr: '10.0.0.1',
+                daddr: '10.0.0.2',
+                ifindex: 3,
+            },
+            {
+                flags: META_PARSED,
+                vlan: -1,
+                etherType: 0x86DD,
+                ipVersion: 6,
+                protocol: 17,
+                l3Offset: 20,
+                l4Offset: 60,
+                payloadOffset: 68,
+                payloadLength: 4,
+                sport: 5353,
+                dport: 5353,
+                tcpFlags: 0,
+                saddr: 'fe80:0000:0000:0000:0000:0000:0000:0001',
+                daddr: 'fe80:0000:0000:0000:0000:0000:0000:0002',
+                ifindex: 7,
+            },
+        ])
+    })
+
+    it('keys the flow hash per session', async () => {
+        const frames = [
+            ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, tcp({ sport: 50144, dport: 443, flags: TCP_ACK }))),
+            ethernet(ipv4({ saddr: '10.0.0.2', daddr: '10.0.0.1', protocol: 6 }, tcp({ sport: 443, dport: 50144, flags: TCP_ACK }))),
+        ]
+        const hashes: bigint[][] = [[], []]
+
+        for (const hashesOfSession of hashes) {
+            const session = await replay(frames, { metadata: true }, (session) => {
+                session.on('packet', packet => hashesOfSession.push(packet.meta!.flowHash))
+            })
+
+            session.close()
+        }
+
+        // Both directions share the hash of the session, the other session has another one.
+        expect(hashes[0][0]).toBe(hashes[0][1])
+        expect(hashes[1][0]).toBe(hashes[1][1])
+        expect(hashes[0][0]).not.toBe(hashes[1][0])
+    })
+})
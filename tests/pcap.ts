@@ -0,0 +1,203 @@
+import { Buffer } from 'node:buffer'
+import { mkdtempSync, readFileSync, writeFileSync } from 'node:fs'
+import { tmpdir } from 'node:os'
+import { join } from 'node:path'
+import { createOfflineSession } from '@/index'
+import type { NpcapSession } from '@/session'
+import type { OfflineSessionOptions } from '@/types'
+
+// Frames of the capture files read by the native tests, built from their headers.
+
+export const TCP_FIN = 0x01
+export const TCP_SYN = 0x02
+export const TCP_RST = 0x04
+export const TCP_PSH = 0x08
+export const TCP_ACK = 0x10
+
+export interface Frame {
+    data: Buffer
+
+    /** Capture time in seconds, one millisecond after the previous frame by default. */
+    time?: number
+
+    /** Length on the wire, `data.length` by default. */
+    len?: number
+}
+
+function address(value: string) {
+    if (!value.includes(':'))
+        return Buffer.from(value.split('.').map(Number))
+
+    const [head, tail = ''] = value.split('::')
+    const words = (part: string) => part ? part.split(':').map(word => Number.parseInt(word, 16)) : []
+    const high = words(head)
+    const low = words(tail)
+    const bytes = Buffer.alloc(16)
+
+    high.forEach((word, i) => bytes.writeUInt16BE(word, i * 2))
+    low.forEach((word, i) => bytes.writeUInt16BE(word, 16 - (low.length - i) * 2))
+
+    return bytes
+}
+
+function checksum(data: Buffer) {
+    let sum = 0
+
+    for (let i = 0; i < data.length; i += 2)
+        sum += (data[i] << 8) | (data[i + 1] ?? 0)
+
+    while (sum > 0xFFFF)
+        sum = (sum & 0xFFFF) + (sum >>> 16)
+
+    return ~sum & 0xFFFF
+}
+
+export function ethernet(payload: Buffer, type = 0x0800, vlans: number[] = []) {
+    const header = Buffer.alloc(14 + vlans.length * 4)
+
+    header.write('00112233445566778899aabb', 0, 'hex')
+    vlans.forEach((vlan, i) => {
+        header.writeUInt16BE(i === vlans.length - 1 ? 0x8100 : 0x88A8, 12 + i * 4)
+        header.writeUInt16BE(vlan, 14 + i * 4)
+    })
+    header.writeUInt16BE(type, header.length - 2)
+
+    return Buffer.concat([header, payload])
+}
+
+export function ipv4(fields: { saddr: string, daddr: string, protocol: number, id?: number, offset?: number, more?: boolean, ttl?: number }, payload: Buffer) {
+    const header = Buffer.alloc(20)
+
+    header[0] = 0x45
+    header.writeUInt16BE(20 + payload.length, 2)
+    header.writeUInt16BE(fields.id ?? 1, 4)
+    header.writeUInt16BE((fields.more ? 0x2000 : 0) | ((fields.offset ?? 0) >> 3), 6)
+    header[8] = fields.ttl ?? 64
+    header[9] = fields.protocol
+    address(fields.saddr).copy(header, 12)
+    address(fields.daddr).copy(header, 16)
+    header.writeUInt16BE(checksum(header), 10)
+
+    return Buffer.concat([header, payload])
+}
+
+export function ipv6(fields: { saddr: string, daddr: string, nextHeader: number }, payload: Buffer) {
+    const header = Buffer.alloc(40)
+
+    header[0] = 0x60
+    header.writeUInt16BE(payload.length, 4)
+    header[6] = fields.nextHeader
+    header[7] = 64
+    address(fields.saddr).copy(header, 8)
+    address(fields.daddr).copy(header, 24)
+
+    return Buffer.concat([header, payload])
+}
+
+export function tcp(fields: { sport: number, dport: number, seq?: number, ack?: number, flags: number }, payload = Buffer.alloc(0)) {
+    const header = Buffer.alloc(20)
+
+    header.writeUInt16BE(fields.sport, 0)
+    header.writeUInt16BE(fields.dport, 2)
+    header.writeUInt32BE((fields.seq ?? 0) >>> 0, 4)
+    header.writeUInt32BE((fields.ack ?? 0) >>> 0, 8)
+    header[12] = 5 << 4
+    header[13] = fields.flags
+    header.writeUInt16BE(65535, 14)
+
+    return Buffer.concat([header, payload])
+}
+
+export function udp(fields: { sport: number, dport: number }, payload: Buffer) {
+    const header = Buffer.alloc(8)
+
+    header.writeUInt16BE(fields.sport, 0)
+    header.writeUInt16BE(fields.dport, 2)
+    header.writeUInt16BE(8 + payload.length, 4)
+
+    return Buffer.concat([header, payload])
+}
+
+const directory = mkdtempSync(join(tmpdir(), 'npcap-'))
+let files = 0
+
+/**
+ * @returns A new `.pcap` path in the temporary directory of the tests.
+ */
+export function pcapPath() {
+    return join(directory, `${files++}.pcap`)
+}
+
+/**
+ * Writes the frames to a `.pcap` file (microsecond timestamps, host byte order).
+ *
+ * @returns The path of the file.
+ */
+export function writePcap(frames: (Buffer | Frame)[], linkType = 1) {
+    const chunks: Buffer[] = []
+    const header = Buffer.alloc(24)
+
+    header.writeUInt32LE(0xA1B2C3D4, 0)
+    header.writeUInt16LE(2, 4)
+    header.writeUInt16LE(4, 6)
+    header.writeUInt32LE(262144, 16)
+    header.writeUInt32LE(linkType, 20)
+    chunks.push(header)
+
+    let time = 1700000000
+
+    for (const entry of frames) {
+        const frame = Buffer.isBuffer(entry) ? { data: entry } : entry
+        const record = Buffer.alloc(16)
+
+        time = frame.time ?? time + 0.001
+
+        const seconds = Math.floor(time)
+
+        record.writeUInt32LE(seconds, 0)
+        record.writeUInt32LE(Math.round((time - seconds) * 1e6), 4)
+        record.writeUInt32LE(frame.data.length, 8)
+        record.writeUInt32LE(frame.len ?? frame.data.length, 12)
+        chunks.push(record, frame.data)
+    }
+
+    const path = pcapPath()
+
+    writeFileSync(path, Buffer.concat(chunks))
+    return path
+}
+
+/**
+ * Reads the frames of a little-endian `.pcap` file (written by `writePcap`, or to `outFile` on this host).
+ */
+export function readPcap(path: string) {
+    const file = readFileSync(path)
+    const frames: Required<Frame>[] = []
+
+    for (let offset = 24; offset + 16 <= file.length;) {
+        const caplen = file.readUInt32LE(offset + 8)
+
+        frames.push({
+            data: file.subarray(offset + 16, offset + 16 + caplen),
+            time: file.readUInt32LE(offset) + file.readUInt32LE(offset + 4) / 1e6,
+            len: file.readUInt32LE(offset + 12),
+        })
+        offset += 16 + caplen
+    }
+
+    return frames
+}
+
+/**
+ * Reads the frames with an offline session, `setup` adds the listeners before the first packet.
+ *
+ * @returns The session, once the end of the file was reached (it's still open).
+ */
+export async function replay(frames: (Buffer | Frame)[], options: OfflineSessionOptions = {}, setup?: (session: NpcapSession) => void, linkType = 1) {
+    const session = createOfflineSession(writePcap(frames, linkType), options)
+
+    setup?.(session)
+    await new Promise<void>(resolve => session.once('end', resolve))
+
+    return session
+}
@@ -0,0 +1,112 @@
+import { Buffer } from 'node:buffer'
+import { PACKET_HEADER_SIZE } from '@/header'
+import { RetainedPacket } from '@/retained'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, udp } from './pcap'
+import type { PacketData } from '@/types'
+
+// Handle of the slot `slot` of the size class `sizeClass` in the slab `slab`, as built by lib/pool.cpp.
+function handle(slab: number, sizeClass: number, slot: number, generation = 1) {
+    return generation * 0x100000000 + (((slab << 17) | (sizeClass << 13) | slot) >>> 0)
+}
+
+function datagram(payload: Buffer) {
+    return ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 17 }, udp({ sport: 5000, dport: 6000 }, payload)))
+}
+
+describe('RetainedPacket', () => {
+    it('reads the packet in place from the slot', () => {
+        const slab = new ArrayBuffer(1 << 20)
+        const offset = 3 * 256
+        const bytes = Buffer.from(slab, offset, PACKET_HEADER_SIZE + 4)
+
+        bytes.writeUInt32LE(1700000000, 0)
+        bytes.writeUInt32LE(4, 8)
+        bytes.writeUInt32LE(60, 12)
+        bytes.set([0xDE, 0xAD, 0xBE, 0xEF], PACKET_HEADER_SIZE)
+
+        const packet = new RetainedPacket({ release: () => true }, slab, handle(2, 1, 3), 'LINKTYPE_ETHERNET')
+
+        expect(RetainedPacket.slab(packet.handle)).toBe(2)
+        expect(packet.header.readUInt32LE(0)).toBe(1700000000)
+        expect(packet.headerView.caplen).toBe(4)
+        expect([...packet.buffer]).toEqual([0xDE, 0xAD, 0xBE, 0xEF])
+        expect(packet.buffer.buffer).toBe(slab)
+    })
+
+    it('releases the slot once', () => {
+        const released: number[] = []
+        const packet = new RetainedPacket({ release: (handle) => released.push(handle) > 0 }, new ArrayBuffer(1 << 20), handle(0, 0, 5), 'LINKTYPE_RAW')
+
+        packet.release()
+        packet.release()
+
+        expect(packet.released).toBe(true)
+        expect(released).toEqual([handle(0, 0, 5)])
+    })
+
+    it('decodes the handles of the last slabs', () => {
+        expect(RetainedPacket.slab(handle(32767, 10, 7))).toBe(32767)
+        expect(RetainedPacket.slab(handle(32767, 10, 7, 2 ** 21 - 1))).toBe(32767)
+    })
+})
+
+describe('retain', () => {
+    it('copies the packet it was called on', async () => {
+        const frames = [datagram(Buffer.from('first')), datagram(Buffer.from('second'))]
+        const packets: PacketData[] = []
+        const retained: (RetainedPacket | undefined)[] = []
+
+        const session = await replay(frames, {}, (session) => {
+            session.on('packet', (packet) => {
+                packets.push(packet)
+                retained.push(packet.retain!())
+            })
+        })
+
+        // The buffers hold the second packet now.
+        expect(packets[0].retain!()).toBeUndefined()
+        expect(retained[0]!.buffer).toEqual(frames[0])
+        expect(retained[1]!.buffer).toEqual(frames[1])
+        expect(retained[1]!.headerView.sequence).toBe(2)
+
+        session.close()
+    })
+
+    it('rejects the handles of the previous packets of a slot', async () => {
+        const retained: RetainedPacket[] = []
+
+        const session = await replay([datagram(Buffer.from('first')), datagram(Buffer.from('second'))], {}, (session) => {
+            session.on('packet', (packet) => {
+                retained[0]?.release()
+                retained.push(packet.retain!()!)
+            })
+        })
+
+        const [first, second] = retained
+
+        // Same slot, another generation.
+        expect(second.handle % 0x100000000).toBe(first.handle % 0x100000000)
+        expect(second.handle).not.toBe(first.handle)
+        expect(() => session.session.release(first.handle)).toThrow('The packet was already released.')
+        expect(session.session.release(second.handle)).toBe(true)
+
+        session.close()
+    })
+
+    it('returns undefined for the packets too large for a slot', async () => {
+        const results: (RetainedPacket | undefined)[] = []
+
+        // Local experimental EtherType, the frame is larger than an IP packet.
+        const jumbo = ethernet(Buffer.alloc(140000), 0x88B5)
+
+        const session = await replay([jumbo, datagram(Buffer.from('small'))], { snapLen: 262144 }, (session) => {
+            session.on('packet', packet => results.push(packet.retain!()))
+        })
+
+        expect(results[0]).toBeUndefined()
+        expect(results[1]!.buffer).toEqual(datagram(Buffer.from('small')))
+
+        session.close()
+    })
+})
@@ -0,0 +1,97 @@
+import { Buffer } from 'node:buffer'
+import { npcap } from '@/npcap'
+import { NpcapSession } from '@/session'
+import { describe, expect, it, vi } from 'vitest'
+import type { Session } from '@/npcap'
+import type { LiveSessionOptions, PacketData } from '@/types'
+
+// Native session replaced by a stub, the test calls the packet callback itself.
+function stubbed(options: LiveSessionOptions) {
+    const native = {
+        onPacket: undefined as unknown as (...header: number[]) => void,
+        matches: undefined as Buffer | undefined,
+        headerArgs: false,
+    }
+
+    const stub: Partial<Session> = {
+        openOffline: (_device, onPacket) => {
+            native.onPacket = onPacket
+            return 'LINKTYPE_ETHERNET'
+        },
+        setPatterns: (_patterns, matches) => {
+            native.matches = matches
+            return true
+        },
+        setHeaderArgs: (enabled) => {
+            native.headerArgs = enabled
+            return true
+        },
+        setEnd: () => true,
+    }
+
+    const Session = npcap.Session
+
+    npcap.Session = function () {
+        return stub
+    } as unknown as typeof npcap.Session
+
+    try {
+        return { session: new NpcapSession(false, 'capture.pcap', options), native }
+    }
+    finally {
+        npcap.Session = Session
+    }
+}
+
+describe('npcapSession', () => {
+    it('calls onPacket directly with the header fields', () => {
+        const handler = vi.fn()
+        const { session, native } = stubbed({ onPacket: handler })
+        const emit = session.emit = vi.fn()
+
+        native.onPacket(2 ** 32 + 5, 123456, 60, 1514)
+
+        expect(native.headerArgs).toBe(true)
+        expect(emit).toHaveBeenCalledTimes(0)
+        expect(handler).toHaveBeenCalledTimes(1)
+
+        const [packet, tvSec, tvUsec, caplen, len] = handler.mock.calls[0]
+
+        expect(packet.buffer).toBe(session.buffer)
+        expect([tvSec, tvUsec, caplen, len]).toEqual([2 ** 32 + 5, 123456, 60, 1514])
+    })
+
+    it('reuses the packet and the matches views', () => {
+        const views: Uint32Array[] = []
+        const handler = vi.fn((packet: PacketData) => views.push(packet.matches!))
+        const { native } = stubbed({ onPacket: handler, patterns: ['GET', 'POST', 'HTTP'] })
+        const matches = new Uint32Array(native.matches!.buffer, native.matches!.byteOffset, 4)
+
+        matches.set([2, 2, 0])
+        native.onPacket(1, 0, 60, 60)
+
+        matches.set([1, 1])
+        native.onPacket(2, 0, 60, 60)
+
+        matches.set([2, 0, 2])
+        native.onPacket(3, 0, 60, 60)
+
+        const [first, second, third] = handler.mock.calls.map(([packet]) => packet)
+
+        expect(first).toBe(second)
+        expect(second).toBe(third)
+        expect(views[1]).toHaveLength(1)
+        expect([...views[2]]).toEqual([0, 2])
+
+        // The views are created once per count.
+        expect(views[0]).toBe(views[2])
+    })
+
+    it('rejects the patterns in batch mode', () => {
+        expect(() => stubbed({ batch: {}, patterns: ['GET'] })).toThrow('The `patterns` option can\'t be used with `batch`')
+    })
+
+    it('rejects the DNS records in batch mode', () => {
+        expect(() => stubbed({ batch: {}, dns: true })).toThrow('The `dns` option can\'t be used with `batch`')
+    })
+})
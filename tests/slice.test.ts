@@ -0,0 +1,57 @@
+import { Buffer } from 'node:buffer'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, pcapPath, readPcap, replay, tcp, TCP_ACK, TCP_PSH, udp } from './pcap'
+import type { Frame } from './pcap'
+import type { OfflineSessionOptions } from '@/types'
+
+function segment(payload: string) {
+    return ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, tcp({ sport: 50000, dport: 80, flags: TCP_ACK | TCP_PSH }, Buffer.from(payload))))
+}
+
+// Delivered bytes and `caplen` of each packet, with the frames saved to `outFile`.
+async function slice(frames: (Buffer | Frame)[], options: OfflineSessionOptions) {
+    const packets: { data: Buffer, caplen: number }[] = []
+    const outFile = pcapPath()
+
+    const session = await replay(frames, { ...options, outFile }, (session) => {
+        session.on('packet', (packet) => {
+            const caplen = packet.headerView!.caplen
+
+            packets.push({ data: Buffer.from(packet.buffer.subarray(0, caplen)), caplen })
+        })
+    })
+
+    // The dump file is flushed when the session closes.
+    session.close()
+
+    return { packets, saved: readPcap(outFile).map(frame => frame.data) }
+}
+
+describe('sliceLength', () => {
+    it('delivers the headers and saves the full frame', async () => {
+        const frame = segment('GET / HTTP/1.1\r\nHost: example.com\r\n\r\n')
+        const { packets, saved } = await slice([frame], { sliceLength: 'headers' })
+
+        // Ethernet, IPv4 and TCP headers.
+        expect(packets).toEqual([{ data: frame.subarray(0, 54), caplen: 54 }])
+        expect(saved).toEqual([frame])
+    })
+
+    it('delivers the packets that can\'t be parsed in full', async () => {
+        const arp = ethernet(Buffer.alloc(28), 0x0806)
+        const frame = segment('payload')
+        const cut = { data: frame.subarray(0, 44), len: frame.length }
+        const { packets } = await slice([arp, cut], { sliceLength: 'headers' })
+
+        expect(packets.map(packet => packet.caplen)).toEqual([arp.length, 44])
+    })
+
+    it('cuts the packets at a fixed length', async () => {
+        const frame = segment('payload')
+        const { packets, saved } = await slice([frame, ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 17 }, udp({ sport: 53, dport: 5353 }, Buffer.alloc(0))))], { sliceLength: 40 })
+
+        expect(packets.map(packet => packet.caplen)).toEqual([40, 40])
+        expect(packets[0].data).toEqual(frame.subarray(0, 40))
+        expect(saved[0]).toEqual(frame)
+    })
+})
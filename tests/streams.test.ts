@@ -0,0 +1,92 @@
+import { Buffer } from 'node:buffer'
+import { createOfflineSession } from '@/index'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, replay, tcp, TCP_ACK, TCP_FIN, TCP_PSH, TCP_SYN, writePcap } from './pcap'
+import type { StreamChunk, StreamOptions } from '@/types'
+
+// Segment of the client (10.0.0.1:50000), its first byte of data is at the sequence number 1001.
+function client(offset: number, payload: string, flags = TCP_ACK | TCP_PSH) {
+    return ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, tcp({ sport: 50000, dport: 80, seq: 1001 + offset, flags }, Buffer.from(payload))))
+}
+
+function server(offset: number, payload: string, flags = TCP_ACK | TCP_PSH) {
+    return ethernet(ipv4({ saddr: '10.0.0.2', daddr: '10.0.0.1', protocol: 6 }, tcp({ sport: 80, dport: 50000, seq: 5001 + offset, flags }, Buffer.from(payload))))
+}
+
+const syn = ethernet(ipv4({ saddr: '10.0.0.1', daddr: '10.0.0.2', protocol: 6 }, tcp({ sport: 50000, dport: 80, seq: 1000, flags: TCP_SYN })))
+
+async function chunks(frames: Buffer[], options: StreamOptions = {}) {
+    const chunks: StreamChunk[] = []
+
+    const session = await replay(frames, { streams: options }, (session) => {
+        session.on('stream', chunk => chunks.push(chunk))
+    })
+
+    session.close()
+
+    return chunks.map(({ sport, offset, gap, end, data }) => ({ sport, offset, gap, end, data: data.toString() }))
+}
+
+describe('streams', () => {
+    it('delivers the segments in order', async () => {
+        expect(await chunks([syn, client(5, 'world'), client(0, 'hello')])).toEqual([
+            { sport: 50000, offset: 0, gap: 0, end: false, data: 'helloworld' },
+            { sport: 50000, offset: 10, gap: 0, end: true, data: '' },
+        ])
+    })
+
+    it('drops the retransmitted bytes', async () => {
+        expect(await chunks([syn, client(0, 'hello'), client(0, 'hello'), client(3, 'lowor'), client(5, 'world!')])).toEqual([
+            { sport: 50000, offset: 0, gap: 0, end: false, data: 'helloworld!' },
+            { sport: 50000, offset: 11, gap: 0, end: true, data: '' },
+        ])
+    })
+
+    it('reports the holes given up as gaps', async () => {
+        expect(await chunks([syn, client(0, 'hello'), client(20, 'again'), client(30, 'more!')], { maxBuffered: 8 })).toEqual([
+            { sport: 50000, offset: 0, gap: 0, end: false, data: 'hello' },
+            { sport: 50000, offset: 20, gap: 15, end: false, data: 'again' },
+            { sport: 50000, offset: 30, gap: 5, end: true, data: 'more!' },
+        ])
+    })
+
+    it('delivers the data past a hole at the end of the file', async () => {
+        expect(await chunks([syn, client(0, 'hello'), client(20, 'again')])).toEqual([
+            { sport: 50000, offset: 0, gap: 0, end: false, data: 'hello' },
+            { sport: 50000, offset: 20, gap: 15, end: true, data: 'again' },
+        ])
+    })
+
+    it('ends each direction once', async () => {
+        const frames = [syn, client(0, 'ping'), server(0, 'pong'), client(4, '', TCP_FIN | TCP_ACK), server(4, 'late')]
+
+        expect(await chunks(frames)).toEqual([
+            { sport: 50000, offset: 0, gap: 0, end: true, data: 'ping' },
+            { sport: 80, offset: 0, gap: 0, end: false, data: 'ponglate' },
+            { sport: 80, offset: 8, gap: 0, end: true, data: '' },
+        ])
+    })
+
+    it('ends the open streams when the session is closed', async () => {
+        const session = createOfflineSession(writePcap([syn, client(0, 'hello'), client(5, 'world')]), { streams: true })
+        const received: StreamChunk[] = []
+
+        session.on('stream', chunk => received.push(chunk))
+
+        await new Promise<void>((resolve) => {
+            let packets = 0
+
+            session.on('packet', () => {
+                if (++packets === 2) {
+                    session.close()
+                    resolve()
+                }
+            })
+        })
+
+        expect(received.map(({ offset, end, data }) => ({ offset, end, data: data.toString() }))).toEqual([
+            { offset: 0, end: false, data: 'hello' },
+            { offset: 5, end: true, data: '' },
+        ])
+    })
+})
@@ -0,0 +1,54 @@
+import { Buffer } from 'node:buffer'
+import { decode } from '@/decode'
+import { TCPTracker } from '@/tcp-tracker'
+import { describe, expect, it } from 'vitest'
+import { ethernet, ipv4, TCP_ACK, TCP_FIN, TCP_SYN, tcp } from './pcap'
+import type { TCPSession } from '@/tcp-tracker'
+
+function segment(from: 'client' | 'server', flags: number, seq: number, ack = 0, payload?: Buffer) {
+    const client = { addr: '10.0.0.2', port: 50144 }
+    const server = { addr: '10.0.0.1', port: 443 }
+    const [src, dst] = from === 'client' ? [client, server] : [server, client]
+    const buffer = ethernet(ipv4({ saddr: src.addr, daddr: dst.addr, protocol: 6 }, tcp({ sport: src.port, dport: dst.port, seq, ack, flags }, payload)))
+    const header = Buffer.alloc(16)
+
+    header.writeUInt32LE(1700000000, 0)
+    header.writeUInt32LE(buffer.length, 8)
+    header.writeUInt32LE(buffer.length, 12)
+
+    return decode({ linkType: 'LINKTYPE_ETHERNET', buffer, header })
+}
+
+describe('tCPTracker', () => {
+    it('tracks both directions in one session until its end', () => {
+        const tracker = new TCPTracker()
+        const sessions: TCPSession[] = []
+        const data: string[] = []
+
+        tracker.on('session', (session: TCPSession) => {
+            sessions.push(session)
+            session.on('data-send', (_, buffer: Buffer) => data.push(`send ${buffer}`))
+            session.on('data-recv', (_, buffer: Buffer) => data.push(`recv ${buffer}`))
+        })
+
+        tracker.trackPacket(segment('client', TCP_SYN, 100))
+        tracker.trackPacket(segment('server', TCP_SYN | TCP_ACK, 500, 101))
+        tracker.trackPacket(segment('client', TCP_ACK, 101, 501))
+
+        expect(sessions).toHaveLength(1)
+        expect(sessions[0].state).toBe('ESTAB')
+        expect(sessions[0].src).toBe('10.0.0.2:50144')
+        expect(tracker.size).toBe(1)
+
+        tracker.trackPacket(segment('client', TCP_ACK, 101, 501, Buffer.from('ping')))
+        tracker.trackPacket(segment('server', TCP_ACK, 501, 105, Buffer.from('pong')))
+        tracker.trackPacket(segment('client', TCP_FIN | TCP_ACK, 105, 505))
+        tracker.trackPacket(segment('server', TCP_FIN | TCP_ACK, 505, 106))
+        tracker.trackPacket(segment('client', TCP_ACK, 106, 506))
+
+        expect(data).toEqual(['send ping', 'recv pong'])
+        expect(sessions[0].state).toBe('CLOSED')
+        expect(tracker.size).toBe(0)
+        expect(tracker.sessions.size).toBe(0)
+    })
+})
@@ -0,0 +1,94 @@
+import { Buffer } from 'node:buffer'
+import { PacketView } from '@/view'
+import { describe, expect, it } from 'vitest'
+
+// Ethernet / VLAN 10 / IPv4 / TCP (PSH, ACK) with 4 bytes of data.
+const tcpFrame = Buffer.from(
+    '00112233445566778899aabb8100000a0800'
+    + '4500002c1234400040060000c0a8000663b55105'
+    + 'c3e001bb00000001000000025018faf000000000'
+    + 'deadbeef',
+    'hex',
+)
+
+// Raw IPv6 / UDP with 4 bytes of data.
+const udpPacket = Buffer.from(
+    '60000000000c1140'
+    + '20010db8000000000000000000000001'
+    + '20010db8000000000000000000000002'
+    + '04d2162e000c0000'
+    + 'cafebabe',
+    'hex',
+)
+
+describe('packetView', () => {
+    it('reads the layers of an Ethernet frame', () => {
+        const view = new PacketView('LINKTYPE_ETHERNET').set(tcpFrame)
+
+        expect(view.isEthernet()).toBe(true)
+        expect(view.ethernet.dhost).toBe('00:11:22:33:44:55')
+        expect(view.ethernet.shost).toBe('66:77:88:99:aa:bb')
+        expect(view.ethernet.vlan).toBe(10)
+        expect(view.ethernet.type).toBe(0x0800)
+
+        expect(view.isIPv4()).toBe(true)
+        expect(view.isIPv6()).toBe(false)
+        expect(view.ipv4.offset).toBe(18)
+        expect(view.ipv4.saddr).toBe('192.168.0.6')
+        expect(view.ipv4.daddr4).toBe(0x63B55105)
+        expect(view.ipv4.doNotFragment).toBe(true)
+        expect(view.ipv4.ttl).toBe(64)
+
+        expect(view.isTcp()).toBe(true)
+        expect(view.isUdp()).toBe(false)
+        expect(view.tcp.sport).toBe(50144)
+        expect(view.tcp.dport).toBe(443)
+        expect(view.tcp.ackno).toBe(2)
+        expect(view.tcp.ack).toBe(true)
+        expect(view.tcp.psh).toBe(true)
+        expect(view.tcp.syn).toBe(false)
+        expect(view.tcp.data.toString('hex')).toBe('deadbeef')
+    })
+
+    it('re-points the same views at the next packet', () => {
+        const view = new PacketView('LINKTYPE_ETHERNET').set(tcpFrame)
+        const tcp = view.tcp
+
+        view.linkType = 'LINKTYPE_RAW'
+        view.set(udpPacket)
+
+        expect(view.tcp).toBe(tcp)
+        expect(view.isEthernet()).toBe(false)
+        expect(view.isIPv4()).toBe(false)
+        expect(view.isTcp()).toBe(false)
+        expect(view.isIPv6()).toBe(true)
+        expect(view.ipv6.saddr).toBe('2001:0db8:0000:0000:0000:0000:0000:0001')
+        expect(view.ipv6.protocol).toBe(17)
+        expect(view.isUdp()).toBe(true)
+        expect(view.udp.sport).toBe(1234)
+        expect(view.udp.dport).toBe(5678)
+        expect(view.udp.data.toString('hex')).toBe('cafebabe')
+    })
+
+    it('stops at the captured length', () => {
+        const view = new PacketView('LINKTYPE_ETHERNET').set(tcpFrame, 30)
+
+        expect(view.isEthernet()).toBe(true)
+        expect(view.isIPv4()).toBe(false)
+        expect(view.isTcp()).toBe(false)
+    })
+
+    it('keeps a clone after the buffer is reused', () => {
+        const buffer = Buffer.from(tcpFrame)
+        const view = new PacketView('LINKTYPE_ETHERNET').set(buffer)
+        const copy = view.clone()
+
+        buffer.fill(0)
+        view.set(buffer)
+
+        expect(view.isIPv4()).toBe(false)
+        expect(copy.isTcp()).toBe(true)
+        expect(copy.ipv4.saddr).toBe('192.168.0.6')
+        expect(copy.tcp.dport).toBe(443)
+    })
+})